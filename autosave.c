@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "autosave.h"
+#include "board.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "save_format.h"
+
+#define JOURNAL_HEADER_BYTES 12
+#define JOURNAL_RECORD_BYTES 12
+
+static const uint8_t journalMagic[4] = { 'S', 'M', 'J', 'L' };
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void closeJournal(Autosave *autosave) {
+	if (autosave->journal) fclose(autosave->journal);
+	autosave->journal = NULL;
+}
+
+bool writeAutosaveSnapshot(Autosave *autosave, GameState *state) {
+	settlePlayTime(state);
+	uint8_t *snapshot = (uint8_t*)malloc(encodedGameStateSize(state));
+	if (!snapshot) return false;
+	size_t size = encodeGameState(state, snapshot);
+	uint32_t crc = crc32Bytes(snapshot, size);
+	closeJournal(autosave);
+	bool written = writeFileAtomically(autosave->savePath, snapshot, size);
+	free(snapshot);
+	if (!written) return false;
+
+	// Only after the new snapshot is in place does the old journal go away; until then
+	// it still matches (and extends) the previous snapshot.
+	uint8_t header[JOURNAL_HEADER_BYTES];
+	memcpy(header, journalMagic, sizeof(journalMagic));
+	put32(header + 4, (uint32_t)size);
+	put32(header + 8, crc);
+	autosave->journal = fopen(autosave->journalPath, "wb");
+	autosave->records = 0;
+	if (!autosave->journal) return false;
+	if (fwrite(header, 1, sizeof(header), autosave->journal) != sizeof(header) || !syncFile(autosave->journal)) {
+		closeJournal(autosave);
+		return false;
+	}
+	return true;
+}
+
+bool startAutosave(Autosave *autosave, GameState *state, const char *savePath) {
+	memset(autosave, 0, sizeof(*autosave));
+	if (savePath) snprintf(autosave->savePath, sizeof(autosave->savePath), "%s", savePath);
+	else gameSavePath(state, autosave->savePath, sizeof(autosave->savePath));
+	saveJournalPath(autosave->savePath, autosave->journalPath, sizeof(autosave->journalPath));
+	return writeAutosaveSnapshot(autosave, state);
+}
+
+// Records are flushed to the OS but not synced: a process crash loses nothing, and a
+// power loss loses at most the moves since the last snapshot, which is synced.
+bool journalMove(Autosave *autosave, GameState *state, JournalOp op, const Move *move) {
+	if (!autosave->journal) return false;
+	uint8_t record[JOURNAL_RECORD_BYTES];
+	record[0] = (uint8_t)op;
+	record[1] = (uint8_t)((move->row << 4) | move->col);
+	record[2] = (uint8_t)((move->previousValue << 4) | move->newValue);
+	record[3] = (uint8_t)state->nextHintIndex;
+	put32(record + 4, elapsedPlaySeconds(state));
+	put32(record + 8, crc32Bytes(record, 8));
+	if (fwrite(record, 1, sizeof(record), autosave->journal) != sizeof(record) || fflush(autosave->journal) != 0) {
+		closeJournal(autosave);
+		return false;
+	}
+	if (++autosave->records >= JOURNAL_COMPACT_RECORDS) return writeAutosaveSnapshot(autosave, state);
+	return true;
+}
+
+void stopAutosave(Autosave *autosave) {
+	closeJournal(autosave);
+}
+
+static bool sameCell(const Move *m, int row, int col) {
+	return m->row == row && m->col == col;
+}
+
+static bool replayRecord(GameState *state, const uint8_t *record) {
+	if (crc32Bytes(record, 8) != get32(record + 8)) return false;
+	int row = record[1] >> 4, col = record[1] & 0x0F;
+	int previous = record[2] >> 4, value = record[2] & 0x0F;
+	Move expected;
+	switch (record[0]) {
+		case JOURNAL_MOVE:
+			if (row >= GRID_SIZE || col >= GRID_SIZE || value > 9 || state->isFixed[row][col]) return false;
+			if (boardGet(&state->currentGrid, row, col) != previous) return false;
+			if (!playMove(state, row, col, value)) return false;
+			break;
+		case JOURNAL_UNDO:
+			if (!historyPeekUndo(&state->history, &expected) || !sameCell(&expected, row, col)) return false;
+			undoMove(state, NULL);
+			break;
+		case JOURNAL_REDO:
+			if (!historyPeekRedo(&state->history, &expected) || !sameCell(&expected, row, col)) return false;
+			redoMove(state, NULL);
+			break;
+		case JOURNAL_BRANCH:
+			if (!historyNextBranch(&state->history, &expected) || !sameCell(&expected, row, col)) return false;
+			break;
+		default:
+			return false;
+	}
+	state->nextHintIndex = record[3];
+	state->elapsedSeconds = get32(record + 4);
+	return true;
+}
+
+bool loadAutosave(GameState *state, const char *savePath) {
+	size_t size;
+	uint8_t *snapshot = readWholeFile(savePath, &size);
+	if (!snapshot) return false;
+	bool decoded = decodeGameState(snapshot, size, state);
+	uint32_t crc = crc32Bytes(snapshot, size);
+	free(snapshot);
+	if (!decoded) return false;
+
+	char journalPath[330];
+	saveJournalPath(savePath, journalPath, sizeof(journalPath));
+	FILE *journal = fopen(journalPath, "rb");
+	if (!journal) return true;
+	uint8_t header[JOURNAL_HEADER_BYTES];
+	bool matches = fread(header, 1, sizeof(header), journal) == sizeof(header)
+		&& memcmp(header, journalMagic, sizeof(journalMagic)) == 0
+		&& get32(header + 4) == (uint32_t)size
+		&& get32(header + 8) == crc;
+	uint8_t record[JOURNAL_RECORD_BYTES];
+	while (matches && fread(record, 1, sizeof(record), journal) == sizeof(record)) {
+		if (!replayRecord(state, record)) break;
+	}
+	fclose(journal);
+	return true;
+}
@@ -0,0 +1,47 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "structs.h"
+
+// Snapshot + journal autosave. The snapshot is an ordinary save (saves/<name>.sav)
+// replaced atomically; every move after it is appended to saves/<name>.jnl as a
+// 12-byte checksummed record. The journal header names the snapshot it extends (by
+// size and CRC), so a journal left behind by a crash during compaction is ignored
+// instead of being replayed twice.
+#define JOURNAL_COMPACT_RECORDS 64
+
+typedef enum JournalOp {
+	JOURNAL_MOVE = 1,
+	JOURNAL_UNDO,
+	JOURNAL_REDO,
+	JOURNAL_BRANCH  // redo switched to the next branch (historyNextBranch)
+} JournalOp;
+
+typedef struct Autosave {
+	char savePath[320];
+	char journalPath[330];
+	FILE *journal;
+	int records; // appended since the last snapshot
+} Autosave;
+
+// Writes the first snapshot for a game to savePath (NULL for saves/<puzzle>.sav) and
+// starts an empty journal next to it.
+bool startAutosave(Autosave *autosave, GameState *state, const char *savePath);
+
+// Appends one record after op has been applied to state; move is the move played,
+// undone or redone, or the new redo move for JOURNAL_BRANCH. Compacts into a new snapshot
+// every JOURNAL_COMPACT_RECORDS records.
+bool journalMove(Autosave *autosave, GameState *state, JournalOp op, const Move *move);
+
+// Replaces the snapshot with state and empties the journal. The play time is settled
+// first (settlePlayTime), since the journal that carried it is discarded.
+bool writeAutosaveSnapshot(Autosave *autosave, GameState *state);
+
+void stopAutosave(Autosave *autosave);
+
+// Loads a save and replays its journal, stopping at the first torn or corrupt record.
+bool loadAutosave(GameState *state, const char *savePath);
+
+#endif
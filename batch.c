@@ -0,0 +1,472 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "batch.h"
+#include "board.h"
+#include "canonical.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "generator.h"
+#include "grader.h"
+#include "puzzle_pack.h"
+#include "solution_cache.h"
+#include "sys_thread.h"
+#include "work_pool.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+#define CHUNK_LINES 64
+#define CHUNKS_PER_THREAD 8
+#define SOURCE_LINE_MAX 192
+#define SEEN_INITIAL_SLOTS ((size_t)1 << 20)
+
+// A run of consecutive input puzzles solved by one worker. Text input is copied into
+// lines; pack input is referenced in place as records [firstRecord, firstRecord + count).
+// Chunks live in a ring (the reorder buffer) indexed by sequence number; the reading
+// thread writes them out strictly in sequence order and refills each slot once it has
+// been written.
+typedef struct BatchChunk {
+	int count;
+	const PuzzlePack *pack;
+	unsigned long long firstRecord;
+	char lines[CHUNK_LINES][82];
+	size_t lengths[CHUNK_LINES];
+	char sources[CHUNK_LINES][SOURCE_LINE_MAX]; // whole input lines, kept in dedupe mode
+	size_t sourceLengths[CHUNK_LINES];
+	BoardKey keys[CHUNK_LINES];                 // dedupe mode: canonical fingerprint, lo 0 to drop
+	char output[CHUNK_LINES * BATCH_RESULT_MAX];
+	size_t outputLength;
+	BatchTotals totals;
+	atomic_int done;
+} BatchChunk;
+
+// Where chunks are filled from: a text LineReader, or a mapped pack when pack is set.
+typedef struct BatchSource {
+	LineReader reader;
+	PuzzlePack packFile;
+	const PuzzlePack *pack;
+	unsigned long long nextRecord;
+	bool keepLines;
+} BatchSource;
+
+// 128-bit fingerprints of the canonical forms written so far, in an open-addressing table
+// with linear probing on the low half. Both halves must match for a duplicate, so two
+// different puzzles are practically never merged. It doubles as it fills, up to maxSlots;
+// lo 0 marks an empty slot.
+typedef struct SeenSet {
+	BoardKey *slots;
+	size_t capacity;
+	size_t count;
+	size_t maxSlots;
+} SeenSet;
+
+typedef struct ParallelBatch {
+	const BatchOptions *options;
+	SeenSet *seen;
+	SysMutex doneLock;
+	SysCond doneCond;
+} ParallelBatch;
+
+static bool isSkippableLine(const char *line, size_t len) {
+	return len == 0 || line[0] == '#';
+}
+
+// Puzzle-file lines (name|difficulty|digits) are accepted as well as bare digit lines.
+static const char *puzzleDigits(const char *line, size_t *len) {
+	for (size_t i = *len; i > 0; i--) {
+		if (line[i - 1] == '|') {
+			*len -= i;
+			return line + i;
+		}
+	}
+	return line;
+}
+
+// Folds one search into the totals; without SOLVER_STATS there is nothing to keep.
+static void addSearchCost(BatchTotals *totals, const SolverStats *stats) {
+#if SOLVER_STATS_ENABLED
+	addSolverStats(&totals->search, stats);
+	int bucket = 0;
+	for (unsigned long long nodes = stats->nodes; nodes > 0 && bucket < BATCH_COST_BUCKETS - 1; nodes >>= 1) bucket++;
+	totals->costHistogram[bucket]++;
+#else
+	(void)totals;
+	(void)stats;
+#endif
+}
+
+static size_t solveBatchBoard(Board *board, bool valid, const BatchOptions *options, char *out, BatchTotals *totals) {
+	totals->lines++;
+	if (!valid || !isBoardConsistent(board)) {
+		totals->invalid++;
+		memcpy(out, "invalid\n", 8);
+		return 8;
+	}
+	if (options->grade) {
+		GradeResult grade;
+		if (!gradeLogically(board, &grade)) {
+			totals->unsolvable++;
+			memcpy(out, "unsolvable\n", 11);
+			return 11;
+		}
+		if (grade.solved) totals->solved++;
+		else totals->unsolvable++;
+		return (size_t)snprintf(out, BATCH_RESULT_MAX, "%s|%s\n", difficultyNames[grade.level],
+			grade.solved ? (grade.hardest >= 0 ? techniqueName((Technique)grade.hardest) : "none") : "guessing");
+	}
+	if (options->countLimit > 0) {
+		SolverStats stats;
+		int count = countSolutionsStats(board, options->countLimit, &stats);
+		addSearchCost(totals, &stats);
+		if (count == 0) totals->unsolvable++;
+		else totals->solved++;
+		if (count > 1) totals->multiple++;
+		return (size_t)snprintf(out, BATCH_RESULT_MAX, "%d\n", count);
+	}
+	SolverStats stats;
+	bool solved = solveSudokuCached(board, options->strategy, &stats);
+	addSearchCost(totals, &stats);
+	if (!solved) {
+		totals->unsolvable++;
+		memcpy(out, "unsolvable\n", 11);
+		return 11;
+	}
+	totals->solved++;
+	formatGrid81(board, out);
+	out[81] = '\n';
+	return 82;
+}
+
+// The fingerprint of the puzzle's canonical form, or one with lo 0 when the puzzle is
+// dropped for being malformed, contradictory, unsolvable or not uniquely solvable.
+static BoardKey dedupeKey(const Board *board, bool valid, BatchTotals *totals) {
+	BoardKey dropped = { 0, 0 };
+	totals->lines++;
+	if (!valid || !isBoardConsistent(board)) {
+		totals->invalid++;
+		return dropped;
+	}
+	SolverStats stats;
+	int count = countSolutionsStats(board, 2, &stats);
+	addSearchCost(totals, &stats);
+	if (count == 0) {
+		totals->unsolvable++;
+		return dropped;
+	}
+	if (count > 1) {
+		totals->multiple++;
+		return dropped;
+	}
+	totals->solved++;
+	Board canonical;
+	canonicalizeBoard(board, &canonical, NULL);
+	BoardKey key = hashBoardKey(&canonical);
+	if (!key.lo) key.lo = 1;
+	return key;
+}
+
+size_t solveBatchLine(const char *line, size_t len, const BatchOptions *options, char *out, BatchTotals *totals) {
+	Board board;
+	line = puzzleDigits(line, &len);
+	bool valid = len >= 81 && parseGrid81(line, &board);
+	return solveBatchBoard(&board, valid, options, out, totals);
+}
+
+static void printBatchSummary(const BatchTotals *totals, double seconds) {
+	fprintf(stderr, "Processed %llu puzzles: %llu solved, %llu unsolvable, %llu invalid",
+		totals->lines, totals->solved, totals->unsolvable, totals->invalid);
+	if (totals->multiple) fprintf(stderr, ", %llu with multiple solutions", totals->multiple);
+	fprintf(stderr, " in %.2fs", seconds);
+	if (seconds > 0.0) fprintf(stderr, " (%.0f puzzles/s)", (double)totals->lines / seconds);
+	fprintf(stderr, "\n");
+#if SOLVER_STATS_ENABLED
+	if (totals->search.solves == 0) return;
+	char summary[192];
+	formatSolverStats(&totals->search, summary, sizeof(summary));
+	fprintf(stderr, "Search over %llu puzzles (times are CPU time summed over threads): %s\n", totals->search.solves, summary);
+	fprintf(stderr, "Nodes per puzzle:\n");
+	for (int i = 0; i < BATCH_COST_BUCKETS; i++) {
+		if (totals->costHistogram[i] == 0) continue;
+		double share = 100.0 * (double)totals->costHistogram[i] / (double)totals->search.solves;
+		unsigned long long low = i == 0 ? 0 : 1ULL << (i - 1), high = i == 0 ? 0 : (1ULL << i) - 1;
+		if (low == high) fprintf(stderr, "  %21llu", low);
+		else if (i == BATCH_COST_BUCKETS - 1) fprintf(stderr, "  %10llu %-10s", low, "or more");
+		else fprintf(stderr, "  %10llu - %-8llu", low, high);
+		fprintf(stderr, " %10llu  %5.1f%%\n", totals->costHistogram[i], share);
+	}
+#endif
+}
+
+static void addTotals(BatchTotals *into, const BatchTotals *from) {
+	into->lines += from->lines;
+	into->solved += from->solved;
+	into->unsolvable += from->unsolvable;
+	into->invalid += from->invalid;
+	into->multiple += from->multiple;
+	into->duplicates += from->duplicates;
+	into->unchecked += from->unchecked;
+#if SOLVER_STATS_ENABLED
+	addSolverStats(&into->search, &from->search);
+	for (int i = 0; i < BATCH_COST_BUCKETS; i++) into->costHistogram[i] += from->costHistogram[i];
+#endif
+}
+
+static void solveChunkItems(BatchChunk *chunk, const BatchOptions *options) {
+	size_t used = 0;
+	memset(&chunk->totals, 0, sizeof(chunk->totals));
+	for (int i = 0; i < chunk->count; i++) {
+		if (options->dedupe) {
+			Board board;
+			bool valid = true;
+			if (chunk->pack) unpackBoard(&chunk->pack->records[chunk->firstRecord + i].grid, &board);
+			else valid = chunk->lengths[i] >= 81 && parseGrid81(chunk->lines[i], &board);
+			chunk->keys[i] = dedupeKey(&board, valid, &chunk->totals);
+		} else if (chunk->pack) {
+			Board board;
+			unpackBoard(&chunk->pack->records[chunk->firstRecord + i].grid, &board);
+			used += solveBatchBoard(&board, true, options, chunk->output + used, &chunk->totals);
+		} else {
+			used += solveBatchLine(chunk->lines[i], chunk->lengths[i], options, chunk->output + used, &chunk->totals);
+		}
+	}
+	chunk->outputLength = used;
+}
+
+static void solveChunk(void *item, void *context) {
+	BatchChunk *chunk = (BatchChunk*)item;
+	ParallelBatch *batch = (ParallelBatch*)context;
+	solveChunkItems(chunk, batch->options);
+	atomic_store(&chunk->done, 1);
+	lockMutex(&batch->doneLock);
+	broadcastCond(&batch->doneCond);
+	unlockMutex(&batch->doneLock);
+}
+
+// Fills the next chunk from the source; returns false once the input is exhausted.
+static bool fillChunk(BatchSource *source, BatchChunk *chunk) {
+	chunk->count = 0;
+	chunk->pack = source->pack;
+	if (source->pack) {
+		unsigned long long left = packCount(source->pack) - source->nextRecord;
+		chunk->firstRecord = source->nextRecord;
+		chunk->count = left < CHUNK_LINES ? (int)left : CHUNK_LINES;
+		source->nextRecord += (unsigned long long)chunk->count;
+		return chunk->count > 0;
+	}
+	char *line;
+	size_t len;
+	while (chunk->count < CHUNK_LINES && (line = readNextLine(&source->reader, &len)) != NULL) {
+		if (isSkippableLine(line, len)) continue;
+		if (source->keepLines) {
+			// Lines too long to copy back out are dropped as malformed.
+			if (len >= SOURCE_LINE_MAX) len = 0;
+			memcpy(chunk->sources[chunk->count], line, len);
+			chunk->sourceLengths[chunk->count] = len;
+		}
+		const char *digits = puzzleDigits(line, &len);
+		size_t keep = len < 81 ? len : 81;
+		memcpy(chunk->lines[chunk->count], digits, keep);
+		chunk->lines[chunk->count][keep] = '\0';
+		chunk->lengths[chunk->count] = keep;
+		chunk->count++;
+	}
+	return chunk->count > 0;
+}
+
+static bool initSeenSet(SeenSet *seen, size_t maxBytes) {
+	seen->maxSlots = maxBytes / sizeof(BoardKey);
+	seen->capacity = 1024; // a power of two, as probing masks with capacity - 1
+	while (seen->capacity < SEEN_INITIAL_SLOTS && seen->capacity * 2 <= seen->maxSlots) seen->capacity *= 2;
+	seen->count = 0;
+	seen->slots = (BoardKey*)calloc(seen->capacity, sizeof(BoardKey));
+	return seen->slots != NULL;
+}
+
+static void freeSeenSet(SeenSet *seen) {
+	free(seen->slots);
+	seen->slots = NULL;
+}
+
+static bool growSeenSet(SeenSet *seen) {
+	size_t capacity = seen->capacity * 2;
+	if (capacity > seen->maxSlots) return false;
+	BoardKey *slots = (BoardKey*)calloc(capacity, sizeof(BoardKey));
+	if (!slots) return false;
+	for (size_t i = 0; i < seen->capacity; i++) {
+		BoardKey key = seen->slots[i];
+		if (!key.lo) continue;
+		size_t at = (size_t)key.lo & (capacity - 1);
+		while (slots[at].lo) at = (at + 1) & (capacity - 1);
+		slots[at] = key;
+	}
+	free(seen->slots);
+	seen->slots = slots;
+	seen->capacity = capacity;
+	return true;
+}
+
+// 1 when key is new, 0 when it was seen before, -1 when the table is full and cannot tell.
+static int insertSeen(SeenSet *seen, BoardKey key) {
+	if (seen->count >= seen->capacity / 4 * 3 && !growSeenSet(seen) && seen->count >= seen->capacity / 16 * 15) {
+		size_t at = (size_t)key.lo & (seen->capacity - 1);
+		for (size_t probes = 0; probes < seen->capacity && seen->slots[at].lo; probes++) {
+			if (seen->slots[at].lo == key.lo && seen->slots[at].hi == key.hi) return 0;
+			at = (at + 1) & (seen->capacity - 1);
+		}
+		return -1;
+	}
+	size_t at = (size_t)key.lo & (seen->capacity - 1);
+	while (seen->slots[at].lo) {
+		if (seen->slots[at].lo == key.lo && seen->slots[at].hi == key.hi) return 0;
+		at = (at + 1) & (seen->capacity - 1);
+	}
+	seen->slots[at] = key;
+	seen->count++;
+	return 1;
+}
+
+// Copies the chunk's surviving input lines to stdout; pack records are written as
+// name|difficulty|digits.
+static void writeDedupedLines(const BatchChunk *chunk, SeenSet *seen, BatchTotals *totals) {
+	for (int i = 0; i < chunk->count; i++) {
+		if (!chunk->keys[i].lo) continue;
+		int added = insertSeen(seen, chunk->keys[i]);
+		if (added == 0) {
+			totals->duplicates++;
+			continue;
+		}
+		if (added < 0) totals->unchecked++;
+		if (chunk->pack) {
+			const PackRecord *record = &chunk->pack->records[chunk->firstRecord + i];
+			Board board;
+			char digits[82];
+			unpackBoard(&record->grid, &board);
+			formatGrid81(&board, digits);
+			printf("%s|%s|%s\n", packRecordName(chunk->pack, record), packRecordDifficulty(chunk->pack, record), digits);
+		} else {
+			fwrite(chunk->sources[i], 1, chunk->sourceLengths[i], stdout);
+			putchar('\n');
+		}
+	}
+}
+
+static void writeChunk(const BatchChunk *chunk, const BatchOptions *options, SeenSet *seen, BatchTotals *totals) {
+	if (options->dedupe) writeDedupedLines(chunk, seen, totals);
+	else fwrite(chunk->output, 1, chunk->outputLength, stdout);
+	addTotals(totals, &chunk->totals);
+}
+
+static void writeChunkInOrder(ParallelBatch *batch, BatchChunk *chunk, BatchTotals *totals) {
+	if (!atomic_load(&chunk->done)) {
+		lockMutex(&batch->doneLock);
+		while (!atomic_load(&chunk->done)) waitCond(&batch->doneCond, &batch->doneLock);
+		unlockMutex(&batch->doneLock);
+	}
+	writeChunk(chunk, batch->options, batch->seen, totals);
+	chunk->count = 0;
+	atomic_store(&chunk->done, 0);
+}
+
+static bool solveBatchParallel(BatchSource *source, const BatchOptions *options, SeenSet *seen, int threads, BatchTotals *totals) {
+	int window = threads * CHUNKS_PER_THREAD;
+	BatchChunk *ring = (BatchChunk*)calloc((size_t)window, sizeof(BatchChunk));
+	if (!ring) return false;
+	ParallelBatch batch;
+	batch.options = options;
+	batch.seen = seen;
+	initMutex(&batch.doneLock);
+	initCond(&batch.doneCond);
+	WorkPool *pool = createWorkPool(threads, window, solveChunk, &batch);
+	if (!pool) {
+		destroyCond(&batch.doneCond);
+		destroyMutex(&batch.doneLock);
+		free(ring);
+		return false;
+	}
+
+	unsigned long long nextSeq = 0, nextToWrite = 0;
+	for (;;) {
+		if (nextSeq - nextToWrite == (unsigned long long)window) {
+			writeChunkInOrder(&batch, &ring[nextToWrite % window], totals);
+			nextToWrite++;
+		}
+		BatchChunk *chunk = &ring[nextSeq % window];
+		if (!fillChunk(source, chunk)) break;
+		submitWork(pool, chunk);
+		nextSeq++;
+	}
+	while (nextToWrite < nextSeq) {
+		writeChunkInOrder(&batch, &ring[nextToWrite % window], totals);
+		nextToWrite++;
+	}
+	destroyWorkPool(pool);
+	destroyCond(&batch.doneCond);
+	destroyMutex(&batch.doneLock);
+	free(ring);
+	return true;
+}
+
+static bool openBatchSource(BatchSource *source, const char *path) {
+	memset(source, 0, sizeof(*source));
+	if (isPuzzlePackFile(path)) {
+		if (!openPuzzlePack(&source->packFile, path)) return false;
+		source->pack = &source->packFile;
+		return true;
+	}
+	return openLineReader(&source->reader, path);
+}
+
+static void closeBatchSource(BatchSource *source) {
+	if (source->pack) closePuzzlePack(&source->packFile);
+	else closeLineReader(&source->reader);
+}
+
+int runSolveBatch(const BatchOptions *options) {
+	BatchSource source;
+	if (!openBatchSource(&source, options->inputPath)) {
+		fprintf(stderr, "Cannot open %s\n", options->inputPath);
+		return 1;
+	}
+	SeenSet seen;
+	memset(&seen, 0, sizeof(seen));
+	if (options->dedupe) {
+		source.keepLines = true;
+		if (!initSeenSet(&seen, options->dedupeMemory ? options->dedupeMemory : BATCH_DEDUPE_MEMORY)) {
+			fprintf(stderr, "Out of memory\n");
+			closeBatchSource(&source);
+			return 1;
+		}
+	}
+	static char outputBuffer[OUTPUT_BUFFER_SIZE];
+	setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+	BatchTotals totals;
+	memset(&totals, 0, sizeof(totals));
+	double start = monotonicSeconds();
+	int threads = options->threads > 0 ? options->threads : getCpuCount();
+	bool parallel = threads > 1 && solveBatchParallel(&source, options, &seen, threads, &totals);
+	if (!parallel) {
+		static BatchChunk chunk;
+		while (fillChunk(&source, &chunk)) {
+			solveChunkItems(&chunk, options);
+			writeChunk(&chunk, options, &seen, &totals);
+		}
+	}
+	fflush(stdout);
+	closeBatchSource(&source);
+	printBatchSummary(&totals, monotonicSeconds() - start);
+	SolutionCacheStats cached = solutionCacheStats();
+	if (cached.hits + cached.misses > 0) {
+		fprintf(stderr, "Solution cache: %llu hits, %llu misses (%.1f%% hit rate), %zu of %zu entries used\n",
+			cached.hits, cached.misses, 100.0 * (double)cached.hits / (double)(cached.hits + cached.misses),
+			cached.entries, cached.capacity);
+	}
+	if (options->dedupe) {
+		fprintf(stderr, "Wrote %llu puzzles, dropped %llu duplicates (%.1f MB table)",
+			totals.solved - totals.duplicates, totals.duplicates, (double)seen.capacity * sizeof(BoardKey) / (1 << 20));
+		if (totals.unchecked) fprintf(stderr, "; the table filled up and %llu were written unchecked", totals.unchecked);
+		fprintf(stderr, "\n");
+		freeSeenSet(&seen);
+	}
+	return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include "solver.h"
+
+typedef struct BatchOptions {
+	const char *inputPath; // text or binary pack (puzzle_pack.h); "-" reads stdin
+	SolverStrategy strategy;
+	int threads;           // 0 uses every CPU; 1 solves on the calling thread
+	int countLimit;        // > 0 writes solution counts (capped at this limit) instead of solutions
+	bool grade;            // writes "difficulty|hardest technique" instead of solutions
+	bool dedupe;           // copies each valid, uniquely solvable puzzle line once per symmetry class
+	size_t dedupeMemory;   // bytes the table of seen puzzles may grow to; 0 for BATCH_DEDUPE_MEMORY
+} BatchOptions;
+
+#define BATCH_DEDUPE_MEMORY ((size_t)1 << 30)
+
+#define BATCH_COST_BUCKETS 20
+
+typedef struct BatchTotals {
+	unsigned long long lines;
+	unsigned long long solved;
+	unsigned long long unsolvable;
+	unsigned long long invalid;
+	unsigned long long multiple;
+	unsigned long long duplicates; // dedupe mode: dropped as equivalent to an earlier puzzle
+	unsigned long long unchecked;  // dedupe mode: written without a check once the table was full
+#if SOLVER_STATS_ENABLED
+	SolverStats search;                                  // summed over solved and counted puzzles
+	unsigned long long costHistogram[BATCH_COST_BUCKETS]; // puzzles by nodes: [0] none, [i] < 2^i, last open-ended
+#endif
+} BatchTotals;
+
+// Writes one result line for a puzzle line (bare digits or name|difficulty|digits) into out, which must hold BATCH_RESULT_MAX bytes:
+// the solution, "unsolvable", "invalid" (malformed or with repeated givens), the solution
+// count in counting mode, or the grade in grading mode ("guessing" when the techniques stall).
+// Returns the number of bytes written.
+#define BATCH_RESULT_MAX 96
+size_t solveBatchLine(const char *line, size_t len, const BatchOptions *options, char *out, BatchTotals *totals);
+
+// Streams puzzles from options->inputPath to stdout, one solution per line, in input order.
+// In dedupe mode the output is the input lines that survive instead, still in order.
+// Returns a process exit code.
+int runSolveBatch(const BatchOptions *options);
+
+#endif
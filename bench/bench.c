@@ -0,0 +1,359 @@
+// Benchmark harness for the solver, validator and file paths. Built and run by
+// `make bench`; see the Makefile. Times every operation individually (or in small
+// batches for sub-microsecond ones) over bench/corpus.txt and reports throughput,
+// p50/p99 latency and solver search nodes, as a table or as JSON for tracking runs
+// across commits.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "structs.h"
+#include "board.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "solver.h"
+#include "sys_thread.h"
+
+#define MAX_CATEGORIES 16
+// Calls per sample for operations too fast to time one at a time.
+#define FAST_BATCH 256
+
+typedef struct CorpusEntry {
+	Puzzle puzzle;
+	Board solution;
+	int category;
+	char line[256];
+} CorpusEntry;
+
+typedef struct Corpus {
+	CorpusEntry *entries;
+	size_t count;
+	char categories[MAX_CATEGORIES][32];
+	int categoryCount;
+	const char *path;
+} Corpus;
+
+typedef struct BenchResult {
+	char name[64];
+	char category[32];
+	unsigned long long ops;
+	double seconds;
+	double *samples;          // nanoseconds per operation
+	size_t sampleCount;
+	size_t sampleCapacity;
+	unsigned long long nodes;
+	bool hasNodes;
+} BenchResult;
+
+typedef struct BenchOptions {
+	const char *corpusPath;
+	const char *only;         // run benchmarks whose name contains this
+	const char *scratchPath;  // save file used by the save/load benchmarks
+	const char *revision;     // recorded in the output, e.g. the commit being measured
+	int repeat;
+	bool json;
+} BenchOptions;
+
+static BenchResult *results;
+static size_t resultCount;
+static size_t resultCapacity;
+
+static BenchResult *beginResult(const char *name, const char *category) {
+	if (resultCount == resultCapacity) {
+		resultCapacity = resultCapacity ? resultCapacity * 2 : 32;
+		results = (BenchResult*)realloc(results, resultCapacity * sizeof(*results));
+		if (!results) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+	BenchResult *r = &results[resultCount++];
+	memset(r, 0, sizeof(*r));
+	snprintf(r->name, sizeof(r->name), "%s", name);
+	snprintf(r->category, sizeof(r->category), "%s", category);
+	return r;
+}
+
+// Records one sample covering ops operations that took seconds in total.
+static void addSample(BenchResult *r, double seconds, unsigned long long ops) {
+	if (r->sampleCount == r->sampleCapacity) {
+		r->sampleCapacity = r->sampleCapacity ? r->sampleCapacity * 2 : 256;
+		r->samples = (double*)realloc(r->samples, r->sampleCapacity * sizeof(*r->samples));
+		if (!r->samples) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+	r->samples[r->sampleCount++] = seconds * 1e9 / (double)ops;
+	r->ops += ops;
+	r->seconds += seconds;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(const BenchResult *r, int p) {
+	if (r->sampleCount == 0) return 0.0;
+	return r->samples[(r->sampleCount - 1) * (size_t)p / 100];
+}
+
+static bool selected(const BenchOptions *options, const char *name) {
+	return !options->only || strstr(name, options->only) != NULL;
+}
+
+static bool loadCorpus(Corpus *corpus, const char *path) {
+	memset(corpus, 0, sizeof(*corpus));
+	corpus->path = path;
+	LineReader reader;
+	if (!openLineReader(&reader, path)) return false;
+	size_t capacity = 0;
+	char *line;
+	size_t len;
+	while ((line = readNextLine(&reader, &len)) != NULL) {
+		if (len == 0 || len >= sizeof(corpus->entries[0].line)) continue;
+		if (corpus->count == capacity) {
+			capacity = capacity ? capacity * 2 : 256;
+			CorpusEntry *grown = (CorpusEntry*)realloc(corpus->entries, capacity * sizeof(*grown));
+			if (!grown) break;
+			corpus->entries = grown;
+		}
+		CorpusEntry *e = &corpus->entries[corpus->count];
+		memcpy(e->line, line, len + 1);
+		char scratch[sizeof(e->line)];
+		memcpy(scratch, line, len + 1);
+		if (!parsePuzzleLine(scratch, &e->puzzle)) continue;
+		e->solution = e->puzzle.grid;
+		if (!solveSudokuWith(&e->solution, SOLVER_DLX, NULL)) {
+			fprintf(stderr, "Skipping unsolvable corpus puzzle %s\n", e->puzzle.name);
+			continue;
+		}
+		int c = 0;
+		while (c < corpus->categoryCount && strcmp(corpus->categories[c], e->puzzle.difficulty) != 0) c++;
+		if (c == corpus->categoryCount) {
+			if (c == MAX_CATEGORIES) continue;
+			snprintf(corpus->categories[c], sizeof(corpus->categories[c]), "%s", e->puzzle.difficulty);
+			corpus->categoryCount++;
+		}
+		e->category = c;
+		corpus->count++;
+	}
+	closeLineReader(&reader);
+	return corpus->count > 0;
+}
+
+static void benchSolve(const Corpus *corpus, const BenchOptions *options) {
+	static const SolverStrategy strategies[] = { SOLVER_BACKTRACK, SOLVER_MRV, SOLVER_DLX, SOLVER_STEPPED };
+	for (int c = 0; c < corpus->categoryCount; c++) {
+		if (selected(options, "solveSudoku")) {
+			BenchResult *r = beginResult("solveSudoku", corpus->categories[c]);
+			for (int round = 0; round < options->repeat; round++) {
+				for (size_t i = 0; i < corpus->count; i++) {
+					if (corpus->entries[i].category != c) continue;
+					Board board = corpus->entries[i].puzzle.grid;
+					double start = monotonicSeconds();
+					solveSudoku(&board);
+					addSample(r, monotonicSeconds() - start, 1);
+				}
+			}
+		}
+		for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+			char name[64];
+			snprintf(name, sizeof(name), "solve/%s", solverStrategyName(strategies[s]));
+			if (!selected(options, name)) continue;
+			BenchResult *r = beginResult(name, corpus->categories[c]);
+			r->hasNodes = true;
+			for (int round = 0; round < options->repeat; round++) {
+				for (size_t i = 0; i < corpus->count; i++) {
+					if (corpus->entries[i].category != c) continue;
+					Board board = corpus->entries[i].puzzle.grid;
+					unsigned long long nodes = 0;
+					double start = monotonicSeconds();
+					solveSudokuWith(&board, strategies[s], &nodes);
+					addSample(r, monotonicSeconds() - start, 1);
+					r->nodes += nodes;
+				}
+			}
+		}
+	}
+}
+
+static volatile int sink;
+
+static void benchValidation(const Corpus *corpus, const BenchOptions *options) {
+	if (selected(options, "isBoardValid")) {
+		BenchResult *r = beginResult("isBoardValid", "solved");
+		for (int round = 0; round < options->repeat; round++) {
+			for (size_t i = 0; i < corpus->count; i++) {
+				const Board *board = &corpus->entries[i].solution;
+				int valid = 0;
+				double start = monotonicSeconds();
+				for (int k = 0; k < FAST_BATCH; k++) valid += isBoardValid(board);
+				addSample(r, monotonicSeconds() - start, FAST_BATCH);
+				sink += valid;
+			}
+		}
+	}
+	if (selected(options, "computePossibilities")) {
+		BenchResult *r = beginResult("computePossibilities", "all cells");
+		for (int round = 0; round < options->repeat; round++) {
+			for (size_t i = 0; i < corpus->count; i++) {
+				const Board *board = &corpus->entries[i].puzzle.grid;
+				int poss[10], total = 0;
+				double start = monotonicSeconds();
+				for (int cell = 0; cell < CELL_COUNT; cell++) {
+					total += computePossibilities(board, cell / GRID_SIZE, cell % GRID_SIZE, poss);
+				}
+				addSample(r, monotonicSeconds() - start, CELL_COUNT);
+				sink += total;
+			}
+		}
+	}
+}
+
+static void benchParsing(const Corpus *corpus, const BenchOptions *options) {
+	if (selected(options, "parseGrid81")) {
+		BenchResult *r = beginResult("parseGrid81", "corpus");
+		for (int round = 0; round < options->repeat; round++) {
+			for (size_t i = 0; i < corpus->count; i++) {
+				const char *digits = strrchr(corpus->entries[i].line, '|');
+				digits = digits ? digits + 1 : corpus->entries[i].line;
+				Board board;
+				int parsed = 0;
+				double start = monotonicSeconds();
+				for (int k = 0; k < FAST_BATCH; k++) parsed += parseGrid81(digits, &board);
+				addSample(r, monotonicSeconds() - start, FAST_BATCH);
+				sink += parsed;
+			}
+		}
+	}
+	if (selected(options, "loadPuzzleByDifficulty")) {
+		for (int c = 0; c < corpus->categoryCount; c++) {
+			BenchResult *r = beginResult("loadPuzzleByDifficulty", corpus->categories[c]);
+			for (int round = 0; round < options->repeat * 16; round++) {
+				Puzzle puzzle;
+				double start = monotonicSeconds();
+				bool found = loadPuzzleByDifficulty(&puzzle, corpus->path, corpus->categories[c]);
+				addSample(r, monotonicSeconds() - start, 1);
+				sink += found;
+			}
+		}
+	}
+}
+
+// A game part-way through the puzzle: every other empty cell filled from the solution.
+static void midGameState(const CorpusEntry *entry, GameState *state) {
+	memset(state, 0, sizeof(*state));
+	snprintf(state->activePuzzleName, sizeof(state->activePuzzleName), "%s", entry->puzzle.name);
+	snprintf(state->activeDifficulty, sizeof(state->activeDifficulty), "%s", entry->puzzle.difficulty);
+	state->currentGrid = entry->puzzle.grid;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		state->isFixed[cell / GRID_SIZE][cell % GRID_SIZE] = entry->puzzle.grid.cells[cell] != 0;
+	}
+	bool play = true;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (entry->puzzle.grid.cells[cell] != 0) continue;
+		if (play) playMove(state, cell / GRID_SIZE, cell % GRID_SIZE, entry->solution.cells[cell]);
+		play = !play;
+	}
+}
+
+static void benchSaves(const Corpus *corpus, const BenchOptions *options) {
+	bool saves = selected(options, "saveGameState"), loads = selected(options, "loadGameState");
+	if (!saves && !loads) return;
+	BenchResult *save = saves ? beginResult("saveGameState", "mid-game") : NULL;
+	BenchResult *load = loads ? beginResult("loadGameState", "mid-game") : NULL;
+	// Every save is synced to disk, so one pass over the corpus is plenty.
+	for (size_t i = 0; i < corpus->count; i++) {
+		GameState state, loaded;
+		midGameState(&corpus->entries[i], &state);
+		double start = monotonicSeconds();
+		bool ok = saveGameState(&state, options->scratchPath);
+		if (save) addSample(save, monotonicSeconds() - start, 1);
+		if (ok && load) {
+			start = monotonicSeconds();
+			if (loadGameState(&loaded, options->scratchPath)) {
+				addSample(load, monotonicSeconds() - start, 1);
+				freeMoveHistory(&loaded.history);
+			}
+		}
+		freeMoveHistory(&state.history);
+	}
+	remove(options->scratchPath);
+}
+
+static void printText(FILE *out) {
+	fprintf(out, "%-24s %-12s %10s %14s %12s %12s %12s\n", "benchmark", "category", "ops", "ops/s", "p50 ns", "p99 ns", "nodes/op");
+	for (size_t i = 0; i < resultCount; i++) {
+		const BenchResult *r = &results[i];
+		double rate = r->seconds > 0 ? (double)r->ops / r->seconds : 0.0;
+		fprintf(out, "%-24s %-12s %10llu %14.0f %12.0f %12.0f", r->name, r->category, r->ops, rate,
+			percentile(r, 50), percentile(r, 99));
+		if (r->hasNodes) fprintf(out, " %12.1f\n", r->ops ? (double)r->nodes / (double)r->ops : 0.0);
+		else fprintf(out, " %12s\n", "-");
+	}
+}
+
+static void printJson(FILE *out, const Corpus *corpus, const BenchOptions *options) {
+	fprintf(out, "{\n  \"revision\": \"%s\",\n  \"corpus\": \"%s\",\n  \"puzzles\": %zu,\n  \"repeat\": %d,\n  \"results\": [\n",
+		options->revision, corpus->path, corpus->count, options->repeat);
+	for (size_t i = 0; i < resultCount; i++) {
+		const BenchResult *r = &results[i];
+		double rate = r->seconds > 0 ? (double)r->ops / r->seconds : 0.0;
+		fprintf(out, "    {\"name\": \"%s\", \"category\": \"%s\", \"ops\": %llu, \"seconds\": %.6f, "
+			"\"ops_per_sec\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f",
+			r->name, r->category, r->ops, r->seconds, rate, percentile(r, 50), percentile(r, 99));
+		if (r->hasNodes) fprintf(out, ", \"nodes_per_op\": %.2f", r->ops ? (double)r->nodes / (double)r->ops : 0.0);
+		fprintf(out, "}%s\n", i + 1 < resultCount ? "," : "");
+	}
+	fprintf(out, "  ]\n}\n");
+}
+
+static void printUsage(const char *program) {
+	fprintf(stderr, "Usage: %s [--corpus <file>] [--repeat N] [--only <name>] [--scratch <file>] [--revision <id>] [--json]\n", program);
+}
+
+int main(int argc, char **argv) {
+	BenchOptions options = { "bench/corpus.txt", NULL, "bench/scratch.sav", "unknown", 3, false };
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+			options.corpusPath = argv[++i];
+		} else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+			options.repeat = atoi(argv[++i]);
+			if (options.repeat < 1) options.repeat = 1;
+		} else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+			options.only = argv[++i];
+		} else if (strcmp(argv[i], "--scratch") == 0 && i + 1 < argc) {
+			options.scratchPath = argv[++i];
+		} else if (strcmp(argv[i], "--revision") == 0 && i + 1 < argc) {
+			options.revision = argv[++i];
+		} else if (strcmp(argv[i], "--json") == 0) {
+			options.json = true;
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+	Corpus corpus;
+	if (!loadCorpus(&corpus, options.corpusPath)) {
+		fprintf(stderr, "Could not read a corpus from %s\n", options.corpusPath);
+		return 1;
+	}
+	fprintf(stderr, "Benchmarking %zu puzzles in %d categories from %s (revision %s)\n",
+		corpus.count, corpus.categoryCount, corpus.path, options.revision);
+
+	benchSolve(&corpus, &options);
+	benchValidation(&corpus, &options);
+	benchParsing(&corpus, &options);
+	benchSaves(&corpus, &options);
+
+	for (size_t i = 0; i < resultCount; i++) {
+		qsort(results[i].samples, results[i].sampleCount, sizeof(double), compareDoubles);
+	}
+	if (options.json) printJson(stdout, &corpus, &options);
+	else printText(stdout);
+	for (size_t i = 0; i < resultCount; i++) free(results[i].samples);
+	free(results);
+	free(corpus.entries);
+	return 0;
+}
@@ -0,0 +1,447 @@
+// Round-trip and corruption checks for the on-disk save formats. Built and run by
+// `make check`; exits non-zero and names the failing check when anything is off.
+// Covers version 2 encode/decode, reading version 1 and the raw GameState dumps of
+// older builds, rejection of damaged or truncated saves, and autosave journal replay
+// after a torn or damaged record.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "structs.h"
+#include "autosave.h"
+#include "board.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "save_format.h"
+
+#define LEGACY_MOVES 128
+
+static const char *samplePuzzle = "530070000600195000098000060800060003400803001700020006060000280000419005000080079";
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+	if (!(cond)) { \
+		failures++; \
+		fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+		fprintf(stderr, __VA_ARGS__); \
+		fprintf(stderr, "\n"); \
+	} \
+} while (0)
+
+// Mirrors of the raw layouts save_format.c still reads.
+typedef struct LegacyIntGameState {
+	int currentGrid[GRID_SIZE][GRID_SIZE];
+	bool isFixed[GRID_SIZE][GRID_SIZE];
+	char activeDifficulty[32];
+	char activePuzzleName[64];
+	Move moves[LEGACY_MOVES];
+	size_t moveCount;
+	size_t redoCount;
+	time_t timerStart;
+	unsigned int elapsedSeconds;
+	size_t nextHintIndex;
+} LegacyIntGameState;
+
+typedef struct LegacyBoardGameState {
+	Board currentGrid;
+	bool isFixed[GRID_SIZE][GRID_SIZE];
+	char activeDifficulty[32];
+	char activePuzzleName[64];
+	Move moves[LEGACY_MOVES];
+	size_t moveCount;
+	size_t redoCount;
+	time_t timerStart;
+	unsigned int elapsedSeconds;
+	size_t nextHintIndex;
+} LegacyBoardGameState;
+
+// The moves the linear samples play; the last one is undone again.
+static const Move sampleMoves[3] = { { 0, 2, 0, 4 }, { 0, 3, 0, 6 }, { 1, 1, 0, 7 } };
+
+static void startState(GameState *state) {
+	memset(state, 0, sizeof(*state));
+	snprintf(state->activePuzzleName, sizeof(state->activePuzzleName), "Check");
+	snprintf(state->activeDifficulty, sizeof(state->activeDifficulty), "Hard");
+	parseGrid81(samplePuzzle, &state->currentGrid);
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		state->isFixed[cell / GRID_SIZE][cell % GRID_SIZE] = state->currentGrid.cells[cell] != 0;
+	}
+	tallyBoard(&state->tally, &state->currentGrid);
+	state->elapsedSeconds = 4242;
+	state->timerStart = (time_t)1700000000;
+	state->nextHintIndex = 3;
+}
+
+// Two moves played and a third undone, so the history has a redo move.
+static void linearState(GameState *state) {
+	startState(state);
+	for (int i = 0; i < 3; i++) playMove(state, sampleMoves[i].row, sampleMoves[i].col, sampleMoves[i].newValue);
+	undoMove(state, NULL);
+}
+
+// A history with a branch: a move is undone and a different one played in its place.
+static void branchedState(GameState *state) {
+	linearState(state);
+	playMove(state, 1, 1, 2);
+	playMove(state, 2, 0, 1);
+	undoMove(state, NULL);
+	if (sizeof(time_t) > 4) state->timerStart = (time_t)5000000000LL; // needs all 64 bits
+}
+
+static uint8_t *encodeState(const GameState *state, size_t *size) {
+	uint8_t *data = (uint8_t*)malloc(encodedGameStateSize(state));
+	if (data) *size = encodeGameState(state, data);
+	return data;
+}
+
+// Equal states encode to the same bytes; that compares the history tree too.
+static bool sameState(const GameState *a, const GameState *b) {
+	size_t sizeA = 0, sizeB = 0;
+	uint8_t *dataA = encodeState(a, &sizeA), *dataB = encodeState(b, &sizeB);
+	bool same = dataA && dataB && sizeA == sizeB && memcmp(dataA, dataB, sizeA) == 0;
+	free(dataA);
+	free(dataB);
+	return same;
+}
+
+static bool tallyMatches(const GameState *state) {
+	BoardTally fresh;
+	tallyBoard(&fresh, &state->currentGrid);
+	return memcmp(&fresh, &state->tally, sizeof(fresh)) == 0;
+}
+
+static bool writeFile(const char *path, const void *data, size_t size) {
+	FILE *f = fopen(path, "wb");
+	if (!f) return false;
+	bool ok = fwrite(data, 1, size, f) == size;
+	return fclose(f) == 0 && ok;
+}
+
+static void checkVersion2(void) {
+	GameState state, decoded;
+	branchedState(&state);
+	size_t size = 0;
+	uint8_t *data = encodeState(&state, &size);
+	CHECK(data && size == encodedGameStateSize(&state), "v2: encoded size");
+	if (!data) return;
+	CHECK(memcmp(data, "SMSV", 4) == 0 && data[4] == SAVE_FORMAT_VERSION && data[5] == 0, "v2: header");
+
+	bool ok = decodeGameState(data, size, &decoded);
+	CHECK(ok, "v2: decode");
+	if (ok) {
+		CHECK(sameState(&state, &decoded), "v2: decoded state differs");
+		CHECK(decoded.timerStart == state.timerStart, "v2: timer start");
+		CHECK(historyRedoBranches(&decoded.history) == historyRedoBranches(&state.history), "v2: redo branches");
+		CHECK(tallyMatches(&decoded), "v2: tally not rebuilt");
+		freeMoveHistory(&decoded.history);
+	}
+
+	for (size_t len = 0; len < size; len++) {
+		ok = decodeGameState(data, len, &decoded);
+		CHECK(!ok, "v2: %zu of %zu bytes accepted", len, size);
+		if (ok) freeMoveHistory(&decoded.history);
+	}
+	for (size_t i = 0; i < size; i++) {
+		if (i == 6 || i == 7) continue; // reserved
+		for (int bit = 0; bit < 8; bit++) {
+			data[i] ^= (uint8_t)(1u << bit);
+			ok = decodeGameState(data, size, &decoded);
+			data[i] ^= (uint8_t)(1u << bit);
+			CHECK(!ok, "v2: flipped bit %d of byte %zu accepted", bit, i);
+			if (ok) freeMoveHistory(&decoded.history);
+		}
+	}
+	free(data);
+	freeMoveHistory(&state.history);
+}
+
+static uint8_t *put16(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+	p = put16(p, v & 0xFFFFu);
+	return put16(p, v >> 16);
+}
+
+// Version 1: 12-byte header with a u16 payload length, and a flat move log in place of
+// the history.
+static size_t encodeVersion1(const GameState *state, const Move *moves, int moveCount, int redoCount, uint8_t *out) {
+	uint8_t *p = out + 12;
+	size_t len = strlen(state->activePuzzleName);
+	*p++ = (uint8_t)len;
+	memcpy(p, state->activePuzzleName, len);
+	p += len;
+	len = strlen(state->activeDifficulty);
+	*p++ = (uint8_t)len;
+	memcpy(p, state->activeDifficulty, len);
+	p += len;
+	PackedBoard packed;
+	packBoard(&state->currentGrid, &packed);
+	memcpy(p, packed.bytes, sizeof(packed.bytes));
+	p += sizeof(packed.bytes);
+	memset(p, 0, SAVE_FIXED_MASK_BYTES);
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (state->isFixed[cell / GRID_SIZE][cell % GRID_SIZE]) p[cell / 8] |= (uint8_t)(1u << (cell % 8));
+	}
+	p += SAVE_FIXED_MASK_BYTES;
+	uint64_t timerStart = (uint64_t)(int64_t)state->timerStart;
+	p = put32(p, state->elapsedSeconds);
+	p = put32(p, (uint32_t)timerStart);
+	p = put32(p, (uint32_t)(timerStart >> 32));
+	p = put16(p, (uint32_t)state->nextHintIndex);
+	*p++ = (uint8_t)moveCount;
+	*p++ = (uint8_t)redoCount;
+	for (int i = 0; i < moveCount + redoCount; i++) {
+		*p++ = (uint8_t)((moves[i].row << 4) | moves[i].col);
+		*p++ = (uint8_t)((moves[i].previousValue << 4) | moves[i].newValue);
+	}
+	size_t payload = (size_t)(p - out) - 12;
+	memcpy(out, "SMSV", 4);
+	put16(out + 4, 1);
+	put16(out + 6, (uint32_t)payload);
+	put32(out + 8, crc32Bytes(out + 12, payload));
+	return 12 + payload;
+}
+
+static void checkVersion1(const char *scratchPath) {
+	GameState expected, loaded;
+	linearState(&expected);
+	uint8_t data[512];
+	size_t size = encodeVersion1(&expected, sampleMoves, 2, 1, data);
+	CHECK(writeFile(scratchPath, data, size), "v1: cannot write %s", scratchPath);
+	bool ok = loadGameState(&loaded, scratchPath);
+	CHECK(ok, "v1: load");
+	if (ok) {
+		CHECK(sameState(&expected, &loaded), "v1: loaded state differs");
+		CHECK(tallyMatches(&loaded), "v1: tally not rebuilt");
+		freeMoveHistory(&loaded.history);
+	}
+	data[size - 1] ^= 0x01;
+	ok = decodeGameState(data, size, &loaded);
+	CHECK(!ok, "v1: damaged payload accepted");
+	if (ok) freeMoveHistory(&loaded.history);
+	remove(scratchPath);
+	freeMoveHistory(&expected.history);
+}
+
+#define FILL_LEGACY(legacy, state) do { \
+	memcpy((legacy)->isFixed, (state)->isFixed, sizeof((legacy)->isFixed)); \
+	memcpy((legacy)->activeDifficulty, (state)->activeDifficulty, sizeof((legacy)->activeDifficulty)); \
+	memcpy((legacy)->activePuzzleName, (state)->activePuzzleName, sizeof((legacy)->activePuzzleName)); \
+	memcpy((legacy)->moves, sampleMoves, sizeof(sampleMoves)); \
+	(legacy)->moveCount = 2; \
+	(legacy)->redoCount = 1; \
+	(legacy)->timerStart = (state)->timerStart; \
+	(legacy)->elapsedSeconds = (state)->elapsedSeconds; \
+	(legacy)->nextHintIndex = (state)->nextHintIndex; \
+} while (0)
+
+static void checkLegacyFile(const char *what, const char *scratchPath, const GameState *expected, const void *data, size_t size) {
+	GameState loaded;
+	CHECK(writeFile(scratchPath, data, size), "%s: cannot write %s", what, scratchPath);
+	bool ok = loadGameState(&loaded, scratchPath);
+	CHECK(ok, "%s: load", what);
+	if (ok) {
+		CHECK(sameState(expected, &loaded), "%s: loaded state differs", what);
+		CHECK(tallyMatches(&loaded), "%s: tally not rebuilt", what);
+		freeMoveHistory(&loaded.history);
+	}
+	remove(scratchPath);
+}
+
+static void checkLegacy(const char *scratchPath) {
+	GameState expected, loaded;
+	linearState(&expected);
+
+	LegacyIntGameState *ints = (LegacyIntGameState*)calloc(1, sizeof(*ints));
+	LegacyBoardGameState *boards = (LegacyBoardGameState*)calloc(1, sizeof(*boards));
+	if (!ints || !boards) {
+		CHECK(false, "legacy: out of memory");
+		free(ints);
+		free(boards);
+		return;
+	}
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		ints->currentGrid[cell / GRID_SIZE][cell % GRID_SIZE] = expected.currentGrid.cells[cell];
+	}
+	FILL_LEGACY(ints, &expected);
+	checkLegacyFile("legacy int grid", scratchPath, &expected, ints, sizeof(*ints));
+	boards->currentGrid = expected.currentGrid;
+	FILL_LEGACY(boards, &expected);
+	checkLegacyFile("legacy board", scratchPath, &expected, boards, sizeof(*boards));
+
+	ints->currentGrid[4][4] = 12;
+	bool ok = decodeGameState((const uint8_t*)ints, sizeof(*ints), &loaded);
+	CHECK(!ok, "legacy int grid: out-of-range cell accepted");
+	if (ok) freeMoveHistory(&loaded.history);
+	ints->currentGrid[4][4] = 0;
+	ints->moveCount = LEGACY_MOVES + 1;
+	ok = decodeGameState((const uint8_t*)ints, sizeof(*ints), &loaded);
+	CHECK(!ok, "legacy int grid: move count past the log accepted");
+	if (ok) freeMoveHistory(&loaded.history);
+	free(ints);
+	free(boards);
+	freeMoveHistory(&expected.history);
+}
+
+// Plays one operation and journals it the way game_session.c does.
+static bool journalStep(Autosave *autosave, GameState *state, JournalOp op, int row, int col, int value) {
+	Move move = { row, col, boardGet(&state->currentGrid, row, col), value };
+	bool done = false;
+	switch (op) {
+		case JOURNAL_MOVE: done = playMove(state, row, col, value); break;
+		case JOURNAL_UNDO: done = undoMove(state, &move); break;
+		case JOURNAL_REDO: done = redoMove(state, &move); break;
+		case JOURNAL_BRANCH: done = historyNextBranch(&state->history, &move); break;
+	}
+	return done && journalMove(autosave, state, op, &move);
+}
+
+typedef struct JournalStep {
+	JournalOp op;
+	int row, col, value;
+} JournalStep;
+
+static const JournalStep journalSteps[] = {
+	{ JOURNAL_MOVE, 0, 2, 4 }, { JOURNAL_MOVE, 0, 3, 6 }, { JOURNAL_MOVE, 1, 1, 7 }, { JOURNAL_UNDO, 0, 0, 0 },
+	{ JOURNAL_MOVE, 1, 1, 2 }, { JOURNAL_UNDO, 0, 0, 0 }, { JOURNAL_BRANCH, 0, 0, 0 }, { JOURNAL_REDO, 0, 0, 0 },
+	{ JOURNAL_MOVE, 2, 0, 1 }, { JOURNAL_UNDO, 0, 0, 0 }
+};
+#define JOURNAL_STEPS (sizeof(journalSteps) / sizeof(journalSteps[0]))
+// As in autosave.c.
+#define JOURNAL_HEADER_BYTES 12
+#define JOURNAL_RECORD_BYTES 12
+
+static bool loadsAs(const char *savePath, const GameState *expected) {
+	GameState loaded;
+	if (!loadAutosave(&loaded, savePath)) return false;
+	bool same = sameState(expected, &loaded) && tallyMatches(&loaded);
+	freeMoveHistory(&loaded.history);
+	return same;
+}
+
+static void checkJournal(const char *scratchPath) {
+	char journalPath[330];
+	saveJournalPath(scratchPath, journalPath, sizeof(journalPath));
+	// after[k] is the state after the first k steps. The timer is stopped so every
+	// record carries the same play time.
+	GameState after[JOURNAL_STEPS + 1];
+	GameState live;
+	startState(&live);
+	live.timerStart = 0;
+	Autosave autosave;
+	CHECK(startAutosave(&autosave, &live, scratchPath), "journal: cannot start autosave at %s", scratchPath);
+	size_t steps = 0;
+	after[0] = live;
+	memset(&after[0].history, 0, sizeof(after[0].history));
+	for (; steps < JOURNAL_STEPS; steps++) {
+		const JournalStep *step = &journalSteps[steps];
+		if (!journalStep(&autosave, &live, step->op, step->row, step->col, step->value)) break;
+		// Snapshots of the state are rebuilt by decoding, which deep-copies the history.
+		size_t size = 0;
+		uint8_t *data = encodeState(&live, &size);
+		if (!data || !decodeGameState(data, size, &after[steps + 1])) break;
+		free(data);
+	}
+	stopAutosave(&autosave);
+	CHECK(steps == JOURNAL_STEPS, "journal: step %zu could not be played", steps);
+	if (steps == JOURNAL_STEPS) {
+		CHECK(loadsAs(scratchPath, &live), "journal: full replay differs");
+
+		size_t size = 0;
+		uint8_t *journal = readWholeFile(journalPath, &size);
+		CHECK(journal && size == JOURNAL_HEADER_BYTES + JOURNAL_STEPS * JOURNAL_RECORD_BYTES, "journal: %zu bytes", size);
+		if (journal && size == JOURNAL_HEADER_BYTES + JOURNAL_STEPS * JOURNAL_RECORD_BYTES) {
+			for (size_t cut = 1; cut < JOURNAL_RECORD_BYTES; cut++) {
+				writeFile(journalPath, journal, size - cut);
+				CHECK(loadsAs(scratchPath, &after[JOURNAL_STEPS - 1]), "journal: last record torn %zu bytes short", cut);
+			}
+			for (size_t k = 0; k < JOURNAL_STEPS; k++) {
+				size_t at = JOURNAL_HEADER_BYTES + k * JOURNAL_RECORD_BYTES + k % JOURNAL_RECORD_BYTES;
+				journal[at] ^= 0x10;
+				writeFile(journalPath, journal, size);
+				journal[at] ^= 0x10;
+				CHECK(loadsAs(scratchPath, &after[k]), "journal: replay past damaged record %zu", k);
+			}
+			// A journal left over from another snapshot is ignored.
+			writeFile(journalPath, journal, size);
+			GameState other = after[0];
+			other.elapsedSeconds++;
+			size_t snapshotSize = 0;
+			uint8_t *snapshot = encodeState(&other, &snapshotSize);
+			writeFile(scratchPath, snapshot, snapshotSize);
+			CHECK(loadsAs(scratchPath, &other), "journal: replayed onto a snapshot it does not extend");
+			free(snapshot);
+		}
+		free(journal);
+	}
+	for (size_t k = 0; k <= steps && k <= JOURNAL_STEPS; k++) freeMoveHistory(&after[k].history);
+	freeMoveHistory(&live.history);
+	remove(scratchPath);
+	remove(journalPath);
+}
+
+// Compaction replaces the snapshot and empties the journal; nothing may be lost,
+// including the play time that only the discarded records carried.
+static void checkCompaction(const char *scratchPath) {
+	char journalPath[330];
+	saveJournalPath(scratchPath, journalPath, sizeof(journalPath));
+	GameState live;
+	startState(&live);
+	live.timerStart = time(NULL) - 1000;
+	Autosave autosave;
+	bool ok = startAutosave(&autosave, &live, scratchPath);
+	live.timerStart -= 1000; // played another 1000 seconds since that snapshot
+	for (int i = 0; ok && i < JOURNAL_COMPACT_RECORDS; i++) {
+		ok = i % 2 == 0 ? journalStep(&autosave, &live, JOURNAL_MOVE, 0, 2, 4)
+			: journalStep(&autosave, &live, JOURNAL_UNDO, 0, 0, 0);
+	}
+	stopAutosave(&autosave);
+	CHECK(ok, "compaction: journaling failed");
+	size_t size = 0;
+	uint8_t *journal = readWholeFile(journalPath, &size);
+	CHECK(journal && size == JOURNAL_HEADER_BYTES, "compaction: journal not emptied (%zu bytes)", size);
+	free(journal);
+	GameState loaded;
+	ok = loadAutosave(&loaded, scratchPath);
+	CHECK(ok, "compaction: load");
+	if (ok) {
+		CHECK(loaded.elapsedSeconds >= 4242 + 2000, "compaction: %u seconds kept of at least %u",
+			loaded.elapsedSeconds, 4242 + 2000);
+		CHECK(sameState(&live, &loaded), "compaction: loaded state differs");
+		freeMoveHistory(&loaded.history);
+	}
+	freeMoveHistory(&live.history);
+	remove(scratchPath);
+	remove(journalPath);
+}
+
+static void printUsage(const char *program) {
+	fprintf(stderr, "Usage: %s [--scratch <file.sav>]\n", program);
+}
+
+int main(int argc, char **argv) {
+	const char *scratchPath = "bench/scratch-check.sav";
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--scratch") == 0 && i + 1 < argc) {
+			scratchPath = argv[++i];
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+	checkVersion2();
+	checkVersion1(scratchPath);
+	checkLegacy(scratchPath);
+	checkJournal(scratchPath);
+	checkCompaction(scratchPath);
+	if (failures) {
+		fprintf(stderr, "%d format checks failed\n", failures);
+		return 1;
+	}
+	fprintf(stderr, "All format checks passed\n");
+	return 0;
+}
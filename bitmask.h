@@ -0,0 +1,80 @@
+#ifndef BITMASK_H
+#define BITMASK_H
+
+#include <string.h>
+#include "structs.h"
+
+// Digit d (1..9) is stored as bit (d - 1); a full unit is ALL_DIGITS_MASK.
+#define ALL_DIGITS_MASK 0x1FFu
+#define DIGIT_BIT(d) (1u << ((d) - 1))
+#define BOX_INDEX(r, c) (((r) / 3) * 3 + ((c) / 3))
+
+static inline int bitCount(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcount(mask);
+#else
+	int n = 0;
+	while (mask) { mask &= mask - 1; n++; }
+	return n;
+#endif
+}
+
+// Index (0-based) of the lowest set bit; mask must be non-zero.
+static inline int lowestBitIndex(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(mask);
+#else
+	int i = 0;
+	while (!(mask & 1u)) { mask >>= 1; i++; }
+	return i;
+#endif
+}
+
+// Occupancy masks kept incrementally while searching: a set bit means the digit
+// is already used in that row, column or box.
+typedef struct MaskBoard {
+	uint16_t rows[GRID_SIZE];
+	uint16_t cols[GRID_SIZE];
+	uint16_t boxes[GRID_SIZE];
+	uint8_t cells[CELL_COUNT];
+	int emptyCount;
+} MaskBoard;
+
+static inline unsigned int cellCandidates(const MaskBoard *b, int cell) {
+	int r = cell / GRID_SIZE, c = cell % GRID_SIZE;
+	return ~(unsigned int)(b->rows[r] | b->cols[c] | b->boxes[BOX_INDEX(r, c)]) & ALL_DIGITS_MASK;
+}
+
+static inline void placeDigit(MaskBoard *b, int cell, unsigned int bit) {
+	int r = cell / GRID_SIZE, c = cell % GRID_SIZE;
+	b->rows[r] |= bit;
+	b->cols[c] |= bit;
+	b->boxes[BOX_INDEX(r, c)] |= bit;
+	b->cells[cell] = (uint8_t)(lowestBitIndex(bit) + 1);
+	b->emptyCount--;
+}
+
+static inline void removeDigit(MaskBoard *b, int cell, unsigned int bit) {
+	int r = cell / GRID_SIZE, c = cell % GRID_SIZE;
+	b->rows[r] &= ~bit;
+	b->cols[c] &= ~bit;
+	b->boxes[BOX_INDEX(r, c)] &= ~bit;
+	b->cells[cell] = 0;
+	b->emptyCount++;
+}
+
+static inline bool loadMasks(MaskBoard *b, const Board *board) {
+	memset(b, 0, sizeof(*b));
+	b->emptyCount = CELL_COUNT;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		int v = board->cells[cell];
+		if (v == 0) continue;
+		if (v > 9) return false;
+		if (!(cellCandidates(b, cell) & DIGIT_BIT(v))) return false; // conflicting givens
+		placeDigit(b, cell, DIGIT_BIT(v));
+	}
+	return true;
+}
+
+#endif
+
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "board.h"
+
+void boardFromGrid(Board *out, const int grid[GRID_SIZE][GRID_SIZE]) {
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			out->cells[r * GRID_SIZE + c] = (uint8_t)grid[r][c];
+		}
+	}
+}
+
+void boardToGrid(const Board *board, int grid[GRID_SIZE][GRID_SIZE]) {
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			grid[r][c] = board->cells[r * GRID_SIZE + c];
+		}
+	}
+}
+
+void packBoard(const Board *board, PackedBoard *out) {
+	memset(out, 0, sizeof(*out));
+	for (int i = 0; i < CELL_COUNT; i++) {
+		out->bytes[i / 2] |= (uint8_t)((board->cells[i] & 0x0F) << ((i & 1) * 4));
+	}
+}
+
+void unpackBoard(const PackedBoard *packed, Board *out) {
+	for (int i = 0; i < CELL_COUNT; i++) {
+		out->cells[i] = (uint8_t)((packed->bytes[i / 2] >> ((i & 1) * 4)) & 0x0F);
+	}
+}
+
+int countEmptyCells(const Board *board) {
+	int empty = 0;
+	for (int i = 0; i < CELL_COUNT; i++) {
+		if (board->cells[i] == 0) empty++;
+	}
+	return empty;
+}
+
+static void tallyUnit(BoardTally *tally, int unit, int value, int delta) {
+	uint8_t *count = &tally->counts[unit][value - 1];
+	if (delta > 0) {
+		if ((*count)++ > 0) tally->conflicts++;
+		tally->used[unit] |= (uint16_t)(1u << (value - 1));
+	} else {
+		if (--(*count) > 0) tally->conflicts--;
+		else tally->used[unit] &= (uint16_t)~(1u << (value - 1));
+	}
+}
+
+static void tallyCell(BoardTally *tally, int cell, int value, int delta) {
+	if (value < 1 || value > 9) return;
+	int r = cell / GRID_SIZE, c = cell % GRID_SIZE;
+	tallyUnit(tally, r, value, delta);
+	tallyUnit(tally, GRID_SIZE + c, value, delta);
+	tallyUnit(tally, 2 * GRID_SIZE + (r / 3) * 3 + c / 3, value, delta);
+	tally->emptyCount -= delta;
+}
+
+void tallyBoard(BoardTally *tally, const Board *board) {
+	memset(tally, 0, sizeof(*tally));
+	tally->emptyCount = CELL_COUNT;
+	for (int cell = 0; cell < CELL_COUNT; cell++) tallyCell(tally, cell, board->cells[cell], 1);
+}
+
+void tallyChange(BoardTally *tally, int cell, int oldValue, int newValue) {
+	if (oldValue == newValue) return;
+	tallyCell(tally, cell, oldValue, -1);
+	tallyCell(tally, cell, newValue, 1);
+}
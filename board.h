@@ -0,0 +1,53 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdbool.h>
+#include "structs.h"
+
+#define UNIT_COUNT (3 * GRID_SIZE)
+
+// Units 0-8 are rows, 9-17 columns, 18-26 boxes; returns the i-th cell (0..8) of a unit.
+static inline int unitCell(int unit, int i) {
+	if (unit < GRID_SIZE) return unit * GRID_SIZE + i;
+	if (unit < 2 * GRID_SIZE) return i * GRID_SIZE + (unit - GRID_SIZE);
+	int b = unit - 2 * GRID_SIZE;
+	return ((b / 3) * 3 + i / 3) * GRID_SIZE + (b % 3) * 3 + i % 3;
+}
+
+static inline int boardGet(const Board *board, int row, int col) {
+	return board->cells[row * GRID_SIZE + col];
+}
+
+static inline void boardSet(Board *board, int row, int col, int value) {
+	board->cells[row * GRID_SIZE + col] = (uint8_t)value;
+}
+
+void boardFromGrid(Board *out, const int grid[GRID_SIZE][GRID_SIZE]);
+void boardToGrid(const Board *board, int grid[GRID_SIZE][GRID_SIZE]);
+
+void packBoard(const Board *board, PackedBoard *out);
+void unpackBoard(const PackedBoard *packed, Board *out);
+
+int countEmptyCells(const Board *board);
+
+// Rebuilds a tally from scratch; needed whenever the board is replaced rather than edited.
+void tallyBoard(BoardTally *tally, const Board *board);
+// Records that cell changed from oldValue to newValue (0 for empty) in O(1).
+void tallyChange(BoardTally *tally, int cell, int oldValue, int newValue);
+
+// Digits (as a 9-bit mask) not yet used in the cell's row, column or box.
+static inline unsigned int tallyCandidates(const BoardTally *tally, int row, int col) {
+	return ~(unsigned int)(tally->used[row] | tally->used[GRID_SIZE + col]
+		| tally->used[2 * GRID_SIZE + (row / 3) * 3 + col / 3]) & 0x1FFu;
+}
+
+static inline bool tallyComplete(const BoardTally *tally) {
+	return tally->emptyCount == 0;
+}
+
+// Complete with no digit repeated in any unit.
+static inline bool tallySolved(const BoardTally *tally) {
+	return tally->emptyCount == 0 && tally->conflicts == 0;
+}
+
+#endif
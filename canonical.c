@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <string.h>
+#include "canonical.h"
+#include "sys_thread.h"
+
+static const uint8_t perm3[6][3] = {
+	{ 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+};
+
+// A transform fixed for the rows placed so far; cols is fixed by the first row.
+typedef struct Candidate {
+	uint8_t transpose;
+	uint8_t nextLabel;
+	uint8_t rows[GRID_SIZE];
+	uint8_t cols[GRID_SIZE];
+	uint8_t digits[10];
+} Candidate;
+
+typedef struct CandidateList {
+	Candidate *items;
+	size_t count;
+	size_t capacity;
+} CandidateList;
+
+// Kept between calls so a thread canonicalizing millions of puzzles allocates only while
+// the lists grow to the largest tie it has seen.
+static THREAD_LOCAL CandidateList threadLists[2];
+
+static bool pushCandidate(CandidateList *list, const Candidate *c) {
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity ? list->capacity * 2 : 64;
+		Candidate *grown = (Candidate*)realloc(list->items, capacity * sizeof(*grown));
+		if (!grown) return false;
+		list->items = grown;
+		list->capacity = capacity;
+	}
+	list->items[list->count++] = *c;
+	return true;
+}
+
+static void transposeBoard(const Board *in, Board *out) {
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) out->cells[c * GRID_SIZE + r] = in->cells[r * GRID_SIZE + c];
+	}
+}
+
+// Bit (2 - i) set when column i of a three-cell block holds a given, so that comparing
+// the bits of two rows compares where their first given comes.
+static unsigned int blockPattern(const uint8_t *row, const uint8_t cols[3]) {
+	return (row[cols[0]] ? 4u : 0u) | (row[cols[1]] ? 2u : 0u) | (row[cols[2]] ? 1u : 0u);
+}
+
+// The best first-row placement of a row's givens: stacks with fewer givens first, each
+// with its empty cells first. The digits themselves never matter for the first row,
+// which relabeling always turns into 1, 2, 3, ...
+static unsigned int bestRowPattern(const uint8_t *row) {
+	int counts[3];
+	for (int s = 0; s < 3; s++) counts[s] = (row[s * 3] != 0) + (row[s * 3 + 1] != 0) + (row[s * 3 + 2] != 0);
+	for (int i = 1; i < 3; i++) {
+		for (int j = i; j > 0 && counts[j - 1] > counts[j]; j--) {
+			int t = counts[j];
+			counts[j] = counts[j - 1];
+			counts[j - 1] = t;
+		}
+	}
+	unsigned int pattern = 0;
+	for (int s = 0; s < 3; s++) pattern = (pattern << 3) | ((1u << counts[s]) - 1u);
+	return pattern;
+}
+
+static void relabelRow(Candidate *c, const uint8_t *row) {
+	for (int p = 0; p < GRID_SIZE; p++) {
+		int v = row[c->cols[p]];
+		if (v && !c->digits[v]) c->digits[v] = c->nextLabel++;
+	}
+}
+
+// Every column order that lays the row out as pattern becomes a candidate.
+static bool addFirstRowCandidates(CandidateList *list, int transpose, int row, const uint8_t *cells, unsigned int pattern) {
+	for (int sp = 0; sp < 6; sp++) {
+		int fits[3][6], fitCount[3];
+		for (int b = 0; b < 3; b++) {
+			int stack = perm3[sp][b];
+			unsigned int want = (pattern >> (3 * (2 - b))) & 7u;
+			fitCount[b] = 0;
+			for (int w = 0; w < 6; w++) {
+				uint8_t cols[3] = { (uint8_t)(stack * 3 + perm3[w][0]), (uint8_t)(stack * 3 + perm3[w][1]),
+					(uint8_t)(stack * 3 + perm3[w][2]) };
+				if (blockPattern(cells, cols) == want) fits[b][fitCount[b]++] = w;
+			}
+		}
+		for (int i0 = 0; i0 < fitCount[0]; i0++) {
+			for (int i1 = 0; i1 < fitCount[1]; i1++) {
+				for (int i2 = 0; i2 < fitCount[2]; i2++) {
+					Candidate c;
+					memset(&c, 0, sizeof(c));
+					c.transpose = (uint8_t)transpose;
+					c.nextLabel = 1;
+					c.rows[0] = (uint8_t)row;
+					int chosen[3] = { fits[0][i0], fits[1][i1], fits[2][i2] };
+					for (int b = 0; b < 3; b++) {
+						for (int i = 0; i < 3; i++) c.cols[b * 3 + i] = (uint8_t)(perm3[sp][b] * 3 + perm3[chosen[b]][i]);
+					}
+					relabelRow(&c, cells);
+					if (!pushCandidate(list, &c)) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Lays source row out under the candidate's columns and labels into out, giving up (false)
+// as soon as it is certain to be larger than bound. *smaller reports a strict improvement.
+static bool layOutRow(const Candidate *c, const uint8_t *row, const uint8_t *bound, bool haveBound,
+	uint8_t out[GRID_SIZE], uint8_t digits[10], uint8_t *nextLabel, bool *smaller) {
+	memcpy(digits, c->digits, 10);
+	*nextLabel = c->nextLabel;
+	*smaller = !haveBound;
+	for (int p = 0; p < GRID_SIZE; p++) {
+		int v = row[c->cols[p]];
+		if (v && !digits[v]) digits[v] = (*nextLabel)++;
+		out[p] = digits[v];
+		if (*smaller) continue;
+		if (out[p] > bound[p]) return false;
+		if (out[p] < bound[p]) *smaller = true;
+	}
+	return true;
+}
+
+// Branch and bound, one canonical row at a time: only the candidates that tie for the
+// smallest row so far survive to the next one. Ties are rare after a few rows, so the
+// search stays small even though the group has over 10^12 elements.
+void canonicalizeBoard(const Board *board, Board *canonical, GridTransform *transform) {
+	Board grids[2];
+	grids[0] = *board;
+	transposeBoard(board, &grids[1]);
+
+	unsigned int best = ~0u;
+	for (int t = 0; t < 2; t++) {
+		for (int r = 0; r < GRID_SIZE; r++) {
+			unsigned int pattern = bestRowPattern(&grids[t].cells[r * GRID_SIZE]);
+			if (pattern < best) best = pattern;
+		}
+	}
+	CandidateList *current = &threadLists[0], *next = &threadLists[1];
+	current->count = 0;
+	bool ok = true;
+	for (int t = 0; t < 2 && ok; t++) {
+		for (int r = 0; r < GRID_SIZE && ok; r++) {
+			const uint8_t *cells = &grids[t].cells[r * GRID_SIZE];
+			if (bestRowPattern(cells) == best) ok = addFirstRowCandidates(current, t, r, cells, best);
+		}
+	}
+	// Only a row that repeats a digit lays out differently under the same pattern.
+	uint8_t rowsOut[GRID_SIZE][GRID_SIZE];
+	size_t kept = 0;
+	for (size_t i = 0; i < current->count && ok; i++) {
+		const Candidate *c = &current->items[i];
+		uint8_t laid[GRID_SIZE];
+		for (int p = 0; p < GRID_SIZE; p++) laid[p] = c->digits[grids[c->transpose].cells[c->rows[0] * GRID_SIZE + c->cols[p]]];
+		int order = kept == 0 ? -1 : memcmp(laid, rowsOut[0], sizeof(laid));
+		if (order > 0) continue;
+		if (order < 0) {
+			memcpy(rowsOut[0], laid, sizeof(laid));
+			kept = 0;
+		}
+		current->items[kept++] = *c;
+	}
+	current->count = kept;
+	for (int depth = 1; depth < GRID_SIZE && ok; depth++) {
+		bool haveBound = false;
+		next->count = 0;
+		for (size_t i = 0; i < current->count && ok; i++) {
+			const Candidate *c = &current->items[i];
+			const Board *g = &grids[c->transpose];
+			// A new band may be any band not used yet; otherwise stay in the current band.
+			int bandUsed[3] = { 0, 0, 0 };
+			for (int d = 0; d < depth; d += 3) bandUsed[c->rows[d] / 3] = 1;
+			for (int r = 0; r < GRID_SIZE; r++) {
+				if (depth % 3 == 0) {
+					if (bandUsed[r / 3]) continue;
+				} else {
+					if (r / 3 != c->rows[depth - depth % 3] / 3) continue;
+					bool used = false;
+					for (int d = depth - depth % 3; d < depth; d++) used |= c->rows[d] == r;
+					if (used) continue;
+				}
+				uint8_t laid[GRID_SIZE], digits[10], nextLabel;
+				bool smaller;
+				if (!layOutRow(c, &g->cells[r * GRID_SIZE], rowsOut[depth], haveBound, laid, digits, &nextLabel, &smaller)) continue;
+				if (smaller) {
+					next->count = 0;
+					memcpy(rowsOut[depth], laid, sizeof(laid));
+					haveBound = true;
+				}
+				Candidate extended = *c;
+				extended.rows[depth] = (uint8_t)r;
+				memcpy(extended.digits, digits, sizeof(digits));
+				extended.nextLabel = nextLabel;
+				ok = pushCandidate(next, &extended);
+			}
+		}
+		CandidateList *swap = current;
+		current = next;
+		next = swap;
+	}
+
+	if (ok && current->count > 0) {
+		Candidate winner = current->items[0];
+		// Digits missing from the puzzle take the labels left over, in order.
+		for (int v = 1; v <= 9; v++) {
+			if (!winner.digits[v]) winner.digits[v] = winner.nextLabel++;
+		}
+		GridTransform t;
+		t.transpose = winner.transpose != 0;
+		memcpy(t.rows, winner.rows, sizeof(t.rows));
+		memcpy(t.cols, winner.cols, sizeof(t.cols));
+		memcpy(t.digits, winner.digits, sizeof(t.digits));
+		applyGridTransform(&t, board, canonical);
+		if (transform) *transform = t;
+	} else {
+		// Out of memory: fall back to the identity so callers still get a valid grid.
+		GridTransform t;
+		t.transpose = false;
+		for (int i = 0; i < GRID_SIZE; i++) t.rows[i] = t.cols[i] = (uint8_t)i;
+		for (int v = 0; v <= 9; v++) t.digits[v] = (uint8_t)v;
+		*canonical = *board;
+		if (transform) *transform = t;
+	}
+}
+
+void applyGridTransform(const GridTransform *transform, const Board *in, Board *out) {
+	Board source;
+	if (transform->transpose) transposeBoard(in, &source);
+	else source = *in;
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			int v = source.cells[transform->rows[r] * GRID_SIZE + transform->cols[c]];
+			out->cells[r * GRID_SIZE + c] = v <= 9 ? transform->digits[v] : (uint8_t)v;
+		}
+	}
+}
+
+void undoGridTransform(const GridTransform *transform, const Board *in, Board *out) {
+	uint8_t inverse[10];
+	for (int v = 0; v <= 9; v++) inverse[transform->digits[v]] = (uint8_t)v;
+	Board source;
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			int v = in->cells[r * GRID_SIZE + c];
+			source.cells[transform->rows[r] * GRID_SIZE + transform->cols[c]] = v <= 9 ? inverse[v] : (uint8_t)v;
+		}
+	}
+	if (transform->transpose) transposeBoard(&source, out);
+	else *out = source;
+}
+
+static inline uint64_t mix64(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ull;
+	x ^= x >> 33;
+	return x;
+}
+
+static uint64_t hashCells(const Board *board, uint64_t seed) {
+	uint64_t h = seed;
+	for (int i = 0; i + 8 <= CELL_COUNT; i += 8) {
+		uint64_t word;
+		memcpy(&word, board->cells + i, sizeof(word));
+		h = mix64(h ^ word) + 0x9E3779B97F4A7C15ull;
+	}
+	return mix64(h ^ board->cells[CELL_COUNT - 1]);
+}
+
+uint64_t hashBoard(const Board *board) {
+	return hashCells(board, 0x9E3779B97F4A7C15ull);
+}
+
+BoardKey hashBoardKey(const Board *board) {
+	BoardKey key;
+	key.lo = hashCells(board, 0x9E3779B97F4A7C15ull);
+	key.hi = hashCells(board, 0xD1B54A32D192ED03ull);
+	return key;
+}
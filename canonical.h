@@ -0,0 +1,40 @@
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "structs.h"
+
+// One of the validity-preserving symmetries of a Sudoku grid. Applying it to a board
+// gives out[r][c] = digits[g[rows[r]][cols[c]]], where g is the board, transposed first
+// when transpose is set. rows only permutes bands and rows within a band, cols only
+// stacks and columns within a stack, and digits is a relabeling with digits[0] == 0.
+typedef struct GridTransform {
+	bool transpose;
+	uint8_t rows[GRID_SIZE];
+	uint8_t cols[GRID_SIZE];
+	uint8_t digits[10];
+} GridTransform;
+
+// Writes the canonical form of board: the lexicographically smallest grid (empty cells
+// first, digits relabeled in order of appearance) among everything the symmetries can
+// turn it into. Equivalent puzzles have the same canonical form. transform (optional)
+// receives a transform that maps board onto it.
+void canonicalizeBoard(const Board *board, Board *canonical, GridTransform *transform);
+
+void applyGridTransform(const GridTransform *transform, const Board *in, Board *out);
+// The inverse: maps a board in canonical coordinates (a canonical solution, say) back.
+void undoGridTransform(const GridTransform *transform, const Board *in, Board *out);
+
+// 64-bit fingerprint of a board's cells.
+uint64_t hashBoard(const Board *board);
+
+// 128-bit fingerprint, for keys that must not collide in practice.
+typedef struct BoardKey {
+	uint64_t lo;
+	uint64_t hi;
+} BoardKey;
+
+BoardKey hashBoardKey(const Board *board);
+
+#endif
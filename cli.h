@@ -1,24 +1,29 @@
-#ifndef CLI_H
-#define CLI_H
-
-#include "structs.h"
-
-void printBoard(const int grid[GRID_SIZE][GRID_SIZE]);
-
-int promptMove(int *row, int *col, int *value);
-
-void printMessage(const char *msg);
-
-int showStartMenu(void);
-
-int showDifficultyMenu(void);
-
-int promptCustomPuzzle(int grid[GRID_SIZE][GRID_SIZE]);
-
-int promptFilePath(char *outPath, size_t outPathSize, const char *purpose);
-
-int promptDifficulty(char *out, size_t outSize);
-
-#endif 
-
-
+#ifndef CLI_H
+#define CLI_H
+
+#include "structs.h"
+
+void printBoard(const Board *board);
+
+// Reads one game command from stdin; returns a SessionCommand (game_session.h).
+int promptMove(int *row, int *col, int *value);
+// The same while a background solve runs.
+int promptWhileSolving(int *row, int *col, int *value);
+// The same while a custom puzzle is checked before play.
+int promptWhileChecking(int *row, int *col, int *value);
+
+void printMessage(const char *msg);
+
+int showStartMenu(void);
+
+int showDifficultyMenu(void);
+
+int promptCustomPuzzle(Board *board);
+
+int promptFilePath(char *outPath, size_t outPathSize, const char *purpose);
+
+int promptDifficulty(char *out, size_t outSize);
+
+#endif 
+
+
@@ -0,0 +1,143 @@
+#include <string.h>
+#include "dlx.h"
+
+#define ROOT 0
+
+static int firstNodeOfRow(int row) {
+	return 1 + DLX_COLUMNS + row * 4;
+}
+
+void initDlxSolver(DlxSolver *dlx) {
+	memset(dlx, 0, sizeof(*dlx));
+	for (int c = 0; c <= DLX_COLUMNS; c++) {
+		dlx->left[c] = (int16_t)(c == 0 ? DLX_COLUMNS : c - 1);
+		dlx->right[c] = (int16_t)(c == DLX_COLUMNS ? 0 : c + 1);
+		dlx->up[c] = (int16_t)c;
+		dlx->down[c] = (int16_t)c;
+		dlx->column[c] = (int16_t)c;
+		dlx->rowId[c] = -1;
+	}
+	for (int row = 0; row < DLX_ROWS; row++) {
+		int cell = row / 9, d = row % 9;
+		int r = cell / GRID_SIZE, c = cell % GRID_SIZE, b = (r / 3) * 3 + c / 3;
+		int cols[4] = {
+			1 + cell,
+			1 + 81 + r * 9 + d,
+			1 + 162 + c * 9 + d,
+			1 + 243 + b * 9 + d
+		};
+		int first = firstNodeOfRow(row);
+		for (int k = 0; k < 4; k++) {
+			int n = first + k, col = cols[k];
+			dlx->column[n] = (int16_t)col;
+			dlx->rowId[n] = (int16_t)row;
+			dlx->left[n] = (int16_t)(first + (k + 3) % 4);
+			dlx->right[n] = (int16_t)(first + (k + 1) % 4);
+			dlx->up[n] = dlx->up[col];
+			dlx->down[n] = (int16_t)col;
+			dlx->down[dlx->up[col]] = (int16_t)n;
+			dlx->up[col] = (int16_t)n;
+			dlx->size[col]++;
+		}
+	}
+}
+
+static void cover(DlxSolver *dlx, int col) {
+	dlx->right[dlx->left[col]] = dlx->right[col];
+	dlx->left[dlx->right[col]] = dlx->left[col];
+	for (int i = dlx->down[col]; i != col; i = dlx->down[i]) {
+		for (int j = dlx->right[i]; j != i; j = dlx->right[j]) {
+			dlx->down[dlx->up[j]] = dlx->down[j];
+			dlx->up[dlx->down[j]] = dlx->up[j];
+			dlx->size[dlx->column[j]]--;
+		}
+	}
+}
+
+static void uncover(DlxSolver *dlx, int col) {
+	for (int i = dlx->up[col]; i != col; i = dlx->up[i]) {
+		for (int j = dlx->left[i]; j != i; j = dlx->left[j]) {
+			dlx->size[dlx->column[j]]++;
+			dlx->down[dlx->up[j]] = (int16_t)j;
+			dlx->up[dlx->down[j]] = (int16_t)j;
+		}
+	}
+	dlx->right[dlx->left[col]] = (int16_t)col;
+	dlx->left[dlx->right[col]] = (int16_t)col;
+}
+
+static void recordSolution(DlxSolver *dlx) {
+	for (int k = 0; k < dlx->depth; k++) {
+		int row = dlx->stack[k];
+		dlx->solution.cells[row / 9] = (uint8_t)(row % 9 + 1);
+	}
+}
+
+static void search(DlxSolver *dlx) {
+	if (dlx->right[ROOT] == ROOT) {
+		if (dlx->found == 0) recordSolution(dlx);
+		dlx->found++;
+		return;
+	}
+	int best = dlx->right[ROOT];
+	for (int c = dlx->right[best]; c != ROOT; c = dlx->right[c]) {
+		if (dlx->size[c] < dlx->size[best]) best = c;
+	}
+	if (dlx->size[best] == 0) return;
+	cover(dlx, best);
+	for (int i = dlx->down[best]; i != best; i = dlx->down[i]) {
+		dlx->nodes++;
+		dlx->stack[dlx->depth++] = dlx->rowId[i];
+		STATS_DEPTH(dlx->stats, dlx->depth - dlx->baseDepth);
+		for (int j = dlx->right[i]; j != i; j = dlx->right[j]) cover(dlx, dlx->column[j]);
+#if SOLVER_STATS_ENABLED
+		int foundBefore = dlx->found;
+#endif
+		search(dlx);
+#if SOLVER_STATS_ENABLED
+		if (dlx->found == foundBefore) STATS_ADD(dlx->stats, backtracks, 1);
+#endif
+		for (int j = dlx->left[i]; j != i; j = dlx->left[j]) uncover(dlx, dlx->column[j]);
+		dlx->depth--;
+		if (dlx->limit > 0 && dlx->found >= dlx->limit) break;
+	}
+	uncover(dlx, best);
+}
+
+// A column is still linked into the header list exactly when it is uncovered.
+static bool isColumnActive(const DlxSolver *dlx, int col) {
+	return dlx->right[dlx->left[col]] == col;
+}
+
+int solveDlx(DlxSolver *dlx, const Board *board, int limit, Board *solution, unsigned long long *outNodes) {
+	dlx->depth = 0;
+	dlx->found = 0;
+	dlx->nodes = 0;
+	dlx->limit = limit;
+	int givens = 0;
+	bool consistent = true;
+	STATS_CLOCK(setupStart);
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		int v = board->cells[cell];
+		if (v == 0) continue;
+		if (v > 9) { consistent = false; break; }
+		int row = cell * 9 + (v - 1);
+		int first = firstNodeOfRow(row);
+		bool available = true;
+		for (int k = 0; k < 4; k++) available = available && isColumnActive(dlx, dlx->column[first + k]);
+		if (!available) { consistent = false; break; }
+		for (int k = 0; k < 4; k++) cover(dlx, dlx->column[first + k]);
+		dlx->stack[dlx->depth++] = (int16_t)row;
+		givens++;
+	}
+	dlx->baseDepth = dlx->depth;
+	STATS_ELAPSED(dlx->stats, setupSeconds, setupStart);
+	if (consistent) search(dlx);
+	while (givens-- > 0) {
+		int first = firstNodeOfRow(dlx->stack[--dlx->depth]);
+		for (int k = 3; k >= 0; k--) uncover(dlx, dlx->column[first + k]);
+	}
+	if (outNodes) *outNodes = dlx->nodes;
+	if (dlx->found > 0 && solution) *solution = dlx->solution;
+	return dlx->found;
+}
@@ -0,0 +1,40 @@
+#ifndef DLX_H
+#define DLX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "structs.h"
+#include "solver_stats.h"
+
+#define DLX_COLUMNS 324                          // cell, row-digit, column-digit and box-digit constraints
+#define DLX_ROWS 729                             // one per (cell, digit) candidate
+#define DLX_NODES (1 + DLX_COLUMNS + DLX_ROWS * 4) // root header, column headers, then 4 nodes per row
+
+// Exact-cover matrix for Sudoku stored as index links in one fixed arena. The matrix is
+// built once; each solve covers the givens, searches, and uncovers everything again,
+// so the same solver is reused across puzzles without allocating.
+typedef struct DlxSolver {
+	int16_t left[DLX_NODES];
+	int16_t right[DLX_NODES];
+	int16_t up[DLX_NODES];
+	int16_t down[DLX_NODES];
+	int16_t column[DLX_NODES];
+	int16_t rowId[DLX_NODES];
+	int16_t size[1 + DLX_COLUMNS];
+	int16_t stack[CELL_COUNT];
+	int depth;
+	int limit;
+	int found;
+	unsigned long long nodes;
+	Board solution;
+	SolverStats *stats;  // set by the caller for one solve; NULL otherwise
+	int baseDepth;       // stack entries taken by the givens
+} DlxSolver;
+
+void initDlxSolver(DlxSolver *dlx);
+
+// Counts solutions up to limit (limit <= 0 means no limit). The first solution found is
+// copied into solution when it is non-NULL; outNodes (optional) receives rows tried.
+int solveDlx(DlxSolver *dlx, const Board *board, int limit, Board *solution, unsigned long long *outNodes);
+
+#endif
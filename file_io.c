@@ -1,202 +1,321 @@
-#include <stdio.h>
-#include <string.h>
-#include <sys/stat.h>
-#include <errno.h>
-#include <stdlib.h>
-#ifdef _WIN32
-#include <direct.h>
-#include <windows.h>
-#endif
-#include "file_io.h"
-
-static void copyString(char *dst, const char *src, size_t dstSize) {
-	if (!dst || !src || dstSize == 0) return;
-	size_t i = 0;
-	while (i + 1 < dstSize && src[i] != '\0') {
-		dst[i] = src[i];
-		i++;
-	}
-	dst[i] = '\0';
-}
-
-bool saveGameState(const GameState *state, const char *path) {
-	FILE *f = fopen(path, "wb");
-	if (!f) return false;
-	size_t wrote = fwrite(state, 1, sizeof(*state), f);
-	fclose(f);
-	return wrote == sizeof(*state);
-}
-
-bool loadGameState(GameState *state, const char *path) {
-	FILE *f = fopen(path, "rb");
-	if (!f) return false;
-	size_t read = fread(state, 1, sizeof(*state), f);
-	fclose(f);
-	return read == sizeof(*state);
-}
-
-bool appendHighScore(const char *difficulty, const char *puzzleName, unsigned int seconds, const char *path) {
-	FILE *f = fopen(path, "a");
-	if (!f) return false;
-	int ok = fprintf(f, "%s\t%s\t%u\n", difficulty, puzzleName, seconds);
-	fclose(f);
-	return ok > 0;
-}
-
-void printHighScores(const char *path) {
-	FILE *f = fopen(path, "r");
-	if (!f) {
-		printf("No high scores yet.\n");
-		return;
-	}
-	char line[256];
-	printf("High Scores (difficulty\tpuzzle\tseconds)\n");
-	while (fgets(line, sizeof(line), f)) {
-		printf("%s", line);
-	}
-	fclose(f);
-}
-
-typedef struct ParsedScore { char diff[32]; char name[64]; unsigned int sec; } ParsedScore;
-
-static int cmpScore(const void *a, const void *b) {
-	const ParsedScore *sa = (const ParsedScore*)a;
-	const ParsedScore *sb = (const ParsedScore*)b;
-	if (sa->sec < sb->sec) return -1;
-	if (sa->sec > sb->sec) return 1;
-	return strcmp(sa->name, sb->name);
-}
-
-void printTopHighScores(const char *path, int topN) {
-	FILE *f = fopen(path, "r");
-	if (!f) { printf("No high scores yet.\n"); return; }
-	ParsedScore arr[256]; int n = 0;
-	char line[256];
-	while (fgets(line, sizeof(line), f) && n < 256) {
-		char diff[32], name[64]; unsigned int sec;
-		if (sscanf(line, "%31[^\t]\t%63[^\t]\t%u", diff, name, &sec) == 3) {
-            copyString(arr[n].diff, diff, sizeof(arr[n].diff));
-            copyString(arr[n].name, name, sizeof(arr[n].name));
-			arr[n].sec = sec; n++;
-		}
-	}
-	fclose(f);
-	qsort(arr, n, sizeof(arr[0]), cmpScore);
-	if (n == 0) { printf("No high scores yet.\n"); return; }
-	if (topN <= 0) topN = 10;
-	printf("Top %d High Scores (best times)\n", topN);
-	for (int i = 0; i < n && i < topN; i++) {
-		unsigned int m = (arr[i].sec / 60) % 60, s = arr[i].sec % 60;
-		printf("%2d) %s | %s | %02u:%02u\n", i + 1, arr[i].diff, arr[i].name, m, s);
-	}
-}
-
-static int parseGrid81(const char *digits, int grid[GRID_SIZE][GRID_SIZE]) {
-	int len = (int)strlen(digits);
-	if (len < 81) return 0;
-	int k = 0;
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			char ch = digits[k++];
-			if (ch < '0' || ch > '9') return 0;
-			grid[r][c] = ch - '0';
-		}
-	}
-	return 1;
-}
-
-bool loadPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty) {
-	FILE *f = fopen(path, "r");
-	if (!f) return false;
-	char line[256];
-	while (fgets(line, sizeof(line), f)) {
-		// name|difficulty|digits
-		char *p1 = strchr(line, '|');
-		if (!p1) continue;
-		*p1 = '\0';
-		char *p2 = strchr(p1 + 1, '|');
-		if (!p2) continue;
-		*p2 = '\0';
-		char *name = line;
-		char *diff = p1 + 1;
-		char *digits = p2 + 1;
-		char *nl = strchr(digits, '\n'); if (nl) *nl = '\0';
-		if (strcmp(diff, difficulty) != 0) continue;
-		memset(out, 0, sizeof(*out));
-        copyString(out->name, name, sizeof(out->name));
-        copyString(out->difficulty, diff, sizeof(out->difficulty));
-		if (!parseGrid81(digits, out->grid)) continue;
-		fclose(f);
-		return true;
-	}
-	fclose(f);
-	return false;
-}
-
-static void sanitizeFilename(char *s) {
-	for (char *p = s; *p; ++p) {
-		if (*p == ' ' || *p == '/' || *p == '\\' || *p == '|' || *p == ':' || *p == '*' || *p == '?' || *p == '"' || *p == '<' || *p == '>' ) {
-			*p = '_';
-		}
-	}
-}
-
-bool saveGameStateAuto(const GameState *state, char *outPath, size_t outPathSize) {
-	#ifdef _WIN32
-		_mkdir("saves");
-	#else
-		mkdir("saves", 0777);
-	#endif
-	char filename[256];
-    copyString(filename, state->activePuzzleName[0] ? state->activePuzzleName : "unnamed", sizeof(filename));
-	sanitizeFilename(filename);
-	char path[320];
-	snprintf(path, sizeof(path), "saves/%s.sav", filename);
-	bool ok = saveGameState(state, path);
-	if (outPath && outPathSize) {
-        copyString(outPath, path, outPathSize);
-	}
-	return ok;
-}
-
-int listSaveFiles(char names[][260], int maxCount) {
-	int count = 0;
-#ifdef _WIN32
-	WIN32_FIND_DATAA ffd;
-	HANDLE hFind = FindFirstFileA("saves\\*.sav", &ffd);
-	if (hFind == INVALID_HANDLE_VALUE) return 0;
-	do {
-		if (!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            copyString(names[count], ffd.cFileName, 260);
-			count++;
-			if (count >= maxCount) break;
-		}
-	} while (FindNextFileA(hFind, &ffd));
-	FindClose(hFind);
-#else
-	DIR *dir = opendir("saves");
-	if (!dir) return 0;
-	struct dirent *ent;
-	while ((ent = readdir(dir)) != NULL && count < maxCount) {
-		if (ent->d_type == DT_REG) {
-			const char *n = ent->d_name;
-			size_t len = strlen(n);
-			if (len > 4 && strcmp(n + len - 4, ".sav") == 0) {
-                copyString(names[count], n, 260);
-				count++;
-			}
-		}
-	}
-	closedir(dir);
-#endif
-	return count;
-}
-
-bool deleteSaveFile(const char *baseName) {
-	char path[320];
-	snprintf(path, sizeof(path), "saves/%s", baseName);
-	int rc = remove(path);
-	return rc == 0;
-}
-
-
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "file_io.h"
+#include "puzzle_pack.h"
+#include "save_format.h"
+
+static void copyString(char *dst, const char *src, size_t dstSize) {
+	if (!dst || !src || dstSize == 0) return;
+	size_t i = 0;
+	while (i + 1 < dstSize && src[i] != '\0') {
+		dst[i] = src[i];
+		i++;
+	}
+	dst[i] = '\0';
+}
+
+bool syncFile(FILE *f) {
+	if (fflush(f) != 0) return false;
+#ifdef _WIN32
+	return _commit(_fileno(f)) == 0;
+#else
+	return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Makes a completed rename durable; directories cannot be opened for syncing on Windows.
+static void syncParentDirectory(const char *path) {
+#ifndef _WIN32
+	char dir[320];
+	copyString(dir, path, sizeof(dir));
+	char *slash = strrchr(dir, '/');
+	if (slash) *slash = '\0';
+	else copyString(dir, ".", sizeof(dir));
+	int fd = open(dir, O_RDONLY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+#else
+	(void)path;
+#endif
+}
+
+bool writeFileAtomically(const char *path, const void *data, size_t size) {
+	char tempPath[340];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+	FILE *f = fopen(tempPath, "wb");
+	if (!f) return false;
+	bool ok = fwrite(data, 1, size, f) == size && syncFile(f);
+	if (fclose(f) != 0) ok = false;
+#ifdef _WIN32
+	ok = ok && MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	ok = ok && rename(tempPath, path) == 0;
+#endif
+	if (!ok) {
+		remove(tempPath);
+		return false;
+	}
+	syncParentDirectory(path);
+	return true;
+}
+
+bool saveGameState(const GameState *state, const char *path) {
+	uint8_t *buffer = (uint8_t*)malloc(encodedGameStateSize(state));
+	if (!buffer) return false;
+	size_t size = encodeGameState(state, buffer);
+	bool ok = writeFileAtomically(path, buffer, size);
+	free(buffer);
+	return ok;
+}
+
+uint8_t *readWholeFile(const char *path, size_t *outSize) {
+	FILE *f = fopen(path, "rb");
+	if (!f) return NULL;
+	size_t capacity = 4096, size = 0;
+	uint8_t *data = (uint8_t*)malloc(capacity);
+	while (data) {
+		size += fread(data + size, 1, capacity - size, f);
+		if (size < capacity) break;
+		capacity *= 2;
+		uint8_t *grown = (uint8_t*)realloc(data, capacity);
+		if (!grown) free(data);
+		data = grown;
+	}
+	bool failed = ferror(f) != 0;
+	fclose(f);
+	if (failed) {
+		free(data);
+		return NULL;
+	}
+	*outSize = size;
+	return data;
+}
+
+bool loadGameState(GameState *state, const char *path) {
+	size_t size;
+	uint8_t *data = readWholeFile(path, &size);
+	if (!data) return false;
+	bool ok = decodeGameState(data, size, state);
+	free(data);
+	return ok;
+}
+
+int parseGrid81(const char *digits, Board *board) {
+	int len = (int)strlen(digits);
+	if (len < 81) return 0;
+	for (int k = 0; k < CELL_COUNT; k++) {
+		char ch = digits[k];
+		if (ch < '0' || ch > '9') return 0;
+		board->cells[k] = (uint8_t)(ch - '0');
+	}
+	return 1;
+}
+
+void formatGrid81(const Board *board, char out[82]) {
+	for (int k = 0; k < CELL_COUNT; k++) {
+		out[k] = (char)('0' + board->cells[k]);
+	}
+	out[CELL_COUNT] = '\0';
+}
+
+bool openLineReader(LineReader *reader, const char *path) {
+	memset(reader, 0, sizeof(*reader));
+	if (strcmp(path, "-") == 0) {
+		reader->file = stdin;
+	} else {
+		reader->file = fopen(path, "rb");
+		if (!reader->file) return false;
+		reader->ownsFile = true;
+	}
+	reader->buffer = (char*)malloc(LINE_READER_CAPACITY + 1);
+	if (!reader->buffer) {
+		closeLineReader(reader);
+		return false;
+	}
+	return true;
+}
+
+static char *takeLine(LineReader *reader, char *end, size_t *outLen) {
+	char *line = reader->buffer + reader->start;
+	size_t len = (size_t)(end - line);
+	reader->lineOffset = reader->bufferOffset + reader->start;
+	reader->start += len + 1;
+	if (len > 0 && line[len - 1] == '\r') len--;
+	line[len] = '\0';
+	reader->lineNumber++;
+	if (outLen) *outLen = len;
+	return line;
+}
+
+char *readNextLine(LineReader *reader, size_t *outLen) {
+	for (;;) {
+		char *begin = reader->buffer + reader->start;
+		char *nl = (char*)memchr(begin, '\n', reader->end - reader->start);
+		if (nl) {
+			if (reader->skipping) {
+				// Remainder of an overlong line that was already returned truncated.
+				reader->skipping = false;
+				reader->start += (size_t)(nl - begin) + 1;
+				continue;
+			}
+			return takeLine(reader, nl, outLen);
+		}
+		if (reader->eof) {
+			if (reader->start == reader->end || reader->skipping) return NULL;
+			char *line = takeLine(reader, reader->buffer + reader->end, outLen);
+			reader->start = reader->end;
+			return line;
+		}
+		if (reader->skipping) {
+			reader->bufferOffset += reader->end;
+			reader->start = reader->end = 0;
+		} else if (reader->start > 0) {
+			memmove(reader->buffer, begin, reader->end - reader->start);
+			reader->bufferOffset += reader->start;
+			reader->end -= reader->start;
+			reader->start = 0;
+		} else if (reader->end == LINE_READER_CAPACITY) {
+			reader->skipping = true;
+			char *line = takeLine(reader, reader->buffer + reader->end, outLen);
+			reader->bufferOffset += reader->end;
+			reader->start = reader->end = 0;
+			return line;
+		}
+		size_t got = fread(reader->buffer + reader->end, 1, LINE_READER_CAPACITY - reader->end, reader->file);
+		if (got == 0) reader->eof = true;
+		reader->end += got;
+	}
+}
+
+void closeLineReader(LineReader *reader) {
+	if (reader->ownsFile && reader->file) fclose(reader->file);
+	free(reader->buffer);
+	reader->file = NULL;
+	reader->buffer = NULL;
+}
+
+bool parsePuzzleLine(char *line, Puzzle *out) {
+	// name|difficulty|digits
+	char *p1 = strchr(line, '|');
+	if (!p1) return false;
+	char *p2 = strchr(p1 + 1, '|');
+	if (!p2) return false;
+	*p1 = '\0';
+	*p2 = '\0';
+	char *digits = p2 + 1;
+	char *nl = strpbrk(digits, "\r\n"); if (nl) *nl = '\0';
+	memset(out, 0, sizeof(*out));
+	copyString(out->name, line, sizeof(out->name));
+	copyString(out->difficulty, p1 + 1, sizeof(out->difficulty));
+	return parseGrid81(digits, &out->grid) != 0;
+}
+
+bool loadPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty) {
+	if (isPuzzlePackFile(path)) return loadPackPuzzleByDifficulty(out, path, difficulty);
+	FILE *f = fopen(path, "r");
+	if (!f) return false;
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		if (!parsePuzzleLine(line, out)) continue;
+		if (strcmp(out->difficulty, difficulty) != 0) continue;
+		fclose(f);
+		return true;
+	}
+	fclose(f);
+	return false;
+}
+
+static void sanitizeFilename(char *s) {
+	for (char *p = s; *p; ++p) {
+		if (*p == ' ' || *p == '/' || *p == '\\' || *p == '|' || *p == ':' || *p == '*' || *p == '?' || *p == '"' || *p == '<' || *p == '>' ) {
+			*p = '_';
+		}
+	}
+}
+
+void gameSavePath(const GameState *state, char *outPath, size_t outPathSize) {
+	#ifdef _WIN32
+		_mkdir("saves");
+	#else
+		mkdir("saves", 0777);
+	#endif
+	char filename[256];
+    copyString(filename, state->activePuzzleName[0] ? state->activePuzzleName : "unnamed", sizeof(filename));
+	sanitizeFilename(filename);
+	snprintf(outPath, outPathSize, "saves/%s.sav", filename);
+}
+
+void saveJournalPath(const char *savePath, char *outPath, size_t outPathSize) {
+	size_t len = strlen(savePath);
+	if (len > 4 && strcmp(savePath + len - 4, ".sav") == 0) len -= 4;
+	snprintf(outPath, outPathSize, "%.*s.jnl", (int)len, savePath);
+}
+
+bool saveGameStateAuto(const GameState *state, char *outPath, size_t outPathSize) {
+	char path[320];
+	gameSavePath(state, path, sizeof(path));
+	bool ok = saveGameState(state, path);
+	if (outPath && outPathSize) {
+        copyString(outPath, path, outPathSize);
+	}
+	return ok;
+}
+
+int listSaveFiles(char names[][260], int maxCount) {
+	int count = 0;
+#ifdef _WIN32
+	WIN32_FIND_DATAA ffd;
+	HANDLE hFind = FindFirstFileA("saves\\*.sav", &ffd);
+	if (hFind == INVALID_HANDLE_VALUE) return 0;
+	do {
+		if (!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            copyString(names[count], ffd.cFileName, 260);
+			count++;
+			if (count >= maxCount) break;
+		}
+	} while (FindNextFileA(hFind, &ffd));
+	FindClose(hFind);
+#else
+	DIR *dir = opendir("saves");
+	if (!dir) return 0;
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL && count < maxCount) {
+		if (ent->d_type == DT_REG) {
+			const char *n = ent->d_name;
+			size_t len = strlen(n);
+			if (len > 4 && strcmp(n + len - 4, ".sav") == 0) {
+                copyString(names[count], n, 260);
+				count++;
+			}
+		}
+	}
+	closedir(dir);
+#endif
+	return count;
+}
+
+bool deleteSaveFile(const char *baseName) {
+	char path[320];
+	snprintf(path, sizeof(path), "saves/%s", baseName);
+	int rc = remove(path);
+	char journal[330];
+	saveJournalPath(path, journal, sizeof(journal));
+	remove(journal);
+	return rc == 0;
+}
+
+
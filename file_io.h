@@ -1,24 +1,68 @@
-#ifndef FILE_IO_H
-#define FILE_IO_H
-
-#include <stdbool.h>
-#include "structs.h"
-
-bool saveGameState(const GameState *state, const char *path);
-bool loadGameState(GameState *state, const char *path);
-
-bool appendHighScore(const char *difficulty, const char *puzzleName, unsigned int seconds, const char *path);
-void printHighScores(const char *path);
-void printTopHighScores(const char *path, int topN);
-
-bool loadPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty);
-
-bool saveGameStateAuto(const GameState *state, char *outPath, size_t outPathSize);
-
-int listSaveFiles(char names[][260], int maxCount);
-
-bool deleteSaveFile(const char *baseName);
-
-#endif 
-
-
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "structs.h"
+
+#define LINE_READER_CAPACITY (1 << 16)
+
+// Streams lines from a file (or stdin for "-") through one fixed buffer.
+typedef struct LineReader {
+	FILE *file;
+	bool ownsFile;
+	char *buffer;
+	size_t start;
+	size_t end;
+	bool eof;
+	bool skipping;
+	unsigned long long lineNumber;
+	unsigned long long bufferOffset; // file offset of buffer[0]
+	unsigned long long lineOffset;   // file offset of the line last returned
+} LineReader;
+
+// Saves use the versioned format in save_format.h and replace the file atomically;
+// loading also accepts raw struct dumps written by older builds. A loaded state owns its
+// move history (freeMoveHistory).
+bool saveGameState(const GameState *state, const char *path);
+bool loadGameState(GameState *state, const char *path);
+
+int parseGrid81(const char *digits, Board *board);
+void formatGrid81(const Board *board, char out[82]);
+
+bool openLineReader(LineReader *reader, const char *path);
+// Returns the next line without its newline, or NULL at end of input. Lines longer
+// than LINE_READER_CAPACITY are returned truncated.
+char *readNextLine(LineReader *reader, size_t *outLen);
+void closeLineReader(LineReader *reader);
+
+// Parses one "name|difficulty|digits" line in place. Returns false for malformed lines.
+bool parsePuzzleLine(char *line, Puzzle *out);
+
+// Returns the first puzzle of the given difficulty by scanning the whole file, which may be
+// a text file or a binary pack (puzzle_pack.h); see puzzle_library.h for indexed lookup.
+bool loadPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty);
+
+// Reads a file into a malloc'd buffer; NULL on failure.
+uint8_t *readWholeFile(const char *path, size_t *outSize);
+
+// Flushes stdio buffers and asks the OS to put the file on disk.
+bool syncFile(FILE *f);
+// Writes data to path.tmp, syncs it and renames it over path, so path always holds
+// either the old or the new contents.
+bool writeFileAtomically(const char *path, const void *data, size_t size);
+
+// saves/<puzzle name>.sav, creating saves/ if needed.
+void gameSavePath(const GameState *state, char *outPath, size_t outPathSize);
+// The move journal kept next to a save (see autosave.h).
+void saveJournalPath(const char *savePath, char *outPath, size_t outPathSize);
+
+bool saveGameStateAuto(const GameState *state, char *outPath, size_t outPathSize);
+
+int listSaveFiles(char names[][260], int maxCount);
+
+bool deleteSaveFile(const char *baseName);
+
+#endif 
+
+
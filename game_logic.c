@@ -1,98 +1,269 @@
-#include "game_logic.h"
-
-static bool isInRow(const int grid[GRID_SIZE][GRID_SIZE], int row, int value) {
-	for (int c = 0; c < GRID_SIZE; c++) {
-		if (grid[row][c] == value) return true;
-	}
-	return false;
-}
-
-static bool isInCol(const int grid[GRID_SIZE][GRID_SIZE], int col, int value) {
-	for (int r = 0; r < GRID_SIZE; r++) {
-		if (grid[r][col] == value) return true;
-	}
-	return false;
-}
-
-static bool isInBox(const int grid[GRID_SIZE][GRID_SIZE], int startRow, int startCol, int value) {
-	for (int r = 0; r < 3; r++) {
-		for (int c = 0; c < 3; c++) {
-			if (grid[startRow + r][startCol + c] == value) return true;
-		}
-	}
-	return false;
-}
-
-bool isMoveValid(const int grid[GRID_SIZE][GRID_SIZE], int row, int col, int value) {
-	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return false;
-	if (value < 1 || value > 9) return false;
-	if (grid[row][col] != 0) return false; // can't place over existing number
-
-	if (isInRow(grid, row, value)) return false;
-	if (isInCol(grid, col, value)) return false;
-	int boxRow = (row / 3) * 3;
-	int boxCol = (col / 3) * 3;
-	if (isInBox(grid, boxRow, boxCol, value)) return false;
-
-	return true;
-}
-
-int computePossibilities(const int grid[GRID_SIZE][GRID_SIZE], int row, int col, int poss[10]) {
-	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return 0;
-	for (int i = 0; i <= 9; i++) poss[i] = 0;
-	if (grid[row][col] != 0) return 0;
-	int count = 0;
-	for (int v = 1; v <= 9; v++) {
-		if (isMoveValid(grid, row, col, v)) {
-			poss[v] = 1;
-			count++;
-		}
-	}
-	return count;
-}
-
-static bool allOneToNineUnique(const int values[GRID_SIZE]) {
-	int seen[10] = {0};
-	for (int i = 0; i < GRID_SIZE; i++) {
-		int v = values[i];
-		if (v < 1 || v > 9) return false;
-		if (seen[v]) return false;
-		seen[v] = 1;
-	}
-	return true;
-}
-
-bool isBoardComplete(const int grid[GRID_SIZE][GRID_SIZE]) {
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			if (grid[r][c] == 0) return false;
-		}
-	}
-	return true;
-}
-
-bool isBoardValid(const int grid[GRID_SIZE][GRID_SIZE]) {
-	int buf[GRID_SIZE];
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) buf[c] = grid[r][c];
-		if (!allOneToNineUnique(buf)) return false;
-	}
-	for (int c = 0; c < GRID_SIZE; c++) {
-		for (int r = 0; r < GRID_SIZE; r++) buf[r] = grid[r][c];
-		if (!allOneToNineUnique(buf)) return false;
-	}
-	for (int br = 0; br < 3; br++) {
-		for (int bc = 0; bc < 3; bc++) {
-			int k = 0;
-			for (int r = 0; r < 3; r++) {
-				for (int c = 0; c < 3; c++) {
-					buf[k++] = grid[br * 3 + r][bc * 3 + c];
-				}
-			}
-			if (!allOneToNineUnique(buf)) return false;
-		}
-	}
-	return true;
-}
-
-
+#include <string.h>
+#include <time.h>
+#include "game_logic.h"
+#include "board.h"
+#include "bitmask.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAME_LOGIC_SSE2 1
+#endif
+
+#define INVALID_CELL_BIT 0x200u
+
+// Board rows widened to 16 lanes of 16-bit digit bits (lanes 9-15 stay zero), so one row is
+// a single AVX2 register or two SSE2 registers. The kernels below are written once against
+// these helpers; the scalar versions are the portable fallback.
+#if defined(__AVX2__)
+typedef __m256i Lanes;
+static inline Lanes lanesLoad(const uint16_t *p) { return _mm256_load_si256((const __m256i*)p); }
+static inline void lanesStore(uint16_t *p, Lanes v) { _mm256_store_si256((__m256i*)p, v); }
+static inline Lanes lanesZero(void) { return _mm256_setzero_si256(); }
+static inline Lanes lanesSplat(uint16_t x) { return _mm256_set1_epi16((short)x); }
+static inline Lanes lanesOr(Lanes a, Lanes b) { return _mm256_or_si256(a, b); }
+static inline Lanes lanesAdd(Lanes a, Lanes b) { return _mm256_add_epi16(a, b); }
+static inline Lanes lanesAnd(Lanes a, Lanes b) { return _mm256_and_si256(a, b); }
+static inline Lanes lanesAndNot(Lanes a, Lanes b) { return _mm256_andnot_si256(a, b); }
+static inline Lanes lanesIsZero(Lanes a) { return _mm256_cmpeq_epi16(a, _mm256_setzero_si256()); }
+#elif defined(GAME_LOGIC_SSE2)
+typedef struct Lanes { __m128i lo, hi; } Lanes;
+static inline Lanes lanesLoad(const uint16_t *p) {
+	Lanes v = { _mm_load_si128((const __m128i*)p), _mm_load_si128((const __m128i*)(p + 8)) };
+	return v;
+}
+static inline void lanesStore(uint16_t *p, Lanes v) {
+	_mm_store_si128((__m128i*)p, v.lo);
+	_mm_store_si128((__m128i*)(p + 8), v.hi);
+}
+static inline Lanes lanesZero(void) { Lanes v = { _mm_setzero_si128(), _mm_setzero_si128() }; return v; }
+static inline Lanes lanesSplat(uint16_t x) { Lanes v = { _mm_set1_epi16((short)x), _mm_set1_epi16((short)x) }; return v; }
+static inline Lanes lanesOr(Lanes a, Lanes b) { Lanes v = { _mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi) }; return v; }
+static inline Lanes lanesAdd(Lanes a, Lanes b) { Lanes v = { _mm_add_epi16(a.lo, b.lo), _mm_add_epi16(a.hi, b.hi) }; return v; }
+static inline Lanes lanesAnd(Lanes a, Lanes b) { Lanes v = { _mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi) }; return v; }
+static inline Lanes lanesAndNot(Lanes a, Lanes b) { Lanes v = { _mm_andnot_si128(a.lo, b.lo), _mm_andnot_si128(a.hi, b.hi) }; return v; }
+static inline Lanes lanesIsZero(Lanes a) {
+	Lanes v = { _mm_cmpeq_epi16(a.lo, _mm_setzero_si128()), _mm_cmpeq_epi16(a.hi, _mm_setzero_si128()) };
+	return v;
+}
+#else
+typedef struct Lanes { uint16_t v[16]; } Lanes;
+static inline Lanes lanesLoad(const uint16_t *p) { Lanes v; memcpy(v.v, p, sizeof(v.v)); return v; }
+static inline void lanesStore(uint16_t *p, Lanes v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline Lanes lanesZero(void) { Lanes v; memset(&v, 0, sizeof(v)); return v; }
+static inline Lanes lanesSplat(uint16_t x) { Lanes v; for (int i = 0; i < 16; i++) v.v[i] = x; return v; }
+static inline Lanes lanesOr(Lanes a, Lanes b) { for (int i = 0; i < 16; i++) a.v[i] |= b.v[i]; return a; }
+static inline Lanes lanesAdd(Lanes a, Lanes b) { for (int i = 0; i < 16; i++) a.v[i] = (uint16_t)(a.v[i] + b.v[i]); return a; }
+static inline Lanes lanesAnd(Lanes a, Lanes b) { for (int i = 0; i < 16; i++) a.v[i] &= b.v[i]; return a; }
+static inline Lanes lanesAndNot(Lanes a, Lanes b) { for (int i = 0; i < 16; i++) a.v[i] = (uint16_t)(~a.v[i] & b.v[i]); return a; }
+static inline Lanes lanesIsZero(Lanes a) { for (int i = 0; i < 16; i++) a.v[i] = a.v[i] ? 0 : 0xFFFF; return a; }
+#endif
+
+// OR and sum of the digit bits of each unit (rows 0-8, columns 9-17, boxes 18-26). Within a
+// unit the sum equals the OR exactly when no digit repeats.
+typedef struct UnitSummary {
+	_Alignas(32) uint16_t bits[GRID_SIZE][16];
+	uint16_t orMask[3 * GRID_SIZE];
+	uint16_t sum[3 * GRID_SIZE];
+} UnitSummary;
+
+static void summarizeUnits(const Board *board, UnitSummary *u) {
+	static const uint16_t digitBits[10] = { 0, 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+	memset(u->bits, 0, sizeof(u->bits));
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			int v = board->cells[r * GRID_SIZE + c];
+			u->bits[r][c] = v <= 9 ? digitBits[v] : (uint16_t)INVALID_CELL_BIT;
+		}
+	}
+	_Alignas(32) uint16_t lanes[16];
+	Lanes colOr = lanesZero(), colSum = lanesZero();
+	for (int band = 0; band < 3; band++) {
+		Lanes bandOr = lanesZero(), bandSum = lanesZero();
+		for (int k = 0; k < 3; k++) {
+			int r = band * 3 + k;
+			Lanes row = lanesLoad(u->bits[r]);
+			bandOr = lanesOr(bandOr, row);
+			bandSum = lanesAdd(bandSum, row);
+			// A row's digits lie across the lanes, and the helpers only combine lanes
+			// position by position. Reducing rows with them needs the grid transposed
+			// first, which measured slower in `make bench` than this loop (isBoardValid
+			// about 220 ns a board against 145 ns), so rows stay scalar.
+			unsigned int rowOr = 0, rowSum = 0;
+			for (int c = 0; c < GRID_SIZE; c++) {
+				rowOr |= u->bits[r][c];
+				rowSum += u->bits[r][c];
+			}
+			u->orMask[r] = (uint16_t)rowOr;
+			u->sum[r] = (uint16_t)rowSum;
+		}
+		colOr = lanesOr(colOr, bandOr);
+		colSum = lanesAdd(colSum, bandSum);
+		lanesStore(lanes, bandOr);
+		for (int s = 0; s < 3; s++) u->orMask[18 + band * 3 + s] = (uint16_t)(lanes[s * 3] | lanes[s * 3 + 1] | lanes[s * 3 + 2]);
+		lanesStore(lanes, bandSum);
+		for (int s = 0; s < 3; s++) u->sum[18 + band * 3 + s] = (uint16_t)(lanes[s * 3] + lanes[s * 3 + 1] + lanes[s * 3 + 2]);
+	}
+	lanesStore(lanes, colOr);
+	for (int c = 0; c < GRID_SIZE; c++) u->orMask[9 + c] = lanes[c];
+	lanesStore(lanes, colSum);
+	for (int c = 0; c < GRID_SIZE; c++) u->sum[9 + c] = lanes[c];
+}
+
+static bool isInRow(const Board *board, int row, int value) {
+	for (int c = 0; c < GRID_SIZE; c++) {
+		if (boardGet(board, row, c) == value) return true;
+	}
+	return false;
+}
+
+static bool isInCol(const Board *board, int col, int value) {
+	for (int r = 0; r < GRID_SIZE; r++) {
+		if (boardGet(board, r, col) == value) return true;
+	}
+	return false;
+}
+
+static bool isInBox(const Board *board, int startRow, int startCol, int value) {
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 3; c++) {
+			if (boardGet(board, startRow + r, startCol + c) == value) return true;
+		}
+	}
+	return false;
+}
+
+bool isMoveValid(const Board *board, int row, int col, int value) {
+	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return false;
+	if (value < 1 || value > 9) return false;
+	if (boardGet(board, row, col) != 0) return false; // can't place over existing number
+
+	if (isInRow(board, row, value)) return false;
+	if (isInCol(board, col, value)) return false;
+	int boxRow = (row / 3) * 3;
+	int boxCol = (col / 3) * 3;
+	if (isInBox(board, boxRow, boxCol, value)) return false;
+
+	return true;
+}
+
+int computePossibilities(const Board *board, int row, int col, int poss[10]) {
+	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return 0;
+	for (int i = 0; i <= 9; i++) poss[i] = 0;
+	if (boardGet(board, row, col) != 0) return 0;
+	unsigned int used = 0;
+	int boxRow = (row / 3) * 3, boxCol = (col / 3) * 3;
+	for (int i = 0; i < GRID_SIZE; i++) {
+		int inRow = boardGet(board, row, i);
+		int inCol = boardGet(board, i, col);
+		int inBox = boardGet(board, boxRow + i / 3, boxCol + i % 3);
+		if (inRow >= 1 && inRow <= 9) used |= DIGIT_BIT(inRow);
+		if (inCol >= 1 && inCol <= 9) used |= DIGIT_BIT(inCol);
+		if (inBox >= 1 && inBox <= 9) used |= DIGIT_BIT(inBox);
+	}
+	int count = 0;
+	for (int v = 1; v <= 9; v++) {
+		if (!(used & DIGIT_BIT(v))) {
+			poss[v] = 1;
+			count++;
+		}
+	}
+	return count;
+}
+
+void computeCandidateMasks(const Board *board, uint16_t masks[CELL_COUNT]) {
+	UnitSummary u;
+	summarizeUnits(board, &u);
+	_Alignas(32) uint16_t colUsed[16] = {0};
+	_Alignas(32) uint16_t boxUsed[16] = {0};
+	_Alignas(32) uint16_t out[16];
+	for (int c = 0; c < GRID_SIZE; c++) colUsed[c] = u.orMask[9 + c];
+	Lanes cols = lanesLoad(colUsed);
+	Lanes all = lanesSplat((uint16_t)ALL_DIGITS_MASK);
+	for (int r = 0; r < GRID_SIZE; r++) {
+		if (r % 3 == 0) {
+			for (int c = 0; c < GRID_SIZE; c++) boxUsed[c] = u.orMask[18 + BOX_INDEX(r, c)];
+		}
+		Lanes used = lanesOr(lanesOr(cols, lanesLoad(boxUsed)), lanesSplat(u.orMask[r]));
+		Lanes empty = lanesIsZero(lanesLoad(u.bits[r]));
+		lanesStore(out, lanesAnd(lanesAndNot(used, all), empty));
+		memcpy(&masks[r * GRID_SIZE], out, GRID_SIZE * sizeof(uint16_t));
+	}
+}
+
+bool isBoardComplete(const Board *board) {
+	for (int i = 0; i < CELL_COUNT; i++) {
+		if (board->cells[i] == 0) return false;
+	}
+	return true;
+}
+
+bool isBoardValid(const Board *board) {
+	// Nine cells can only OR to all nine digits if each holds a different one.
+	UnitSummary u;
+	summarizeUnits(board, &u);
+	for (int i = 0; i < 3 * GRID_SIZE; i++) {
+		if (u.orMask[i] != ALL_DIGITS_MASK) return false;
+	}
+	return true;
+}
+
+bool isBoardConsistent(const Board *board) {
+	UnitSummary u;
+	summarizeUnits(board, &u);
+	for (int i = 0; i < 3 * GRID_SIZE; i++) {
+		if (u.sum[i] != u.orMask[i] || (u.orMask[i] & INVALID_CELL_BIT)) return false;
+	}
+	return true;
+}
+
+bool isStateMoveValid(const GameState *state, int row, int col, int value) {
+	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return false;
+	if (value < 1 || value > 9) return false;
+	if (boardGet(&state->currentGrid, row, col) != 0) return false;
+	return (tallyCandidates(&state->tally, row, col) & DIGIT_BIT(value)) != 0;
+}
+
+// Every edit of a game's grid goes through here so the tally stays in step.
+static void setCell(GameState *state, int row, int col, int value) {
+	tallyChange(&state->tally, row * GRID_SIZE + col, boardGet(&state->currentGrid, row, col), value);
+	boardSet(&state->currentGrid, row, col, value);
+}
+
+bool playMove(GameState *state, int row, int col, int value) {
+	Move m = { row, col, boardGet(&state->currentGrid, row, col), value };
+	if (!historyPush(&state->history, &m)) return false;
+	setCell(state, row, col, value);
+	return true;
+}
+
+bool undoMove(GameState *state, Move *out) {
+	Move m;
+	if (!historyUndo(&state->history, &m)) return false;
+	setCell(state, m.row, m.col, m.previousValue);
+	if (out) *out = m;
+	return true;
+}
+
+bool redoMove(GameState *state, Move *out) {
+	Move m;
+	if (!historyRedo(&state->history, &m)) return false;
+	setCell(state, m.row, m.col, m.newValue);
+	if (out) *out = m;
+	return true;
+}
+
+unsigned int elapsedPlaySeconds(const GameState *state) {
+	unsigned int elapsed = state->elapsedSeconds;
+	if (state->timerStart != 0) {
+		unsigned int now = (unsigned int)time(NULL);
+		if (now >= (unsigned int)state->timerStart) elapsed += (now - (unsigned int)state->timerStart);
+	}
+	return elapsed;
+}
+
+void settlePlayTime(GameState *state) {
+	if (state->timerStart == 0) return;
+	state->elapsedSeconds = elapsedPlaySeconds(state);
+	state->timerStart = time(NULL);
+}
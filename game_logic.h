@@ -1,16 +1,39 @@
-#ifndef GAME_LOGIC_H
-#define GAME_LOGIC_H
-
-#include <stdbool.h>
-#include "structs.h"
-
-bool isMoveValid(const int grid[GRID_SIZE][GRID_SIZE], int row, int col, int value);
-
-int computePossibilities(const int grid[GRID_SIZE][GRID_SIZE], int row, int col, int poss[10]);
-
-bool isBoardComplete(const int grid[GRID_SIZE][GRID_SIZE]);
-bool isBoardValid(const int grid[GRID_SIZE][GRID_SIZE]);
-
-#endif 
-
-
+#ifndef GAME_LOGIC_H
+#define GAME_LOGIC_H
+
+#include <stdbool.h>
+#include "structs.h"
+
+bool isMoveValid(const Board *board, int row, int col, int value);
+
+int computePossibilities(const Board *board, int row, int col, int poss[10]);
+
+// Fills the candidate mask of every cell (0 for filled cells) in one pass over the board.
+void computeCandidateMasks(const Board *board, uint16_t masks[CELL_COUNT]);
+
+bool isBoardComplete(const Board *board);
+bool isBoardValid(const Board *board);
+
+// True when no digit repeats in any row, column or box (empty cells allowed).
+bool isBoardConsistent(const Board *board);
+
+// isMoveValid for the game's current grid, answered from state->tally in O(1).
+bool isStateMoveValid(const GameState *state, int row, int col, int value);
+
+// Places value at (row, col) and records it in the move history; a move played after
+// undoing starts a new branch (see move_history.h). Returns false when the history
+// cannot grow, leaving the board untouched.
+bool playMove(GameState *state, int row, int col, int value);
+// out (optional) receives the move undone or redone.
+bool undoMove(GameState *state, Move *out);
+bool redoMove(GameState *state, Move *out);
+
+// Seconds played so far: the saved total plus the time since timerStart.
+unsigned int elapsedPlaySeconds(const GameState *state);
+// Folds the time since timerStart into elapsedSeconds and restarts the timer from now, so
+// a save written right after holds the full play time.
+void settlePlayTime(GameState *state);
+
+#endif 
+
+
@@ -0,0 +1,529 @@
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "game_session.h"
+#include "board.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "grader.h"
+#include "solution_cache.h"
+#include "solver.h"
+
+static void copyString(char *dst, const char *src, size_t dstSize) {
+	if (!dst || !src || dstSize == 0) return;
+	size_t i = 0;
+	while (i + 1 < dstSize && src[i] != '\0') {
+		dst[i] = src[i];
+		i++;
+	}
+	dst[i] = '\0';
+}
+
+// Appends a line to the reply, truncating once it is full.
+static void replyLine(SessionReply *reply, const char *format, ...) {
+	size_t room = sizeof(reply->text) - reply->length;
+	if (room <= 1) return;
+	if (reply->length > 0) {
+		reply->text[reply->length++] = '\n';
+		room--;
+	}
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(reply->text + reply->length, room, format, args);
+	va_end(args);
+	if (n < 0) n = 0;
+	reply->length += (size_t)n < room ? (size_t)n : room - 1;
+}
+
+static void fail(SessionReply *reply, const char *message) {
+	reply->ok = false;
+	replyLine(reply, "%s", message);
+}
+
+// True when line is word, in any case, followed by the end of the line or a space.
+static bool isWord(const char *line, const char *word) {
+	size_t i = 0;
+	for (; word[i]; i++) {
+		if (tolower((unsigned char)line[i]) != word[i]) return false;
+	}
+	return line[i] == '\0' || line[i] == ' ' || line[i] == '\n' || line[i] == '\r';
+}
+
+SessionCommand parseSessionCommand(const char *line, int *row, int *col, int *value) {
+	if ((line[0] == 'q' || line[0] == 'Q') &&
+		(line[1] == 'u' || line[1] == 'U') &&
+		(line[2] == 'i' || line[2] == 'I') &&
+		(line[3] == 't' || line[3] == 'T') &&
+		(line[4] == '\0' || line[4] == ' ' || line[4] == '\n' || line[4] == '\r')) {
+		return COMMAND_QUIT;
+	}
+	if (line[0] == 's' || line[0] == 'S') {
+		if (line[1] == 'a' || line[1] == 'A') return COMMAND_SAVE;
+		return COMMAND_SOLVE;
+	}
+	if (isWord(line, "cancel")) return COMMAND_CANCEL;
+	if (line[0] == 'c' || line[0] == 'C') {
+		int r, c;
+		if (sscanf(line, "%*s %d %d", &r, &c) != 2) return COMMAND_INVALID;
+		*row = r - 1;
+		*col = c - 1;
+		*value = 0;
+		return COMMAND_CHECK;
+	}
+	if (line[0] == 'u' || line[0] == 'U') return COMMAND_UNDO;
+	if (line[0] == 'r' || line[0] == 'R') return COMMAND_REDO;
+	if (line[0] == 'b' || line[0] == 'B') return COMMAND_BRANCH;
+	if (line[0] == 'm' || line[0] == 'M') return COMMAND_MISTAKES;
+	int r, c, v;
+	if (sscanf(line, "%d %d %d", &r, &c, &v) != 3) return COMMAND_INVALID;
+	*row = r - 1;
+	*col = c - 1;
+	*value = v;
+	return COMMAND_MOVE;
+}
+
+// Generated puzzles arrive with their solution and count, and callers that checked the
+// puzzle already pass both in. Anything else is left to checkSessionPuzzle, which may
+// need many seconds; the cache spares it for puzzles that are played again.
+static void fillPuzzleSolution(GameSession *session) {
+	Puzzle *puzzle = &session->puzzle;
+	if (!isBoardComplete(&puzzle->solution)) {
+		Board cached;
+		if (lookupCachedSolution(&puzzle->grid, getSolverStrategy(), &cached)) puzzle->solution = cached;
+		else memset(&puzzle->solution, 0, sizeof(puzzle->solution));
+	}
+	session->uniqueSolution = puzzle->solutionCount == SOLUTIONS_UNIQUE && isBoardComplete(&puzzle->solution);
+}
+
+// True when the digit at (row, col) is not the one the unique solution has there.
+static bool isMistake(const GameSession *session, int row, int col) {
+	int value = boardGet(&session->state.currentGrid, row, col);
+	return session->uniqueSolution && value != 0 && value != boardGet(&session->puzzle.solution, row, col);
+}
+
+// True when every digit on the board is where the solution has it.
+static bool onTrack(const Board *board, const Board *solution) {
+	if (!isBoardComplete(solution)) return false;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (board->cells[cell] && board->cells[cell] != solution->cells[cell]) return false;
+	}
+	return true;
+}
+
+void startGameSession(GameSession *session, const Puzzle *puzzle, GameState *resumed, Leaderboard *scores,
+	bool autosave, const char *savePath) {
+	memset(session, 0, sizeof(*session));
+	session->puzzle = *puzzle;
+	session->scores = scores;
+	GameState *state = &session->state;
+	if (resumed) {
+		*state = *resumed;
+		memset(&resumed->history, 0, sizeof(resumed->history));
+		// A save records the grid as played; the puzzle is what its fixed cells hold.
+		for (int r = 0; r < GRID_SIZE; r++) {
+			for (int c = 0; c < GRID_SIZE; c++) {
+				boardSet(&session->puzzle.grid, r, c, state->isFixed[r][c] ? boardGet(&state->currentGrid, r, c) : 0);
+			}
+		}
+	} else {
+		copyString(state->activeDifficulty, puzzle->difficulty, sizeof(state->activeDifficulty));
+		copyString(state->activePuzzleName, puzzle->name, sizeof(state->activePuzzleName));
+		state->currentGrid = puzzle->grid;
+		for (int r = 0; r < GRID_SIZE; r++) {
+			for (int c = 0; c < GRID_SIZE; c++) {
+				state->isFixed[r][c] = (boardGet(&puzzle->grid, r, c) != 0);
+			}
+		}
+	}
+	fillPuzzleSolution(session);
+	tallyBoard(&state->tally, &state->currentGrid);
+	state->timerStart = time(NULL);
+	if (savePath) copyString(session->savePath, savePath, sizeof(session->savePath));
+	else gameSavePath(state, session->savePath, sizeof(session->savePath));
+	if (autosave) session->autosaveActive = startAutosave(&session->autosave, state, session->savePath);
+}
+
+void endGameSession(GameSession *session) {
+	if (session->solving && session->solveStepped) {
+		endSolveJob(&session->solveJob);
+	} else if (session->solving) {
+		cancelSolveJob(&session->solveJob);
+		finishSolveJob(&session->solveJob);
+	}
+	session->solving = false;
+	session->checking = false;
+	if (session->autosaveActive) stopAutosave(&session->autosave);
+	session->autosaveActive = false;
+	freeMoveHistory(&session->state.history);
+}
+
+static void recordCompletion(GameSession *session, unsigned int seconds, SessionReply *reply) {
+	GameState *state = &session->state;
+	if (!session->scores || !recordScore(session->scores, state->activeDifficulty, state->activePuzzleName, seconds)) {
+		replyLine(reply, "Could not record the high score.");
+	}
+}
+
+static void journal(GameSession *session, JournalOp op, const Move *move) {
+	if (session->autosaveActive) journalMove(&session->autosave, &session->state, op, move);
+}
+
+static void saveSession(GameSession *session, SessionReply *reply) {
+	GameState *state = &session->state;
+	settlePlayTime(state);
+	bool saved = session->autosaveActive ? writeAutosaveSnapshot(&session->autosave, state)
+		: saveGameState(state, session->savePath);
+	if (saved) replyLine(reply, "Saved to %s", session->savePath);
+	else fail(reply, "Save failed.");
+}
+
+// Shows the puzzle's next hint once the board reaches its trigger.
+static void offerHint(GameSession *session, SessionReply *reply) {
+	GameState *state = &session->state;
+	if (state->nextHintIndex >= session->puzzle.numHints) return;
+	const Hint *h = &session->puzzle.hints[state->nextHintIndex];
+	bool targetEmptyOk = true;
+	if (h->hintRow >= 0 && h->hintCol >= 0) {
+		targetEmptyOk = (boardGet(&state->currentGrid, h->hintRow, h->hintCol) == 0);
+	}
+	if (state->tally.emptyCount != h->triggerCellCount || !targetEmptyOk) return;
+	replyLine(reply, "%s", h->message);
+	if (h->hintRow >= 0 && h->hintCol >= 0 && h->hintValue >= 1) {
+		replyLine(reply, "Try (%d,%d) = %d", h->hintRow + 1, h->hintCol + 1, h->hintValue);
+	}
+	state->nextHintIndex++;
+}
+
+static void playSessionMove(GameSession *session, int row, int col, int value, SessionReply *reply) {
+	GameState *state = &session->state;
+	if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) {
+		fail(reply, "Row/col must be between 1 and 9.");
+		return;
+	}
+	if (state->isFixed[row][col]) {
+		fail(reply, "Cannot change a fixed (given) cell.");
+		return;
+	}
+	if (!isStateMoveValid(state, row, col, value)) {
+		fail(reply, "Invalid move by Sudoku rules.");
+		return;
+	}
+	Move played = { row, col, boardGet(&state->currentGrid, row, col), value };
+	if (!playMove(state, row, col, value)) {
+		fail(reply, "Out of memory for the move history.");
+		return;
+	}
+	if (session->checkMistakes && isMistake(session, row, col)) {
+		session->mistakes++;
+		replyLine(reply, "Mistake: %d does not belong at (%d,%d).", value, row + 1, col + 1);
+	}
+	offerHint(session, reply);
+	journal(session, JOURNAL_MOVE, &played);
+	if (!tallyComplete(&state->tally)) return;
+	if (!tallySolved(&state->tally)) {
+		replyLine(reply, "Board is full but invalid. Keep trying or undo.");
+		return;
+	}
+	if (session->autosaveActive) stopAutosave(&session->autosave);
+	session->autosaveActive = false;
+	unsigned int total = elapsedPlaySeconds(state);
+	replyLine(reply, "Completed! Time: %02u:%02u:%02u (HH:MM:SS)", total / 3600, (total % 3600) / 60, total % 60);
+	if (session->mistakes > 0) replyLine(reply, "Mistakes flagged along the way: %u", session->mistakes);
+	recordCompletion(session, total, reply);
+	session->over = true;
+}
+
+// Applies what a solve of the current grid ended with. stats is NULL when no search ran.
+static void reportSolve(GameSession *session, SolveOutcome outcome, const Board *solution, const SolverStats *stats,
+	unsigned long long nodes, double seconds, SessionReply *reply) {
+	GameState *state = &session->state;
+	if (outcome == SOLVE_NO_SOLUTION) {
+		fail(reply, "No solution found (board may be invalid).");
+		return;
+	}
+	if (outcome == SOLVE_TIMED_OUT) {
+		reply->ok = false;
+		replyLine(reply, "Timed out after %llu nodes in %.1fs without an answer; the board may still be solvable.", nodes, seconds);
+		return;
+	}
+	if (outcome == SOLVE_CANCELLED) {
+		replyLine(reply, "Solve cancelled after %llu nodes in %.1fs.", nodes, seconds);
+		return;
+	}
+	state->currentGrid = *solution;
+	tallyBoard(&state->tally, &state->currentGrid);
+	unsigned int total = elapsedPlaySeconds(state);
+	if (session->autosaveActive) writeAutosaveSnapshot(&session->autosave, state);
+	replyLine(reply, "Solved.");
+	if (SOLVER_STATS_ENABLED && !stats) {
+		replyLine(reply, "Search: none, the solution was already known.");
+	} else if (SOLVER_STATS_ENABLED) {
+		char summary[192];
+		formatSolverStats(stats, summary, sizeof(summary));
+		replyLine(reply, "Search: %s", summary);
+	}
+	recordCompletion(session, total, reply);
+}
+
+// Applies what checkSessionPuzzle ended with.
+static void applyPuzzleCheck(GameSession *session, SolveOutcome outcome, SessionReply *reply) {
+	Puzzle *puzzle = &session->puzzle;
+	SolveJob *job = &session->solveJob;
+	session->checking = false;
+	if (outcome == SOLVE_NO_SOLUTION) {
+		puzzle->solutionCount = SOLUTIONS_NONE;
+		if (session->autosaveActive) stopAutosave(&session->autosave);
+		session->autosaveActive = false;
+		session->over = true;
+		fail(reply, "This puzzle has no solution, so the game is over.");
+		return;
+	}
+	// A check stopped after the first solution still has it; only the count stays open.
+	if (job->solutions > 0) solveJobBoard(job, &puzzle->solution);
+	if (outcome == SOLVE_CANCELLED) {
+		replyLine(reply, "Puzzle check cancelled; moves are checked by the rules only.");
+		return;
+	}
+	if (outcome == SOLVE_TIMED_OUT) {
+		replyLine(reply, "Could not verify the puzzle in %llu nodes; moves are checked by the rules only.", job->nodes);
+		return;
+	}
+	puzzle->solutionCount = job->solutions == 1 ? SOLUTIONS_UNIQUE : SOLUTIONS_SEVERAL;
+	session->uniqueSolution = job->solutions == 1;
+	if (!session->uniqueSolution) {
+		replyLine(reply, "This puzzle has more than one solution; moves are checked by the rules only.");
+		return;
+	}
+	cacheSolution(&puzzle->grid, getSolverStrategy(), &puzzle->solution);
+	replyLine(reply, "Puzzle checked: it has one solution, so 'mistakes' can flag wrong digits.");
+}
+
+void checkSessionPuzzle(GameSession *session, SessionReply *reply) {
+	Puzzle *puzzle = &session->puzzle;
+	SolveJob *job = &session->solveJob;
+	reply->ok = true;
+	reply->length = 0;
+	reply->text[0] = '\0';
+	if (session->over || session->solving) return;
+	if (puzzle->solutionCount != SOLUTIONS_UNKNOWN && isBoardComplete(&puzzle->solution)) return;
+	SolveBudget budget = { 0, SESSION_CHECK_NODES };
+	job->checkUnique = true;
+	session->checking = true;
+	if (session->solveStepped) {
+		beginSolveJob(job, &puzzle->grid, budget);
+		session->solving = true;
+		return;
+	}
+	if (session->solveInBackground &&
+		startSolveJob(job, &puzzle->grid, budget, session->onSolveFinished, session->onSolveFinishedArg)) {
+		session->solving = true;
+		replyLine(reply, "Checking the puzzle in the background; 'solve' and 'mistakes' wait for it.");
+		return;
+	}
+	applyPuzzleCheck(session, runSolveJob(job, &puzzle->grid, budget), reply);
+}
+
+static void solveSession(GameSession *session, SessionReply *reply) {
+	GameState *state = &session->state;
+	SolveJob *job = &session->solveJob;
+	if (onTrack(&state->currentGrid, &session->puzzle.solution)) {
+		reportSolve(session, SOLVE_FOUND, &session->puzzle.solution, NULL, 0, 0.0, reply);
+		return;
+	}
+	job->checkUnique = false;
+	if (session->solveStepped) {
+		beginSolveJob(job, &state->currentGrid, session->solveBudget);
+		session->solving = true;
+		return;
+	}
+	if (session->solveInBackground &&
+		startSolveJob(job, &state->currentGrid, session->solveBudget, session->onSolveFinished, session->onSolveFinishedArg)) {
+		session->solving = true;
+		replyLine(reply, "Solving in the background; type 'cancel' to stop.");
+		return;
+	}
+	SolveOutcome outcome = runSolveJob(job, &state->currentGrid, session->solveBudget);
+	Board solution;
+	solveJobBoard(job, &solution);
+	reportSolve(session, outcome, &solution, &job->stats, job->nodes, job->seconds, reply);
+}
+
+// Runs before every command while a background solve is out. Reports its progress, or
+// its result once it has ended, and returns true when that answers the command. Commands
+// that would change the board are held back until the solve is over; the rest go ahead.
+// A check of the puzzle holds back only the commands that need its answer.
+static bool settleBackgroundSolve(GameSession *session, SessionCommand command, SessionReply *reply) {
+	SolveJob *job = &session->solveJob;
+	bool stop = command == COMMAND_CANCEL || command == COMMAND_QUIT;
+	if (stop) cancelSolveJob(job);
+	unsigned long long nodes;
+	double seconds;
+	if (!stop && session->checking && pollSolveJob(job, &nodes, &seconds) == SOLVE_RUNNING) {
+		if (command != COMMAND_SOLVE && command != COMMAND_MISTAKES && command != COMMAND_INVALID) return false;
+		replyLine(reply, "Still checking the puzzle: %llu nodes in %.1fs. Type 'cancel' to stop.", nodes, seconds);
+		return true;
+	}
+	if (!stop && !session->checking && pollSolveJob(job, &nodes, &seconds) == SOLVE_RUNNING) {
+		if (command == COMMAND_CHECK || command == COMMAND_SAVE || command == COMMAND_MISTAKES) return false;
+		if (command == COMMAND_SOLVE || command == COMMAND_INVALID) {
+			replyLine(reply, "Still solving: %llu nodes in %.1fs. Type 'cancel' to stop.", nodes, seconds);
+		} else {
+			fail(reply, "A solve is running; wait for it or type 'cancel'.");
+		}
+		return true;
+	}
+	SolveOutcome outcome = finishSolveJob(job);
+	session->solving = false;
+	if (session->checking) {
+		applyPuzzleCheck(session, outcome, reply);
+		return command == COMMAND_CANCEL || command == COMMAND_INVALID || session->over;
+	}
+	Board solution;
+	solveJobBoard(job, &solution);
+	reportSolve(session, outcome, &solution, &job->stats, job->nodes, job->seconds, reply);
+	return command == COMMAND_SOLVE || command == COMMAND_CANCEL || command == COMMAND_INVALID;
+}
+
+bool stepSessionSolve(GameSession *session, SessionReply *reply) {
+	SolveJob *job = &session->solveJob;
+	reply->ok = true;
+	reply->length = 0;
+	reply->text[0] = '\0';
+	SolveOutcome outcome = advanceSolveJob(job);
+	if (outcome == SOLVE_RUNNING) return false;
+	endSolveJob(job);
+	session->solving = false;
+	if (session->checking) {
+		applyPuzzleCheck(session, outcome, reply);
+		return true;
+	}
+	Board solution;
+	solveJobBoard(job, &solution);
+	reportSolve(session, outcome, &solution, &job->stats, job->nodes, job->seconds, reply);
+	return true;
+}
+
+void runSessionCommand(GameSession *session, SessionCommand command, int row, int col, int value, SessionReply *reply) {
+	GameState *state = &session->state;
+	reply->ok = true;
+	reply->length = 0;
+	reply->text[0] = '\0';
+	if (session->over) {
+		fail(reply, "The game is over.");
+		return;
+	}
+	if (session->solving && settleBackgroundSolve(session, command, reply)) return;
+	switch (command) {
+		case COMMAND_QUIT:
+			if (session->autosaveActive) stopAutosave(&session->autosave);
+			session->autosaveActive = false;
+			session->over = true;
+			break;
+		case COMMAND_SOLVE:
+			solveSession(session, reply);
+			break;
+		case COMMAND_CHECK: {
+			if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) {
+				fail(reply, "Row/col must be between 1 and 9.");
+				break;
+			}
+			int current = boardGet(&state->currentGrid, row, col);
+			if (current && !state->isFixed[row][col] && session->uniqueSolution) {
+				replyLine(reply, "(%d,%d) = %d is %s.", row + 1, col + 1, current, isMistake(session, row, col) ? "a mistake" : "correct");
+				break;
+			}
+			unsigned int candidates = current ? 0 : tallyCandidates(&state->tally, row, col);
+			if (candidates == 0) {
+				replyLine(reply, "No possibilities (cell filled or blocked).");
+				break;
+			}
+			char values[32];
+			size_t n = 0;
+			for (int v = 1; v <= 9; v++) {
+				if (candidates & (1u << (v - 1))) n += (size_t)snprintf(values + n, sizeof(values) - n, "%d ", v);
+			}
+			replyLine(reply, "Possible values at (%d,%d): %s", row + 1, col + 1, values);
+			break;
+		}
+		case COMMAND_SAVE:
+			saveSession(session, reply);
+			break;
+		case COMMAND_UNDO: {
+			Move undone;
+			if (!undoMove(state, &undone)) {
+				fail(reply, "Nothing to undo.");
+				break;
+			}
+			journal(session, JOURNAL_UNDO, &undone);
+			replyLine(reply, "Undone last move.");
+			int branches = historyRedoBranches(&state->history);
+			if (branches > 1) replyLine(reply, "%d moves were played from here; 'branch' picks which one redo restores.", branches);
+			break;
+		}
+		case COMMAND_REDO: {
+			Move redone;
+			if (!redoMove(state, &redone)) {
+				fail(reply, "Nothing to redo.");
+				break;
+			}
+			journal(session, JOURNAL_REDO, &redone);
+			replyLine(reply, "Redone move.");
+			break;
+		}
+		case COMMAND_BRANCH: {
+			Move next;
+			if (!historyNextBranch(&state->history, &next)) {
+				fail(reply, "No other branch to redo from here.");
+				break;
+			}
+			journal(session, JOURNAL_BRANCH, &next);
+			replyLine(reply, "Redo will now play (%d,%d) = %d.", next.row + 1, next.col + 1, next.newValue);
+			break;
+		}
+		case COMMAND_MISTAKES: {
+			if (!session->uniqueSolution) {
+				fail(reply, "Mistake detection needs a puzzle with exactly one solution.");
+				break;
+			}
+			session->checkMistakes = !session->checkMistakes;
+			if (!session->checkMistakes) {
+				replyLine(reply, "Mistake detection off.");
+				break;
+			}
+			replyLine(reply, "Mistake detection on: digits that differ from the solution are flagged as you play them.");
+			int wrong = 0;
+			for (int r = 0; r < GRID_SIZE; r++) {
+				for (int c = 0; c < GRID_SIZE; c++) wrong += isMistake(session, r, c);
+			}
+			if (wrong > 0) replyLine(reply, "%d digit%s on the board %s already wrong.", wrong, wrong == 1 ? "" : "s", wrong == 1 ? "is" : "are");
+			break;
+		}
+		case COMMAND_CANCEL:
+			fail(reply, "No solve is running.");
+			break;
+		case COMMAND_MOVE:
+			playSessionMove(session, row, col, value, reply);
+			break;
+		default:
+			fail(reply, "Invalid input. Please try again.");
+			break;
+	}
+}
+
+void handleSessionLine(GameSession *session, const char *line, SessionReply *reply) {
+	int row = 0, col = 0, value = 0;
+	SessionCommand command = parseSessionCommand(line, &row, &col, &value);
+	runSessionCommand(session, command, row, col, value, reply);
+}
+
+bool pickLibraryPuzzle(PuzzleLibrary *library, int level, uint64_t random, Puzzle *puzzle) {
+	if (!randomLibraryPuzzle(library, level, random, puzzle)) return false;
+	char difficulty[sizeof(puzzle->difficulty)];
+	copyString(difficulty, puzzle->difficulty, sizeof(difficulty));
+	GradeResult grade;
+	if (gradeLogically(&puzzle->grid, &grade)) applyGradeToPuzzle(puzzle, &grade);
+	copyString(puzzle->difficulty, difficulty, sizeof(puzzle->difficulty));
+	return true;
+}
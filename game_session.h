@@ -0,0 +1,97 @@
+#ifndef GAME_SESSION_H
+#define GAME_SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "structs.h"
+#include "autosave.h"
+#include "leaderboard.h"
+#include "puzzle_library.h"
+#include "solve_job.h"
+
+// Commands understood while a game is running; the values are what promptMove returns.
+typedef enum SessionCommand {
+	COMMAND_QUIT = 0,
+	COMMAND_MOVE,    // row col value
+	COMMAND_SOLVE,
+	COMMAND_SAVE,
+	COMMAND_CHECK,   // check r c
+	COMMAND_UNDO,
+	COMMAND_REDO,
+	COMMAND_BRANCH,
+	COMMAND_MISTAKES, // toggles mistake detection
+	COMMAND_CANCEL,   // stops a background solve
+	COMMAND_INVALID
+} SessionCommand;
+
+#define SESSION_REPLY_MAX 1024
+// What checkSessionPuzzle may search before giving up: about half a minute.
+#define SESSION_CHECK_NODES 100000000ull
+
+// What one command produced. text may span several lines; ok is false for rejected
+// commands (illegal moves, nothing to undo, ...).
+typedef struct SessionReply {
+	bool ok;
+	char text[SESSION_REPLY_MAX];
+	size_t length;
+} SessionReply;
+
+// One game in progress, independent of where its commands come from: the interactive
+// loop in main.c drives one from stdin, the server (server.h) thousands from sockets.
+typedef struct GameSession {
+	GameState state;
+	Puzzle puzzle;
+	Autosave autosave;
+	bool autosaveActive;
+	char savePath[320];     // where 'save' writes when autosave is off
+	Leaderboard *scores;    // NULL when high scores are unavailable
+	bool uniqueSolution;    // puzzle.solution is the only one, so moves can be judged by it
+	bool checkMistakes;     // flag digits that differ from the solution as they are played
+	unsigned int mistakes;  // digits flagged so far
+	bool over;              // quit or completed; the session must be ended
+	// 'solve' searches within solveBudget, on the calling thread unless solveInBackground
+	// is set. A background solve keeps the session answering commands: 'cancel' stops it,
+	// and the first command after it ends reports the result. onSolveFinished (optional)
+	// is called from the solving thread when it ends. With solveStepped, 'solve' only sets
+	// the search up and replies nothing; the caller advances it with stepSessionSolve and
+	// runs no other command until that has replied.
+	SolveBudget solveBudget;
+	bool solveInBackground;
+	bool solveStepped;
+	SolveJobNotify onSolveFinished;
+	void *onSolveFinishedArg;
+	SolveJob solveJob;
+	bool solving;           // solveJob is running or has ended unreported
+	bool checking;          // ... and it is checking the puzzle, not solving the board
+} GameSession;
+
+// Parses one command line (with or without its newline); row, col and value are 0-based
+// for moves and checks.
+SessionCommand parseSessionCommand(const char *line, int *row, int *col, int *value);
+
+// Starts a game of puzzle, or resumes resumed (whose history the session takes over) when
+// it is not NULL. With autosave the game is journaled to savePath (NULL for the usual
+// saves/<puzzle>.sav); otherwise 'save' writes a plain save there. A puzzle that arrives
+// without its solution takes it from the solution cache if it can, and moves are judged
+// against it once solutionCount says it is the only one.
+void startGameSession(GameSession *session, const Puzzle *puzzle, GameState *resumed, Leaderboard *scores,
+	bool autosave, const char *savePath);
+// Searches for whatever startGameSession could not fill in, the way 'solve' runs but over
+// the puzzle itself and within SESSION_CHECK_NODES: it counts up to two solutions and
+// keeps the first. Call it once the solve settings are in place. Play goes on meanwhile;
+// only 'solve' and 'mistakes' wait for it, and 'cancel' stops it. A puzzle found to have
+// no solution ends the game. Does nothing when the puzzle needs no check.
+void checkSessionPuzzle(GameSession *session, SessionReply *reply);
+// Cancels a background solve, if any, before the session is released.
+void endGameSession(GameSession *session);
+
+void runSessionCommand(GameSession *session, SessionCommand command, int row, int col, int value, SessionReply *reply);
+void handleSessionLine(GameSession *session, const char *line, SessionReply *reply);
+// Searches one slice of a stepped solve or check (see solveStepped). Returns false while
+// it is still running, and true once reply holds its result.
+bool stepSessionSolve(GameSession *session, SessionReply *reply);
+
+// Picks a random puzzle of the level from the library, with hints from the grader.
+bool pickLibraryPuzzle(PuzzleLibrary *library, int level, uint64_t random, Puzzle *puzzle);
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+#include "generator.h"
+#include "board.h"
+#include "solver.h"
+#include "file_io.h"
+#include "grader.h"
+
+#define MAX_ATTEMPTS 200
+
+const char *const difficultyNames[DIFFICULTY_LEVELS] = { "Easy", "Medium", "Hard", "Expert" };
+
+// Clue removal stops once a puzzle is down to this many givens; 0 means remove until minimal.
+static const int clueFloor[DIFFICULTY_LEVELS] = { 38, 28, 0, 0 };
+
+static uint64_t splitMix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void seedGenerator(PuzzleGenerator *gen, uint64_t seed) {
+	uint64_t x = seed;
+	gen->rngState = splitMix64(&x);
+	if (gen->rngState == 0) gen->rngState = 1;
+	gen->generated = 0;
+}
+
+uint32_t nextRandom(PuzzleGenerator *gen) {
+	// xorshift64*
+	uint64_t x = gen->rngState;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	gen->rngState = x;
+	return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static int randomBelow(PuzzleGenerator *gen, int n) {
+	return (int)(nextRandom(gen) % (uint32_t)n);
+}
+
+static void shuffle(PuzzleGenerator *gen, int *values, int n) {
+	for (int i = n - 1; i > 0; i--) {
+		int j = randomBelow(gen, i + 1);
+		int t = values[i];
+		values[i] = values[j];
+		values[j] = t;
+	}
+}
+
+// Relabels digits and permutes bands, rows within bands, stacks and columns within stacks,
+// optionally transposing: every one of these maps a valid grid to another valid grid.
+static void applyRandomSymmetry(PuzzleGenerator *gen, Board *board) {
+	int digits[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	int relabel[10] = { 0 };
+	shuffle(gen, digits, 9);
+	for (int d = 1; d <= 9; d++) relabel[d] = digits[d - 1];
+
+	int rowMap[GRID_SIZE], colMap[GRID_SIZE];
+	int bands[3] = { 0, 1, 2 }, stacks[3] = { 0, 1, 2 };
+	shuffle(gen, bands, 3);
+	shuffle(gen, stacks, 3);
+	for (int b = 0; b < 3; b++) {
+		int rows[3] = { 0, 1, 2 }, cols[3] = { 0, 1, 2 };
+		shuffle(gen, rows, 3);
+		shuffle(gen, cols, 3);
+		for (int k = 0; k < 3; k++) {
+			rowMap[b * 3 + k] = bands[b] * 3 + rows[k];
+			colMap[b * 3 + k] = stacks[b] * 3 + cols[k];
+		}
+	}
+	bool transpose = (nextRandom(gen) & 1u) != 0;
+	Board source = *board;
+	for (int r = 0; r < GRID_SIZE; r++) {
+		for (int c = 0; c < GRID_SIZE; c++) {
+			int v = relabel[boardGet(&source, rowMap[r], colMap[c])];
+			if (transpose) boardSet(board, c, r, v);
+			else boardSet(board, r, c, v);
+		}
+	}
+}
+
+void generateSolvedBoard(PuzzleGenerator *gen, Board *out) {
+	memset(out, 0, sizeof(*out));
+	// The diagonal boxes share no row or column, so each can take any permutation.
+	for (int box = 0; box < 3; box++) {
+		int digits[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		shuffle(gen, digits, 9);
+		for (int i = 0; i < 9; i++) {
+			boardSet(out, box * 3 + i / 3, box * 3 + i % 3, digits[i]);
+		}
+	}
+	solveSudokuWith(out, SOLVER_MRV, NULL);
+	applyRandomSymmetry(gen, out);
+}
+
+int gradePuzzle(const Board *puzzle) {
+	GradeResult grade;
+	if (!gradeLogically(puzzle, &grade)) return DIFFICULTY_LEVELS - 1;
+	return grade.level;
+}
+
+static void removeClues(PuzzleGenerator *gen, Board *puzzle, int floor) {
+	int order[CELL_COUNT];
+	for (int i = 0; i < CELL_COUNT; i++) order[i] = i;
+	shuffle(gen, order, CELL_COUNT);
+	int clues = CELL_COUNT;
+	for (int i = 0; i < CELL_COUNT && clues > floor; i++) {
+		int cell = order[i];
+		uint8_t saved = puzzle->cells[cell];
+		puzzle->cells[cell] = 0;
+		if (countSolutions(puzzle, 2) != 1) {
+			puzzle->cells[cell] = saved;
+		} else {
+			clues--;
+		}
+	}
+}
+
+int findDifficultyLevel(const char *name) {
+	for (int i = 0; i < DIFFICULTY_LEVELS; i++) {
+		if (strcmp(name, difficultyNames[i]) == 0) return i;
+	}
+	return -1;
+}
+
+bool generatePuzzle(PuzzleGenerator *gen, int level, Puzzle *out) {
+	if (level < 0 || level >= DIFFICULTY_LEVELS) return false;
+	for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+		Board solution, puzzle;
+		generateSolvedBoard(gen, &solution);
+		puzzle = solution;
+		removeClues(gen, &puzzle, clueFloor[level]);
+		GradeResult grade;
+		if (!gradeLogically(&puzzle, &grade) || grade.level != level) continue;
+		memset(out, 0, sizeof(*out));
+		gen->generated++;
+		snprintf(out->name, sizeof(out->name), "Generated %llu", gen->generated);
+		out->grid = puzzle;
+		out->solution = solution;
+		out->solutionCount = SOLUTIONS_UNIQUE;
+		applyGradeToPuzzle(out, &grade);
+		return true;
+	}
+	return false;
+}
+
+int writeGeneratedPuzzles(PuzzleGenerator *gen, unsigned long long count, int level, FILE *out) {
+	Puzzle puzzle;
+	char digits[82];
+	unsigned long long failed = 0;
+	for (unsigned long long i = 0; i < count; i++) {
+		int target = level >= 0 ? level : randomBelow(gen, DIFFICULTY_LEVELS);
+		if (!generatePuzzle(gen, target, &puzzle)) {
+			failed++;
+			continue;
+		}
+		formatGrid81(&puzzle.grid, digits);
+		fprintf(out, "%s|%s|%s\n", puzzle.name, puzzle.difficulty, digits);
+	}
+	if (failed) fprintf(stderr, "%llu puzzles could not be generated at the requested difficulty.\n", failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "structs.h"
+
+// Difficulty names understood by the generator and written to puzzle files.
+#define DIFFICULTY_LEVELS 4
+extern const char *const difficultyNames[DIFFICULTY_LEVELS];
+
+// Deterministic for a given seed, so a run can be reproduced exactly.
+typedef struct PuzzleGenerator {
+	uint64_t rngState;
+	unsigned long long generated;
+} PuzzleGenerator;
+
+void seedGenerator(PuzzleGenerator *gen, uint64_t seed);
+
+// Random 32-bit value from the generator's stream.
+uint32_t nextRandom(PuzzleGenerator *gen);
+
+// Fills out with a random complete, valid grid.
+void generateSolvedBoard(PuzzleGenerator *gen, Board *out);
+
+// Grades a puzzle as one of difficultyNames by the hardest human technique it needs
+// (see grader.h); returns the level index.
+int gradePuzzle(const Board *puzzle);
+
+// Produces a unique-solution puzzle graded at the target level (0..DIFFICULTY_LEVELS-1),
+// filling grid, solution, difficulty, technique hints and a name. Returns false if no puzzle of that
+// grade turned up within the attempt budget.
+bool generatePuzzle(PuzzleGenerator *gen, int level, Puzzle *out);
+
+int findDifficultyLevel(const char *name);
+
+// Writes count puzzles as "name|difficulty|digits" lines. level < 0 picks a random level per puzzle.
+int writeGeneratedPuzzles(PuzzleGenerator *gen, unsigned long long count, int level, FILE *out);
+
+#endif
@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <string.h>
+#include "grader.h"
+#include "board.h"
+#include "bitmask.h"
+#include "generator.h"
+
+// Candidates are kept per cell and only ever narrowed: placing a digit clears it from the
+// 20 peers, and each technique clears the candidates it rules out.
+typedef struct LogicBoard {
+	uint8_t cells[CELL_COUNT];
+	uint16_t cand[CELL_COUNT];
+	int empty;
+	bool broken;
+} LogicBoard;
+
+static const char *const boxNames[GRID_SIZE] = {
+	"the top-left box", "the top-middle box", "the top-right box",
+	"the middle-left box", "the center box", "the middle-right box",
+	"the bottom-left box", "the bottom-middle box", "the bottom-right box"
+};
+
+const char *techniqueName(Technique technique) {
+	switch (technique) {
+		case TECH_NAKED_SINGLE: return "Naked Single";
+		case TECH_HIDDEN_SINGLE: return "Hidden Single";
+		case TECH_POINTING: return "Pointing Pair";
+		case TECH_BOX_LINE: return "Box/Line Reduction";
+		case TECH_NAKED_PAIR: return "Naked Pair";
+		case TECH_HIDDEN_PAIR: return "Hidden Pair";
+		case TECH_NAKED_TRIPLE: return "Naked Triple";
+		case TECH_HIDDEN_TRIPLE: return "Hidden Triple";
+		case TECH_X_WING: return "X-Wing";
+		case TECH_SWORDFISH: return "Swordfish";
+		case TECH_COUNT: break;
+	}
+	return "Unknown";
+}
+
+static void placeValue(LogicBoard *b, int cell, int value) {
+	unsigned int bit = DIGIT_BIT(value);
+	if (!(b->cand[cell] & bit)) {
+		b->broken = true;
+		return;
+	}
+	int r = cell / GRID_SIZE, c = cell % GRID_SIZE, br = (r / 3) * 3, bc = (c / 3) * 3;
+	b->cells[cell] = (uint8_t)value;
+	b->cand[cell] = 0;
+	b->empty--;
+	for (int i = 0; i < GRID_SIZE; i++) {
+		b->cand[r * GRID_SIZE + i] &= (uint16_t)~bit;
+		b->cand[i * GRID_SIZE + c] &= (uint16_t)~bit;
+		b->cand[(br + i / 3) * GRID_SIZE + bc + i % 3] &= (uint16_t)~bit;
+	}
+}
+
+// Bit i set when the i-th cell of the unit still has the digit as a candidate.
+static unsigned int positionsInUnit(const LogicBoard *b, int unit, unsigned int bit) {
+	unsigned int positions = 0;
+	for (int i = 0; i < GRID_SIZE; i++) {
+		if (b->cand[unitCell(unit, i)] & bit) positions |= 1u << i;
+	}
+	return positions;
+}
+
+static bool eliminate(LogicBoard *b, int cell, unsigned int mask) {
+	if (!(b->cand[cell] & mask)) return false;
+	b->cand[cell] &= (uint16_t)~mask;
+	if (b->cells[cell] == 0 && b->cand[cell] == 0) b->broken = true;
+	return true;
+}
+
+static void initStep(GradeStep *step, Technique technique, int emptyCount) {
+	memset(step, 0, sizeof(*step));
+	step->technique = technique;
+	step->emptyCount = emptyCount;
+	step->cell = -1;
+	step->unit = -1;
+}
+
+static bool applyNakedSingle(LogicBoard *b, GradeStep *step) {
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (b->cells[cell]) continue;
+		unsigned int cand = b->cand[cell];
+		if (cand == 0) {
+			b->broken = true;
+			return false;
+		}
+		if (cand & (cand - 1)) continue;
+		initStep(step, TECH_NAKED_SINGLE, b->empty);
+		step->cell = cell;
+		step->value = lowestBitIndex(cand) + 1;
+		placeValue(b, cell, step->value);
+		return true;
+	}
+	return false;
+}
+
+static bool applyHiddenSingle(LogicBoard *b, GradeStep *step) {
+	for (int unit = 0; unit < UNIT_COUNT; unit++) {
+		unsigned int once = 0, more = 0;
+		for (int i = 0; i < GRID_SIZE; i++) {
+			unsigned int cand = b->cand[unitCell(unit, i)];
+			more |= once & cand;
+			once |= cand;
+		}
+		unsigned int singles = once & ~more;
+		if (!singles) continue;
+		unsigned int bit = singles & (0u - singles);
+		int i = lowestBitIndex(positionsInUnit(b, unit, bit));
+		initStep(step, TECH_HIDDEN_SINGLE, b->empty);
+		step->cell = unitCell(unit, i);
+		step->value = lowestBitIndex(bit) + 1;
+		step->unit = unit;
+		placeValue(b, step->cell, step->value);
+		return true;
+	}
+	return false;
+}
+
+// Box -> line: a digit confined to one row or column of a box leaves the rest of that line.
+static bool applyPointing(LogicBoard *b, GradeStep *step) {
+	for (int box = 0; box < GRID_SIZE; box++) {
+		int unit = 2 * GRID_SIZE + box;
+		for (int d = 1; d <= 9; d++) {
+			unsigned int bit = DIGIT_BIT(d);
+			unsigned int pos = positionsInUnit(b, unit, bit);
+			if (bitCount(pos) < 2) continue;
+			int lineUnit = -1;
+			if ((pos & 0x007u) == pos || (pos & 0x038u) == pos || (pos & 0x1C0u) == pos) {
+				lineUnit = (box / 3) * 3 + lowestBitIndex(pos) / 3; // a row
+			} else if ((pos & 0x049u) == pos || (pos & 0x092u) == pos || (pos & 0x124u) == pos) {
+				lineUnit = GRID_SIZE + (box % 3) * 3 + lowestBitIndex(pos) % 3; // a column
+			}
+			if (lineUnit < 0) continue;
+			bool changed = false;
+			for (int i = 0; i < GRID_SIZE; i++) {
+				int cell = unitCell(lineUnit, i);
+				if (BOX_INDEX(cell / GRID_SIZE, cell % GRID_SIZE) == box) continue;
+				changed |= eliminate(b, cell, bit);
+			}
+			if (changed) {
+				initStep(step, TECH_POINTING, b->empty);
+				step->unit = unit;
+				step->value = d;
+				step->lines[0] = lineUnit;
+				step->lineCount = 1;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Line -> box: a digit confined to one box within a row or column leaves the rest of that box.
+static bool applyBoxLine(LogicBoard *b, GradeStep *step) {
+	for (int unit = 0; unit < 2 * GRID_SIZE; unit++) {
+		for (int d = 1; d <= 9; d++) {
+			unsigned int bit = DIGIT_BIT(d);
+			unsigned int pos = positionsInUnit(b, unit, bit);
+			if (bitCount(pos) < 2) continue;
+			if ((pos & 0x007u) != pos && (pos & 0x038u) != pos && (pos & 0x1C0u) != pos) continue;
+			int first = unitCell(unit, lowestBitIndex(pos));
+			int box = BOX_INDEX(first / GRID_SIZE, first % GRID_SIZE);
+			int boxUnit = 2 * GRID_SIZE + box;
+			bool changed = false;
+			for (int i = 0; i < GRID_SIZE; i++) {
+				int cell = unitCell(boxUnit, i);
+				bool onLine = unit < GRID_SIZE ? (cell / GRID_SIZE == unit) : (cell % GRID_SIZE == unit - GRID_SIZE);
+				if (!onLine) changed |= eliminate(b, cell, bit);
+			}
+			if (changed) {
+				initStep(step, TECH_BOX_LINE, b->empty);
+				step->unit = boxUnit;
+				step->value = d;
+				step->lines[0] = unit;
+				step->lineCount = 1;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// k cells of a unit whose candidates together hold exactly k digits.
+static bool applyNakedSubset(LogicBoard *b, int k, GradeStep *step) {
+	for (int unit = 0; unit < UNIT_COUNT; unit++) {
+		int members[GRID_SIZE], n = 0;
+		for (int i = 0; i < GRID_SIZE; i++) {
+			int cell = unitCell(unit, i);
+			int count = bitCount(b->cand[cell]);
+			if (count >= 2 && count <= k) members[n++] = cell;
+		}
+		for (int x = 0; x < n; x++) {
+			for (int y = x + 1; y < n; y++) {
+				for (int z = (k == 3 ? y + 1 : n); z < (k == 3 ? n : n + 1); z++) {
+					unsigned int digits = b->cand[members[x]] | b->cand[members[y]];
+					if (k == 3) digits |= b->cand[members[z]];
+					if (bitCount(digits) != k) continue;
+					bool changed = false;
+					for (int i = 0; i < GRID_SIZE; i++) {
+						int cell = unitCell(unit, i);
+						if (cell == members[x] || cell == members[y] || (k == 3 && cell == members[z])) continue;
+						changed |= eliminate(b, cell, digits);
+					}
+					if (changed) {
+						initStep(step, k == 2 ? TECH_NAKED_PAIR : TECH_NAKED_TRIPLE, b->empty);
+						step->unit = unit;
+						step->digits = digits;
+						step->cells[0] = members[x];
+						step->cells[1] = members[y];
+						step->cells[2] = k == 3 ? members[z] : -1;
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// k digits of a unit that can only go in the same k cells.
+static bool applyHiddenSubset(LogicBoard *b, int k, GradeStep *step) {
+	for (int unit = 0; unit < UNIT_COUNT; unit++) {
+		int digits[GRID_SIZE], n = 0;
+		unsigned int positions[10] = { 0 };
+		for (int d = 1; d <= 9; d++) {
+			positions[d] = positionsInUnit(b, unit, DIGIT_BIT(d));
+			int count = bitCount(positions[d]);
+			if (count >= 1 && count <= k) digits[n++] = d;
+		}
+		for (int x = 0; x < n; x++) {
+			for (int y = x + 1; y < n; y++) {
+				for (int z = (k == 3 ? y + 1 : n); z < (k == 3 ? n : n + 1); z++) {
+					unsigned int cells = positions[digits[x]] | positions[digits[y]];
+					unsigned int keep = DIGIT_BIT(digits[x]) | DIGIT_BIT(digits[y]);
+					if (k == 3) {
+						cells |= positions[digits[z]];
+						keep |= DIGIT_BIT(digits[z]);
+					}
+					if (bitCount(cells) != k) continue;
+					bool changed = false;
+					int found[3] = { -1, -1, -1 }, f = 0;
+					for (unsigned int rest = cells; rest; rest &= rest - 1) {
+						int cell = unitCell(unit, lowestBitIndex(rest));
+						found[f++] = cell;
+						changed |= eliminate(b, cell, ALL_DIGITS_MASK & ~keep);
+					}
+					if (changed) {
+						initStep(step, k == 2 ? TECH_HIDDEN_PAIR : TECH_HIDDEN_TRIPLE, b->empty);
+						step->unit = unit;
+						step->digits = keep;
+						memcpy(step->cells, found, sizeof(found));
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// X-Wing (k = 2) and Swordfish (k = 3): k rows whose candidate positions for a digit fall in
+// exactly k columns rule that digit out of those columns elsewhere (and with rows and
+// columns swapped).
+static bool applyFish(LogicBoard *b, int k, GradeStep *step) {
+	for (int byColumn = 0; byColumn < 2; byColumn++) {
+		for (int d = 1; d <= 9; d++) {
+			unsigned int bit = DIGIT_BIT(d);
+			int lines[GRID_SIZE], n = 0;
+			unsigned int positions[GRID_SIZE];
+			for (int line = 0; line < GRID_SIZE; line++) {
+				positions[line] = positionsInUnit(b, byColumn ? GRID_SIZE + line : line, bit);
+				int count = bitCount(positions[line]);
+				if (count >= 2 && count <= k) lines[n++] = line;
+			}
+			for (int x = 0; x < n; x++) {
+				for (int y = x + 1; y < n; y++) {
+					for (int z = (k == 3 ? y + 1 : n); z < (k == 3 ? n : n + 1); z++) {
+						unsigned int cover = positions[lines[x]] | positions[lines[y]];
+						if (k == 3) cover |= positions[lines[z]];
+						if (bitCount(cover) != k) continue;
+						bool changed = false;
+						for (int line = 0; line < GRID_SIZE; line++) {
+							if (line == lines[x] || line == lines[y] || (k == 3 && line == lines[z])) continue;
+							for (unsigned int rest = cover; rest; rest &= rest - 1) {
+								int other = lowestBitIndex(rest);
+								int cell = byColumn ? other * GRID_SIZE + line : line * GRID_SIZE + other;
+								changed |= eliminate(b, cell, bit);
+							}
+						}
+						if (changed) {
+							initStep(step, k == 2 ? TECH_X_WING : TECH_SWORDFISH, b->empty);
+							step->value = d;
+							step->lines[0] = lines[x];
+							step->lines[1] = lines[y];
+							step->lines[2] = k == 3 ? lines[z] : -1;
+							step->lineCount = k;
+							step->cover = cover;
+							step->byColumn = byColumn != 0;
+							return true;
+						}
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+static bool applyTechnique(LogicBoard *b, Technique technique, GradeStep *step) {
+	switch (technique) {
+		case TECH_NAKED_SINGLE: return applyNakedSingle(b, step);
+		case TECH_HIDDEN_SINGLE: return applyHiddenSingle(b, step);
+		case TECH_POINTING: return applyPointing(b, step);
+		case TECH_BOX_LINE: return applyBoxLine(b, step);
+		case TECH_NAKED_PAIR: return applyNakedSubset(b, 2, step);
+		case TECH_HIDDEN_PAIR: return applyHiddenSubset(b, 2, step);
+		case TECH_NAKED_TRIPLE: return applyNakedSubset(b, 3, step);
+		case TECH_HIDDEN_TRIPLE: return applyHiddenSubset(b, 3, step);
+		case TECH_X_WING: return applyFish(b, 2, step);
+		case TECH_SWORDFISH: return applyFish(b, 3, step);
+		case TECH_COUNT: break;
+	}
+	return false;
+}
+
+bool gradeLogically(const Board *puzzle, GradeResult *out) {
+	memset(out, 0, sizeof(*out));
+	out->hardest = -1;
+	LogicBoard b;
+	memset(&b, 0, sizeof(b));
+	b.empty = CELL_COUNT;
+	for (int cell = 0; cell < CELL_COUNT; cell++) b.cand[cell] = ALL_DIGITS_MASK;
+	for (int cell = 0; cell < CELL_COUNT && !b.broken; cell++) {
+		int v = puzzle->cells[cell];
+		if (v > 9) return false;
+		if (v) placeValue(&b, cell, v);
+	}
+	if (b.broken) return false;
+
+	while (b.empty > 0 && !b.broken) {
+		GradeStep step;
+		bool progressed = false;
+		for (int t = 0; t < TECH_COUNT && !progressed; t++) {
+			if (!applyTechnique(&b, (Technique)t, &step)) continue;
+			progressed = true;
+			if (!(out->usedMask & (1u << t))) out->firstUse[t] = step;
+			out->usedMask |= 1u << t;
+			out->counts[t]++;
+			if (t > out->hardest) out->hardest = t;
+		}
+		if (!progressed) break;
+	}
+	if (b.broken) return false;
+	out->solved = (b.empty == 0);
+	// Easy: singles; Medium: box/line intersections; Hard: subsets; Expert: fish or beyond.
+	if (!out->solved || out->hardest >= TECH_X_WING) out->level = 3;
+	else if (out->hardest >= TECH_NAKED_PAIR) out->level = 2;
+	else if (out->hardest >= TECH_POINTING) out->level = 1;
+	else out->level = 0;
+	return true;
+}
+
+static void describeUnit(int unit, char *out, size_t outSize) {
+	if (unit < GRID_SIZE) snprintf(out, outSize, "row %d", unit + 1);
+	else if (unit < 2 * GRID_SIZE) snprintf(out, outSize, "column %d", unit - GRID_SIZE + 1);
+	else snprintf(out, outSize, "%s", boxNames[unit - 2 * GRID_SIZE]);
+}
+
+static void describeDigits(unsigned int digits, char *out, size_t outSize) {
+	size_t used = 0;
+	out[0] = '\0';
+	for (int d = 1; d <= 9 && used + 8 < outSize; d++) {
+		if (!(digits & DIGIT_BIT(d))) continue;
+		used += (size_t)snprintf(out + used, outSize - used, "%s'%d'", used ? ", " : "", d);
+	}
+}
+
+static void describeCells(const int cells[3], char *out, size_t outSize) {
+	size_t used = 0;
+	out[0] = '\0';
+	for (int i = 0; i < 3 && cells[i] >= 0 && used + 12 < outSize; i++) {
+		used += (size_t)snprintf(out + used, outSize - used, "%sR%dC%d", used ? ", " : "",
+			cells[i] / GRID_SIZE + 1, cells[i] % GRID_SIZE + 1);
+	}
+}
+
+static void describeLines(const int *values, int count, char *out, size_t outSize) {
+	size_t used = 0;
+	out[0] = '\0';
+	for (int i = 0; i < count && used + 8 < outSize; i++) {
+		const char *sep = i == 0 ? "" : (i == count - 1 ? " and " : ", ");
+		used += (size_t)snprintf(out + used, outSize - used, "%s%d", sep, values[i] + 1);
+	}
+}
+
+static void formatHint(const GradeStep *step, Hint *hint) {
+	char unit[32], other[32], digits[48], cells[48], lines[32], cover[32];
+	const char *name = techniqueName(step->technique);
+	hint->triggerCellCount = step->emptyCount;
+	hint->hintRow = -1;
+	hint->hintCol = -1;
+	hint->hintValue = 0;
+	if (step->unit >= 0) describeUnit(step->unit, unit, sizeof(unit));
+	switch (step->technique) {
+		case TECH_NAKED_SINGLE:
+			snprintf(hint->message, sizeof(hint->message),
+				"\n\nHINT: Naked Single! Look closely at R%dC%d."
+				" Check its row, column, and 3x3 box; only '%d' fits.\n\n",
+				step->cell / GRID_SIZE + 1, step->cell % GRID_SIZE + 1, step->value);
+			break;
+		case TECH_HIDDEN_SINGLE:
+			snprintf(hint->message, sizeof(hint->message),
+				"\n\nHINT: Hidden Single! In %s, '%d' can only go in one cell: R%dC%d.\n\n",
+				unit, step->value, step->cell / GRID_SIZE + 1, step->cell % GRID_SIZE + 1);
+			break;
+		case TECH_POINTING:
+		case TECH_BOX_LINE:
+			describeUnit(step->lines[0], other, sizeof(other));
+			if (step->technique == TECH_POINTING) {
+				snprintf(hint->message, sizeof(hint->message),
+					"\n\nHINT: %s! In %s, '%d' can only go in %s."
+					"\nRemove '%d' from the rest of %s.\n\n", name, unit, step->value, other, step->value, other);
+			} else {
+				snprintf(hint->message, sizeof(hint->message),
+					"\n\nHINT: %s! In %s, '%d' can only go inside %s."
+					"\nRemove '%d' from the rest of that box.\n\n", name, other, step->value, unit, step->value);
+			}
+			break;
+		case TECH_NAKED_PAIR:
+		case TECH_NAKED_TRIPLE:
+			describeDigits(step->digits, digits, sizeof(digits));
+			describeCells(step->cells, cells, sizeof(cells));
+			snprintf(hint->message, sizeof(hint->message),
+				"\n\nHINT: %s! In %s, cells %s can only hold %s."
+				"\nRemove those digits from the other cells of %s.\n\n", name, unit, cells, digits, unit);
+			break;
+		case TECH_HIDDEN_PAIR:
+		case TECH_HIDDEN_TRIPLE:
+			describeDigits(step->digits, digits, sizeof(digits));
+			describeCells(step->cells, cells, sizeof(cells));
+			snprintf(hint->message, sizeof(hint->message),
+				"\n\nHINT: %s! In %s, %s can ONLY go in %s."
+				"\nYou can safely remove any other candidates from those cells.\n\n", name, unit, digits, cells);
+			break;
+		case TECH_X_WING:
+		case TECH_SWORDFISH: {
+			int coverLines[3], n = 0;
+			for (unsigned int rest = step->cover; rest && n < 3; rest &= rest - 1) coverLines[n++] = lowestBitIndex(rest);
+			describeLines(step->lines, step->lineCount, lines, sizeof(lines));
+			describeLines(coverLines, n, cover, sizeof(cover));
+			snprintf(hint->message, sizeof(hint->message),
+				"\n\nHINT: %s! In %s %s, '%d' is limited to %s %s."
+				"\nEliminate all other '%d' candidates from those %s.\n\n",
+				name, step->byColumn ? "columns" : "rows", lines, step->value,
+				step->byColumn ? "rows" : "columns", cover, step->value, step->byColumn ? "rows" : "columns");
+			break;
+		}
+		case TECH_COUNT:
+			hint->message[0] = '\0';
+			break;
+	}
+	if (step->cell >= 0) {
+		hint->hintRow = step->cell / GRID_SIZE;
+		hint->hintCol = step->cell % GRID_SIZE;
+		hint->hintValue = step->value;
+	}
+}
+
+void applyGradeToPuzzle(Puzzle *puzzle, const GradeResult *grade) {
+	snprintf(puzzle->difficulty, sizeof(puzzle->difficulty), "%s", difficultyNames[grade->level]);
+	int initialEmpty = countEmptyCells(&puzzle->grid);
+	const GradeStep *ordered[TECH_COUNT];
+	int n = 0;
+	for (int t = 0; t < TECH_COUNT; t++) {
+		// A step needed before the first move could never be triggered by a move.
+		if ((grade->usedMask & (1u << t)) && grade->firstUse[t].emptyCount < initialEmpty) {
+			ordered[n++] = &grade->firstUse[t];
+		}
+	}
+	// Hints are shown in sequence as the board empties, so order them by trigger count.
+	for (int i = 1; i < n; i++) {
+		const GradeStep *step = ordered[i];
+		int j = i;
+		while (j > 0 && ordered[j - 1]->emptyCount < step->emptyCount) {
+			ordered[j] = ordered[j - 1];
+			j--;
+		}
+		ordered[j] = step;
+	}
+	size_t maxHints = sizeof(puzzle->hints) / sizeof(puzzle->hints[0]);
+	puzzle->numHints = 0;
+	for (int i = 0; i < n && puzzle->numHints < maxHints; i++) {
+		formatHint(ordered[i], &puzzle->hints[puzzle->numHints++]);
+	}
+}
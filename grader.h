@@ -0,0 +1,56 @@
+#ifndef GRADER_H
+#define GRADER_H
+
+#include <stdbool.h>
+#include "structs.h"
+
+// Human solving techniques, in the order the grader tries them (easiest first).
+typedef enum Technique {
+	TECH_NAKED_SINGLE,
+	TECH_HIDDEN_SINGLE,
+	TECH_POINTING,
+	TECH_BOX_LINE,
+	TECH_NAKED_PAIR,
+	TECH_HIDDEN_PAIR,
+	TECH_NAKED_TRIPLE,
+	TECH_HIDDEN_TRIPLE,
+	TECH_X_WING,
+	TECH_SWORDFISH,
+	TECH_COUNT
+} Technique;
+
+// One application of a technique, kept so it can be turned into a hint.
+typedef struct GradeStep {
+	Technique technique;
+	int emptyCount;    // empty cells on the board when the step applied
+	int cell;          // placed cell for singles, otherwise -1
+	int value;         // placed digit for singles, or the fish / pointing digit
+	int unit;          // unit the step was found in (see unitCell), or -1
+	int cells[3];      // subset cells for pairs and triples
+	unsigned int digits; // digit mask of a subset
+	int lines[3];      // base rows or columns of a fish, or the line of a pointing step
+	int lineCount;
+	unsigned int cover; // cover positions (columns or rows) of a fish
+	bool byColumn;     // fish based on columns instead of rows
+} GradeStep;
+
+typedef struct GradeResult {
+	bool solved;               // finished by the techniques above, without guessing
+	int level;                 // index into difficultyNames
+	int hardest;               // hardest Technique used, or -1
+	unsigned int usedMask;     // bit t set when technique t was needed
+	unsigned int counts[TECH_COUNT];
+	GradeStep firstUse[TECH_COUNT];
+} GradeResult;
+
+const char *techniqueName(Technique technique);
+
+// Solves logically on incremental candidate masks, recording which techniques were needed.
+// Returns false when the givens contradict each other.
+bool gradeLogically(const Board *puzzle, GradeResult *out);
+
+// Sets puzzle->difficulty from the grade and replaces its hints with ones for the first use of
+// each technique, triggered at the empty-cell count where that technique was first needed.
+void applyGradeToPuzzle(Puzzle *puzzle, const GradeResult *grade);
+
+#endif
@@ -0,0 +1,387 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "leaderboard.h"
+#include "file_io.h"
+#include "save_format.h"
+
+#define TABLES_OFFSET ((uint64_t)SCORE_HEADER_BYTES)
+#define RECORDS_OFFSET (TABLES_OFFSET + (uint64_t)SCORE_TABLE_BYTES * LEADERBOARD_GROUPS)
+
+static const char scoreMagic[8] = { 'S', 'M', 'S', 'C', 'O', 'R', 'E', 0 };
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+	put32(p, (uint32_t)v);
+	put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get64(const uint8_t *p) {
+	return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+static void encodeHeader(const ScoreFileHeader *h, uint8_t *out) {
+	memcpy(out, h->magic, sizeof(h->magic));
+	put32(out + 8, h->version);
+	put32(out + 12, h->recordSize);
+	put32(out + 16, h->groups);
+	put32(out + 20, h->capacity);
+	put64(out + 24, h->indexedRecords);
+	put32(out + 32, h->tablesCrc);
+	put32(out + 36, h->reserved);
+}
+
+static void decodeHeader(const uint8_t *in, ScoreFileHeader *h) {
+	memcpy(h->magic, in, sizeof(h->magic));
+	h->version = get32(in + 8);
+	h->recordSize = get32(in + 12);
+	h->groups = get32(in + 16);
+	h->capacity = get32(in + 20);
+	h->indexedRecords = get64(in + 24);
+	h->tablesCrc = get32(in + 32);
+	h->reserved = get32(in + 36);
+}
+
+static void encodeTable(const ScoreTable *table, uint8_t *out) {
+	put32(out, table->count);
+	put32(out + 4, table->reserved);
+	for (int i = 0; i < LEADERBOARD_CAPACITY; i++) {
+		put32(out + 8 + 8 * i, table->entries[i].seconds);
+		put32(out + 12 + 8 * i, table->entries[i].record);
+	}
+}
+
+static void decodeTable(const uint8_t *in, ScoreTable *table) {
+	table->count = get32(in);
+	table->reserved = get32(in + 4);
+	for (int i = 0; i < LEADERBOARD_CAPACITY; i++) {
+		table->entries[i].seconds = get32(in + 8 + 8 * i);
+		table->entries[i].record = get32(in + 12 + 8 * i);
+	}
+}
+
+// Tables are checksummed in their encoded form, so the CRC is the same on every host.
+static uint32_t tablesCrc(const ScoreTable *tables) {
+	uint8_t encoded[SCORE_TABLE_BYTES * LEADERBOARD_GROUPS];
+	for (int g = 0; g < LEADERBOARD_GROUPS; g++) encodeTable(&tables[g], encoded + g * SCORE_TABLE_BYTES);
+	return crc32Bytes(encoded, sizeof(encoded));
+}
+
+static void encodeRecord(const ScoreRecord *record, uint8_t *out) {
+	put32(out, record->seconds);
+	put32(out + 4, record->reserved);
+	put64(out + 8, (uint64_t)record->recordedAt);
+	memcpy(out + 16, record->difficulty, sizeof(record->difficulty));
+	memcpy(out + 48, record->puzzleName, sizeof(record->puzzleName));
+}
+
+// Reads the record at the current file position; the strings come back terminated.
+static bool readRecord(FILE *f, ScoreRecord *record) {
+	uint8_t in[SCORE_RECORD_BYTES];
+	if (fread(in, sizeof(in), 1, f) != 1) return false;
+	record->seconds = get32(in);
+	record->reserved = get32(in + 4);
+	record->recordedAt = (int64_t)get64(in + 8);
+	memcpy(record->difficulty, in + 16, sizeof(record->difficulty));
+	memcpy(record->puzzleName, in + 48, sizeof(record->puzzleName));
+	record->difficulty[sizeof(record->difficulty) - 1] = '\0';
+	record->puzzleName[sizeof(record->puzzleName) - 1] = '\0';
+	return true;
+}
+
+static void copyString(char *dst, const char *src, size_t dstSize) {
+	if (!dst || !src || dstSize == 0) return;
+	size_t i = 0;
+	while (i + 1 < dstSize && src[i] != '\0') {
+		dst[i] = src[i];
+		i++;
+	}
+	dst[i] = '\0';
+}
+
+static bool seekTo(FILE *f, uint64_t offset) {
+#ifdef _WIN32
+	return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+	return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool fileSize(FILE *f, uint64_t *size) {
+#ifdef _WIN32
+	if (_fseeki64(f, 0, SEEK_END) != 0) return false;
+	long long end = _ftelli64(f);
+#else
+	if (fseeko(f, 0, SEEK_END) != 0) return false;
+	long long end = (long long)ftello(f);
+#endif
+	if (end < 0) return false;
+	*size = (uint64_t)end;
+	return true;
+}
+
+int leaderboardGroup(const char *difficulty) {
+	int level = findDifficultyLevel(difficulty);
+	return level >= 0 ? level : LEADERBOARD_OTHER;
+}
+
+// Slower times rank lower; equal times keep the order they were recorded in.
+static bool ranksBelow(const ScoreEntry *a, const ScoreEntry *b) {
+	if (a->seconds != b->seconds) return a->seconds > b->seconds;
+	return a->record > b->record;
+}
+
+static void swapEntries(ScoreEntry *a, ScoreEntry *b) {
+	ScoreEntry t = *a;
+	*a = *b;
+	*b = t;
+}
+
+// Keeps entry if it is among the table's best; returns whether the table changed.
+static bool offerScore(ScoreTable *table, ScoreEntry entry) {
+	ScoreEntry *heap = table->entries;
+	uint32_t i;
+	if (table->count < LEADERBOARD_CAPACITY) {
+		i = table->count++;
+		heap[i] = entry;
+		while (i > 0 && ranksBelow(&heap[i], &heap[(i - 1) / 2])) {
+			swapEntries(&heap[i], &heap[(i - 1) / 2]);
+			i = (i - 1) / 2;
+		}
+		return true;
+	}
+	if (!ranksBelow(&heap[0], &entry)) return false;
+	heap[0] = entry;
+	i = 0;
+	for (;;) {
+		uint32_t worst = i, left = 2 * i + 1, right = left + 1;
+		if (left < table->count && ranksBelow(&heap[left], &heap[worst])) worst = left;
+		if (right < table->count && ranksBelow(&heap[right], &heap[worst])) worst = right;
+		if (worst == i) break;
+		swapEntries(&heap[i], &heap[worst]);
+		i = worst;
+	}
+	return true;
+}
+
+// Writes the header and the tables selected by dirty (one bit per group).
+static bool writeIndex(Leaderboard *board, unsigned dirty) {
+	board->header.indexedRecords = board->recordCount;
+	board->header.tablesCrc = tablesCrc(board->tables);
+	uint8_t header[SCORE_HEADER_BYTES];
+	encodeHeader(&board->header, header);
+	if (!seekTo(board->file, 0) || fwrite(header, sizeof(header), 1, board->file) != 1) return false;
+	for (int g = 0; g < LEADERBOARD_GROUPS; g++) {
+		if (!(dirty & (1u << g))) continue;
+		uint8_t table[SCORE_TABLE_BYTES];
+		encodeTable(&board->tables[g], table);
+		if (!seekTo(board->file, TABLES_OFFSET + (uint64_t)g * SCORE_TABLE_BYTES)) return false;
+		if (fwrite(table, sizeof(table), 1, board->file) != 1) return false;
+	}
+	return fflush(board->file) == 0;
+}
+
+static unsigned indexRecord(Leaderboard *board, const ScoreRecord *record, uint64_t index) {
+	ScoreEntry entry = { record->seconds, (uint32_t)index };
+	unsigned dirty = 0;
+	int group = leaderboardGroup(record->difficulty);
+	if (offerScore(&board->tables[group], entry)) dirty |= 1u << group;
+	if (offerScore(&board->tables[LEADERBOARD_ALL], entry)) dirty |= 1u << LEADERBOARD_ALL;
+	return dirty;
+}
+
+// Appends at the current file position, which the caller has put at the end of the records.
+static bool appendRecord(Leaderboard *board, const char *difficulty, const char *puzzleName, unsigned int seconds,
+	int64_t recordedAt, unsigned *dirty) {
+	if (board->recordCount >= UINT32_MAX) return false;
+	ScoreRecord record;
+	memset(&record, 0, sizeof(record));
+	record.seconds = seconds;
+	record.recordedAt = recordedAt;
+	copyString(record.difficulty, difficulty, sizeof(record.difficulty));
+	copyString(record.puzzleName, puzzleName, sizeof(record.puzzleName));
+	uint8_t encoded[SCORE_RECORD_BYTES];
+	encodeRecord(&record, encoded);
+	if (fwrite(encoded, sizeof(encoded), 1, board->file) != 1) return false;
+	*dirty |= indexRecord(board, &record, board->recordCount++);
+	return true;
+}
+
+static bool seekToEnd(Leaderboard *board) {
+	return seekTo(board->file, RECORDS_OFFSET + board->recordCount * SCORE_RECORD_BYTES);
+}
+
+static bool tablesValid(const Leaderboard *board) {
+	if (tablesCrc(board->tables) != board->header.tablesCrc) return false;
+	if (board->header.indexedRecords > board->recordCount) return false;
+	for (int g = 0; g < LEADERBOARD_GROUPS; g++) {
+		const ScoreTable *table = &board->tables[g];
+		if (table->count > LEADERBOARD_CAPACITY) return false;
+		for (uint32_t i = 0; i < table->count; i++) {
+			if (table->entries[i].record >= board->header.indexedRecords) return false;
+		}
+	}
+	return true;
+}
+
+// Indexes the records the tables do not cover yet: normally none, all of them when the
+// tables were found damaged.
+static bool catchUp(Leaderboard *board) {
+	uint64_t first = board->header.indexedRecords;
+	if (first == board->recordCount) return true;
+	if (!seekTo(board->file, RECORDS_OFFSET + first * SCORE_RECORD_BYTES)) return false;
+	unsigned dirty = 0;
+	ScoreRecord record;
+	for (uint64_t i = first; i < board->recordCount; i++) {
+		if (!readRecord(board->file, &record)) return false;
+		dirty |= indexRecord(board, &record, i);
+	}
+	return writeIndex(board, dirty | (first == 0 ? ~0u : 0u));
+}
+
+static bool readTables(Leaderboard *board) {
+	if (!seekTo(board->file, TABLES_OFFSET)) return false;
+	for (int g = 0; g < LEADERBOARD_GROUPS; g++) {
+		uint8_t table[SCORE_TABLE_BYTES];
+		if (fread(table, sizeof(table), 1, board->file) != 1) return false;
+		decodeTable(table, &board->tables[g]);
+	}
+	return true;
+}
+
+static bool loadExisting(Leaderboard *board) {
+	uint64_t size;
+	uint8_t header[SCORE_HEADER_BYTES];
+	if (fread(header, sizeof(header), 1, board->file) != 1) return false;
+	decodeHeader(header, &board->header);
+	const ScoreFileHeader *h = &board->header;
+	if (memcmp(h->magic, scoreMagic, sizeof(scoreMagic)) != 0 || h->version != SCORE_FILE_VERSION
+		|| h->recordSize != SCORE_RECORD_BYTES || h->groups != LEADERBOARD_GROUPS || h->capacity != LEADERBOARD_CAPACITY) {
+		return false;
+	}
+	if (!fileSize(board->file, &size) || size < RECORDS_OFFSET) return false;
+	// A torn final record is left out and overwritten by the next append.
+	board->recordCount = (size - RECORDS_OFFSET) / SCORE_RECORD_BYTES;
+	if (!readTables(board) || !tablesValid(board)) {
+		memset(board->tables, 0, sizeof(board->tables));
+		board->header.indexedRecords = 0;
+	}
+	return catchUp(board);
+}
+
+static bool createNew(Leaderboard *board, const char *legacyTextPath) {
+	memcpy(board->header.magic, scoreMagic, sizeof(scoreMagic));
+	board->header.version = SCORE_FILE_VERSION;
+	board->header.recordSize = SCORE_RECORD_BYTES;
+	board->header.groups = LEADERBOARD_GROUPS;
+	board->header.capacity = LEADERBOARD_CAPACITY;
+	if (!writeIndex(board, ~0u)) return false;
+	if (legacyTextPath) {
+		FILE *legacy = fopen(legacyTextPath, "r");
+		if (legacy) {
+			fclose(legacy);
+			unsigned long long imported;
+			return importHighScoreText(board, legacyTextPath, &imported);
+		}
+	}
+	return true;
+}
+
+bool openLeaderboard(Leaderboard *board, const char *path, const char *legacyTextPath) {
+	memset(board, 0, sizeof(*board));
+	board->file = fopen(path, "r+b");
+	bool ok;
+	if (board->file) {
+		ok = loadExisting(board);
+	} else {
+		board->file = fopen(path, "w+b");
+		ok = board->file && createNew(board, legacyTextPath);
+	}
+	if (!ok) closeLeaderboard(board);
+	return ok;
+}
+
+void closeLeaderboard(Leaderboard *board) {
+	if (board->file) fclose(board->file);
+	board->file = NULL;
+}
+
+bool recordScore(Leaderboard *board, const char *difficulty, const char *puzzleName, unsigned int seconds) {
+	if (!board->file || !seekToEnd(board)) return false;
+	unsigned dirty = 0;
+	if (!appendRecord(board, difficulty, puzzleName, seconds, (int64_t)time(NULL), &dirty)) return false;
+	// The record is flushed before the tables that point at it.
+	if (fflush(board->file) != 0) return false;
+	return writeIndex(board, dirty);
+}
+
+bool importHighScoreText(Leaderboard *board, const char *path, unsigned long long *imported) {
+	*imported = 0;
+	LineReader reader;
+	if (!board->file || !openLineReader(&reader, path)) return false;
+	bool ok = seekToEnd(board);
+	unsigned dirty = 0;
+	char *line;
+	size_t len;
+	while (ok && (line = readNextLine(&reader, &len)) != NULL) {
+		// difficulty<TAB>name<TAB>seconds
+		char *tab1 = strchr(line, '\t');
+		char *tab2 = tab1 ? strchr(tab1 + 1, '\t') : NULL;
+		if (!tab2) continue;
+		*tab1 = '\0';
+		*tab2 = '\0';
+		char *end;
+		unsigned long seconds = strtoul(tab2 + 1, &end, 10);
+		if (end == tab2 + 1 || seconds > UINT32_MAX) continue;
+		ok = appendRecord(board, line, tab1 + 1, (unsigned int)seconds, 0, &dirty);
+		if (ok) (*imported)++;
+	}
+	closeLineReader(&reader);
+	if (fflush(board->file) != 0) ok = false;
+	return writeIndex(board, dirty) && ok;
+}
+
+static int compareEntries(const void *a, const void *b) {
+	const ScoreEntry *ea = (const ScoreEntry*)a;
+	const ScoreEntry *eb = (const ScoreEntry*)b;
+	if (ranksBelow(ea, eb)) return 1;
+	if (ranksBelow(eb, ea)) return -1;
+	return 0;
+}
+
+int topScores(Leaderboard *board, int group, ScoreRecord *out, int maxCount) {
+	if (!board->file || group < 0 || group >= LEADERBOARD_GROUPS || maxCount <= 0) return 0;
+	ScoreTable sorted = board->tables[group];
+	qsort(sorted.entries, sorted.count, sizeof(ScoreEntry), compareEntries);
+	int n = 0;
+	for (uint32_t i = 0; i < sorted.count && n < maxCount; i++) {
+		if (!seekTo(board->file, RECORDS_OFFSET + (uint64_t)sorted.entries[i].record * SCORE_RECORD_BYTES)) break;
+		if (!readRecord(board->file, &out[n])) break;
+		n++;
+	}
+	return n;
+}
+
+void printTopHighScores(Leaderboard *board, int group, int topN) {
+	if (topN <= 0) topN = 10;
+	if (topN > LEADERBOARD_CAPACITY) topN = LEADERBOARD_CAPACITY;
+	ScoreRecord scores[LEADERBOARD_CAPACITY];
+	int n = topScores(board, group, scores, topN);
+	if (n == 0) { printf("No high scores yet.\n"); return; }
+	if (group == LEADERBOARD_ALL) printf("Top %d High Scores (best times)\n", topN);
+	else printf("Top %d %s High Scores\n", topN, group < DIFFICULTY_LEVELS ? difficultyNames[group] : "Other");
+	for (int i = 0; i < n; i++) {
+		unsigned int m = scores[i].seconds / 60, s = scores[i].seconds % 60;
+		printf("%2d) %s | %s | %02u:%02u\n", i + 1, scores[i].difficulty, scores[i].puzzleName, m, s);
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "generator.h"
+
+// One board per entry of difficultyNames, one for any other label, and one across all.
+#define LEADERBOARD_OTHER DIFFICULTY_LEVELS
+#define LEADERBOARD_ALL (DIFFICULTY_LEVELS + 1)
+#define LEADERBOARD_GROUPS (DIFFICULTY_LEVELS + 2)
+// Best times kept per board; a top-N query never needs more than this.
+#define LEADERBOARD_CAPACITY 100
+
+// High-score store, version 1. Every field is written explicitly in little-endian order,
+// in the order the structs below declare them:
+//   header (40 bytes) | table (8 + 8 * LEADERBOARD_CAPACITY bytes) per group | record (112 bytes)...
+// Records are appended and never rewritten. Each table is a max-heap of the board's best
+// times (worst of them at the root), so a new score costs one append plus an O(log
+// capacity) heap update, and a top-N query reads one table instead of every record.
+#define SCORE_FILE_VERSION 1u
+#define SCORE_HEADER_BYTES 40
+#define SCORE_TABLE_BYTES (8 + 8 * LEADERBOARD_CAPACITY)
+#define SCORE_RECORD_BYTES 112
+
+typedef struct ScoreRecord {
+	uint32_t seconds;
+	uint32_t reserved;
+	int64_t recordedAt;        // time(NULL) when the score was added, 0 if unknown
+	char difficulty[32];
+	char puzzleName[64];
+} ScoreRecord;
+
+typedef struct ScoreEntry {
+	uint32_t seconds;
+	uint32_t record;           // index into the records
+} ScoreEntry;
+
+typedef struct ScoreTable {
+	uint32_t count;
+	uint32_t reserved;
+	ScoreEntry entries[LEADERBOARD_CAPACITY];
+} ScoreTable;
+
+typedef struct ScoreFileHeader {
+	char magic[8];             // "SMSCORE\0"
+	uint32_t version;
+	uint32_t recordSize;       // SCORE_RECORD_BYTES
+	uint32_t groups;
+	uint32_t capacity;
+	uint64_t indexedRecords;   // records the tables account for
+	uint32_t tablesCrc;        // of the encoded tables
+	uint32_t reserved;
+} ScoreFileHeader;
+
+typedef struct Leaderboard {
+	FILE *file;
+	ScoreFileHeader header;
+	ScoreTable tables[LEADERBOARD_GROUPS];
+	uint64_t recordCount;
+} Leaderboard;
+
+// Opens or creates the store. A new store first imports legacyTextPath (the old
+// "difficulty<TAB>name<TAB>seconds" highscores.txt) when that file exists. Records appended
+// after the tables were last written (a crash between the two writes) are indexed again,
+// and tables that fail their checksum are rebuilt from the records.
+bool openLeaderboard(Leaderboard *board, const char *path, const char *legacyTextPath);
+void closeLeaderboard(Leaderboard *board);
+
+bool recordScore(Leaderboard *board, const char *difficulty, const char *puzzleName, unsigned int seconds);
+
+// Appends every valid line of an old highscores.txt; *imported receives the line count.
+bool importHighScoreText(Leaderboard *board, const char *path, unsigned long long *imported);
+
+int leaderboardGroup(const char *difficulty);
+// Fills out with up to maxCount of a board's best scores, fastest first; returns how many.
+int topScores(Leaderboard *board, int group, ScoreRecord *out, int maxCount);
+
+void printTopHighScores(Leaderboard *board, int group, int topN);
+
+#endif
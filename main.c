@@ -1,379 +1,492 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <time.h>
-#include "structs.h"
-#include "cli.h"
-#include "game_logic.h"
-#include "solver.h"
-#include "file_io.h"
-
-static void copyString(char *dst, const char *src, size_t dstSize) {
-	if (!dst || !src || dstSize == 0) return;
-	size_t i = 0;
-	while (i + 1 < dstSize && src[i] != '\0') {
-		dst[i] = src[i];
-		i++;
-	}
-	dst[i] = '\0';
-}
-
-static void loadEasyGuaranteedNakedSingle(Puzzle *puzzle) {
-	// Beginner-friendly easy puzzle with at least one Naked Single
-	memset(puzzle, 0, sizeof(*puzzle));
-	copyString(puzzle->name, "Easy", sizeof(puzzle->name));
-	copyString(puzzle->difficulty, "Easy", sizeof(puzzle->difficulty));
-	int g[GRID_SIZE][GRID_SIZE] = {
-		{0,0,0, 2,6,0, 7,0,0},
-		{6,8,0, 0,7,0, 0,9,0},
-		{1,9,0, 0,0,4, 5,0,0},
-		{8,2,0, 1,0,0, 0,4,0},
-		{0,0,4, 6,0,2, 9,0,0},
-		{0,5,0, 0,0,3, 0,2,8},
-		{0,0,9, 3,0,0, 0,7,4},
-		{0,4,0, 0,5,0, 0,3,6},
-		{0,0,3, 0,1,8, 0,0,0}
-	};
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			puzzle->grid[r][c] = g[r][c];
-		}
-	}
-	// Smart hint that triggers when 38 empties AND R4,C5 is still empty, suggesting 9
-	puzzle->hints[0].triggerCellCount = 38;
-    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
-        "\n\nHINT: Naked Single! Look closely at R4C5."
-        " Check its row, column, and 3x3 box; only '9' fits.\n\n");
-	puzzle->hints[0].hintRow = 3; puzzle->hints[0].hintCol = 4; puzzle->hints[0].hintValue = 9;
-	puzzle->numHints = 1;
-}
-
-static void loadMediumHiddenPair(Puzzle *puzzle) {
-	// Medium puzzle showcasing a Hidden Pair opportunity
-	memset(puzzle, 0, sizeof(*puzzle));
-	copyString(puzzle->name, "Medium", sizeof(puzzle->name));
-	copyString(puzzle->difficulty, "Medium", sizeof(puzzle->difficulty));
-	int g[GRID_SIZE][GRID_SIZE] = {
-		{0,0,2, 0,0,0, 0,9,0},
-		{0,1,0, 5,0,7, 0,3,0},
-		{7,0,0, 0,8,0, 0,0,1},
-		{0,0,0, 0,0,0, 8,0,0},
-		{5,0,1, 0,6,0, 4,0,2},
-		{0,0,6, 0,0,0, 0,0,0},
-		{4,0,0, 0,1,0, 0,0,6},
-		{0,2,0, 6,0,5, 0,4,0},
-		{0,3,0, 0,0,0, 1,0,0}
-	};
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			puzzle->grid[r][c] = g[r][c];
-		}
-	}
-	// Smart hint that triggers when 50 empties AND both target cells still empty
-	puzzle->hints[0].triggerCellCount = 50;
-    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
-		"\n\nHINT: Hidden Pair! Look at the top-left 3x3 box. Where can the number '3' go?"
-		"\nYou'll see it can ONLY go in two cells: Row 1, Col 1 and Row 3, Col 3."
-        "\nThat's a Hidden Pair! You can safely remove any other candidates from those two spots.\n\n");
-	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
-	puzzle->numHints = 1;
-}
-
-static void loadHardXWing(Puzzle *puzzle) {
-	memset(puzzle, 0, sizeof(*puzzle));
-	copyString(puzzle->name, "Hard", sizeof(puzzle->name));
-	copyString(puzzle->difficulty, "Hard", sizeof(puzzle->difficulty));
-	int g[GRID_SIZE][GRID_SIZE] = {
-		{0,0,0, 0,0,5, 0,1,8},
-		{0,0,0, 0,0,0, 9,0,0},
-		{1,0,8, 0,9,0, 0,6,0},
-		{0,6,0, 1,0,0, 0,2,0},
-		{0,0,2, 0,0,0, 1,0,0},
-		{0,4,0, 0,0,3, 0,7,0},
-		{0,2,0, 0,1,0, 7,0,4},
-		{0,0,6, 0,0,0, 0,0,0},
-		{4,1,0, 9,0,0, 0,0,0}
-	};
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			puzzle->grid[r][c] = g[r][c];
-		}
-	}
-	puzzle->hints[0].triggerCellCount = 35;
-    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
-        "\n\nHINT: X-Wing! In Row 2, '4' is limited to Col 4 and Col 8."
-        "\nIn Row 8, it's the same two columns. This forms an X-Wing!"
-        "\nEliminate all other '4' candidates from those two columns.\n\n");
-	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
-	puzzle->numHints = 1;
-}
-
-static void loadExpertSwordfish(Puzzle *puzzle) {
-	memset(puzzle, 0, sizeof(*puzzle));
-	copyString(puzzle->name, "Expert", sizeof(puzzle->name));
-	copyString(puzzle->difficulty, "Expert", sizeof(puzzle->difficulty));
-	int g[GRID_SIZE][GRID_SIZE] = {
-		{0,0,0, 3,0,8, 0,0,2},
-		{0,0,0, 0,4,0, 7,0,0},
-		{0,0,1, 9,7,0, 0,8,0},
-		{9,0,5, 0,0,3, 0,0,6},
-		{0,3,7, 0,0,0, 5,2,0},
-		{8,0,0, 5,0,0, 9,0,3},
-		{0,7,0, 0,9,6, 1,0,0},
-		{0,0,6, 0,3,0, 0,0,0},
-		{4,0,0, 8,0,7, 0,0,0}
-	};
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			puzzle->grid[r][c] = g[r][c];
-		}
-	}
-	puzzle->hints[0].triggerCellCount = 45;
-    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
-			"\n\nHINT: Swordfish!\n"
-            "In rows 3, 7, and 8, the candidate '9'\n"
-            "appears only in columns 1, 5, and 8.\n"
-            "This forms a Swordfish; remove other '9's from those columns.\n\n");
-	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
-	puzzle->numHints = 1;
-}
-
-int main(void) {
-	MENU_START:
-	Puzzle puzzle;
-	GameState state; 
-	memset(&state, 0, sizeof(state));
-	while (1) {
-		int menu = showStartMenu();
-		if (menu == 0) {
-			printMessage("Goodbye!");
-			return 0;
-		} else if (menu == 1) {
-			while (1) {
-				int d = showDifficultyMenu();
-				if (d == 0) break;
-				if (d == 1) { 
-					loadEasyGuaranteedNakedSingle(&puzzle);
-					goto INIT_STATE;
-				} else if (d == 2) { 
-					loadMediumHiddenPair(&puzzle);
-					goto INIT_STATE;
-				} else if (d == 3) { 
-					loadHardXWing(&puzzle);
-					goto INIT_STATE;
-				} else if (d == 4) { 
-					loadExpertSwordfish(&puzzle);
-					goto INIT_STATE;
-				} else {
-					printMessage("This difficulty will be added next.");
-				}
-			}
-		} else if (menu == 2) {
-			memset(&puzzle, 0, sizeof(puzzle));
-		copyString(puzzle.name, "Custom", sizeof(puzzle.name));
-		copyString(puzzle.difficulty, "Custom", sizeof(puzzle.difficulty));
-			if (!promptCustomPuzzle(puzzle.grid)) {
-				printMessage("Cancelled.");
-				continue;
-			}
-			break;
-		} else if (menu == 3) {
-			char names[64][260];
-			int n = listSaveFiles(names, 64);
-			if (n <= 0) { printMessage("No saves found in saves/."); continue; }
-			printf("Saved games:\n");
-			for (int i = 0; i < n; i++) printf("%d) %s\n", i + 1, names[i]);
-			printf("Select number to load, or 'dN' to delete (e.g., d2): ");
-			char line[32]; if (!fgets(line, sizeof(line), stdin)) continue; int idx = atoi(line) - 1;
-			if (line[0] == 'd' || line[0] == 'D') {
-				int del = atoi(line + 1) - 1;
-				if (del >= 0 && del < n) {
-					if (deleteSaveFile(names[del])) printMessage("Save deleted."); else printMessage("Delete failed.");
-				} else printMessage("Invalid selection.");
-				continue;
-			}
-			if (idx < 0 || idx >= n) { printMessage("Invalid selection."); continue; }
-            char path[320]; snprintf(path, sizeof(path), "saves/%s", names[idx]);
-			GameState loaded;
-			if (loadGameState(&loaded, path)) {
-				memset(&puzzle, 0, sizeof(puzzle));
-				copyString(puzzle.name, loaded.activePuzzleName, sizeof(puzzle.name));
-				copyString(puzzle.difficulty, loaded.activeDifficulty, sizeof(puzzle.difficulty));
-				for (int r = 0; r < GRID_SIZE; r++) for (int c = 0; c < GRID_SIZE; c++) puzzle.grid[r][c] = loaded.currentGrid[r][c];
-				memcpy(&state, &loaded, sizeof(GameState));
-				break;
-			} else { printMessage("Failed to load save file."); }
-		} else if (menu == 4) {
-			printTopHighScores("highscores.txt", 10);
-		}
-	}
-
-INIT_STATE:
-	if (state.activePuzzleName[0] == '\0') {
-		memset(&state, 0, sizeof(state));
-		copyString(state.activeDifficulty, puzzle.difficulty, sizeof(state.activeDifficulty));
-		copyString(state.activePuzzleName, puzzle.name, sizeof(state.activePuzzleName));
-		for (int r = 0; r < GRID_SIZE; r++) {
-			for (int c = 0; c < GRID_SIZE; c++) {
-				state.currentGrid[r][c] = puzzle.grid[r][c];
-				state.isFixed[r][c] = (puzzle.grid[r][c] != 0);
-			}
-		}
-	}
-
-	printf("\nSudokuMate - Interactive\n\n");
-	state.timerStart = time(NULL);
-
-	while (1) {
-		printBoard((const int (*)[GRID_SIZE])state.currentGrid);
-		unsigned int elapsed = state.elapsedSeconds;
-		if (state.timerStart != 0) {
-			unsigned int now = (unsigned int)time(NULL);
-			if (now >= (unsigned int)state.timerStart) elapsed += (now - (unsigned int)state.timerStart);
-		}
-		printf("Time %02u:%02u | Puzzle: %s | Difficulty: %s\n",
-			(elapsed / 60) % 60, elapsed % 60, state.activePuzzleName, state.activeDifficulty);
-		int row, col, value;
-		int rc = promptMove(&row, &col, &value);
-		if (rc == 0) {
-			printMessage("Returning to main menu...");
-			memset(&state, 0, sizeof(state));
-			memset(&puzzle, 0, sizeof(puzzle));
-			goto MENU_START;
-		}
-		if (rc == 2) {
-			int working[GRID_SIZE][GRID_SIZE];
-			for (int r = 0; r < GRID_SIZE; r++) {
-				for (int c = 0; c < GRID_SIZE; c++) {
-					working[r][c] = state.currentGrid[r][c];
-				}
-			}
-			if (solveSudoku(working)) {
-				for (int r = 0; r < GRID_SIZE; r++) {
-					for (int c = 0; c < GRID_SIZE; c++) {
-						state.currentGrid[r][c] = working[r][c];
-					}
-				}
-				unsigned int now = (unsigned int)time(NULL);
-				unsigned int total = state.elapsedSeconds + (state.timerStart ? (now - (unsigned int)state.timerStart) : 0);
-				printMessage("Solved.");
-				appendHighScore(state.activeDifficulty, state.activePuzzleName, total, "highscores.txt");
-			} else {
-				printMessage("No solution found (board may be invalid).");
-			}
-			continue;
-		}
-		if (rc == 4) {
-			int poss[10];
-			int count = computePossibilities((const int (*)[GRID_SIZE])state.currentGrid, row, col, poss);
-			if (count == 0) {
-				printMessage("No possibilities (cell filled or blocked).");
-			} else {
-				printf("Possible values at (%d,%d): ", row + 1, col + 1);
-				for (int v = 1; v <= 9; v++) if (poss[v]) printf("%d ", v);
-				printf("\n");
-			}
-			continue;
-		}
-		if (rc == 3) {
-			char used[320];
-			unsigned int now = (unsigned int)time(NULL);
-			if (state.timerStart != 0 && now >= (unsigned int)state.timerStart) {
-				state.elapsedSeconds += (now - (unsigned int)state.timerStart);
-			}
-			state.timerStart = time(NULL);
-			if (saveGameStateAuto(&state, used, sizeof(used))) {
-				printf("Saved to %s\n", used);
-			} else {
-				printMessage("Save failed.");
-			}
-			continue;
-		}
-		if (rc == 5) { 
-			if (state.moveCount > 0) {
-				Move m = state.moves[state.moveCount - 1];
-				state.currentGrid[m.row][m.col] = m.previousValue;
-				state.moveCount--;
-				state.redoCount++;
-				printMessage("Undone last move.");
-			} else {
-				printMessage("Nothing to undo.");
-			}
-			continue;
-		}
-		if (rc == 6) { 
-			if (state.redoCount > 0) {
-				Move m = state.moves[state.moveCount];
-				state.currentGrid[m.row][m.col] = m.newValue;
-				state.moveCount++;
-				state.redoCount--;
-				printMessage("Redone move.");
-			} else {
-				printMessage("Nothing to redo.");
-			}
-			continue;
-		}
-		if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) {
-			printMessage("Row/col must be between 1 and 9.");
-			continue;
-		}
-		if (state.isFixed[row][col]) {
-			printMessage("Cannot change a fixed (given) cell.");
-			continue;
-		}
-		if (!isMoveValid((const int (*)[GRID_SIZE])state.currentGrid, row, col, value)) {
-			printMessage("Invalid move by Sudoku rules.");
-			continue;
-		}
-		if (state.moveCount < (sizeof(state.moves) / sizeof(state.moves[0]))) {
-			state.moves[state.moveCount].row = row;
-			state.moves[state.moveCount].col = col;
-			state.moves[state.moveCount].previousValue = state.currentGrid[row][col];
-			state.moves[state.moveCount].newValue = value;
-			state.moveCount++;
-			state.redoCount = 0; 
-		}
-		state.currentGrid[row][col] = value;
-		int empty = 0;
-		for (int rr = 0; rr < GRID_SIZE; rr++) {
-			for (int cc = 0; cc < GRID_SIZE; cc++) {
-				if (state.currentGrid[rr][cc] == 0) empty++;
-			}
-		}
-		if (state.nextHintIndex < puzzle.numHints) {
-			Hint *h = &puzzle.hints[state.nextHintIndex];
-			bool targetEmptyOk = true;
-			if (h->hintRow >= 0 && h->hintCol >= 0) {
-				targetEmptyOk = (state.currentGrid[h->hintRow][h->hintCol] == 0);
-			}
-			if (empty == h->triggerCellCount && targetEmptyOk) {
-				printf("%s\n", h->message);
-				if (h->hintRow >= 0 && h->hintCol >= 0 && h->hintValue >= 1) {
-					printf("Try (%d,%d) = %d\n", h->hintRow + 1, h->hintCol + 1, h->hintValue);
-				}
-				state.nextHintIndex++;
-			}
-		}
-		if (isBoardComplete((const int (*)[GRID_SIZE])state.currentGrid)) {
-			if (isBoardValid((const int (*)[GRID_SIZE])state.currentGrid)) {
-				unsigned int now = (unsigned int)time(NULL);
-            	unsigned int total = state.elapsedSeconds + (state.timerStart ? (now - (unsigned int)state.timerStart) : 0);
-				
-            	unsigned int hours = total / 3600;
-            	unsigned int minutes = (total % 3600) / 60;
-            	unsigned int seconds = total % 60;
-            	printf("\nCompleted! Time: %02u:%02u:%02u (HH:MM:SS)\n", hours, minutes, seconds);
-				
-            	appendHighScore(state.activeDifficulty, state.activePuzzleName, total, "highscores.txt");
-				memset(&state, 0, sizeof(state));
-				memset(&puzzle, 0, sizeof(puzzle));
-				printMessage("Returning to main menu...");
-				goto MENU_START;
-			} else {
-				printMessage("Board is full but invalid. Keep trying or undo.");
-			}
-		}
-	}
-
-	return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "structs.h"
+#include "board.h"
+#include "cli.h"
+#include "game_logic.h"
+#include "solver.h"
+#include "file_io.h"
+#include "game_session.h"
+#include "batch.h"
+#include "generator.h"
+#include "grader.h"
+#include "leaderboard.h"
+#include "puzzle_library.h"
+#include "puzzle_pack.h"
+#include "server.h"
+#include "solution_cache.h"
+#include "sys_thread.h"
+
+#define PUZZLE_LIBRARY_PATH "puzzles.txt"
+#define HIGH_SCORES_PATH "highscores.dat"
+#define LEGACY_HIGH_SCORES_PATH "highscores.txt"
+
+static void copyString(char *dst, const char *src, size_t dstSize) {
+	if (!dst || !src || dstSize == 0) return;
+	size_t i = 0;
+	while (i + 1 < dstSize && src[i] != '\0') {
+		dst[i] = src[i];
+		i++;
+	}
+	dst[i] = '\0';
+}
+
+static void loadEasyGuaranteedNakedSingle(Puzzle *puzzle) {
+	// Beginner-friendly easy puzzle with at least one Naked Single
+	memset(puzzle, 0, sizeof(*puzzle));
+	copyString(puzzle->name, "Easy", sizeof(puzzle->name));
+	copyString(puzzle->difficulty, "Easy", sizeof(puzzle->difficulty));
+	int g[GRID_SIZE][GRID_SIZE] = {
+		{0,0,0, 2,6,0, 7,0,0},
+		{6,8,0, 0,7,0, 0,9,0},
+		{1,9,0, 0,0,4, 5,0,0},
+		{8,2,0, 1,0,0, 0,4,0},
+		{0,0,4, 6,0,2, 9,0,0},
+		{0,5,0, 0,0,3, 0,2,8},
+		{0,0,9, 3,0,0, 0,7,4},
+		{0,4,0, 0,5,0, 0,3,6},
+		{0,0,3, 0,1,8, 0,0,0}
+	};
+	boardFromGrid(&puzzle->grid, (const int (*)[GRID_SIZE])g);
+	// Smart hint that triggers when 38 empties AND R4,C5 is still empty, suggesting 9
+	puzzle->hints[0].triggerCellCount = 38;
+    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
+        "\n\nHINT: Naked Single! Look closely at R4C5."
+        " Check its row, column, and 3x3 box; only '9' fits.\n\n");
+	puzzle->hints[0].hintRow = 3; puzzle->hints[0].hintCol = 4; puzzle->hints[0].hintValue = 9;
+	puzzle->numHints = 1;
+}
+
+static void loadMediumHiddenPair(Puzzle *puzzle) {
+	// Medium puzzle showcasing a Hidden Pair opportunity
+	memset(puzzle, 0, sizeof(*puzzle));
+	copyString(puzzle->name, "Medium", sizeof(puzzle->name));
+	copyString(puzzle->difficulty, "Medium", sizeof(puzzle->difficulty));
+	int g[GRID_SIZE][GRID_SIZE] = {
+		{0,0,2, 0,0,0, 0,9,0},
+		{0,1,0, 5,0,7, 0,3,0},
+		{7,0,0, 0,8,0, 0,0,1},
+		{0,0,0, 0,0,0, 8,0,0},
+		{5,0,1, 0,6,0, 4,0,2},
+		{0,0,6, 0,0,0, 0,0,0},
+		{4,0,0, 0,1,0, 0,0,6},
+		{0,2,0, 6,0,5, 0,4,0},
+		{0,3,0, 0,0,0, 1,0,0}
+	};
+	boardFromGrid(&puzzle->grid, (const int (*)[GRID_SIZE])g);
+	// Smart hint that triggers when 50 empties AND both target cells still empty
+	puzzle->hints[0].triggerCellCount = 50;
+    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
+		"\n\nHINT: Hidden Pair! Look at the top-left 3x3 box. Where can the number '3' go?"
+		"\nYou'll see it can ONLY go in two cells: Row 1, Col 1 and Row 3, Col 3."
+        "\nThat's a Hidden Pair! You can safely remove any other candidates from those two spots.\n\n");
+	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
+	puzzle->numHints = 1;
+}
+
+static void loadHardXWing(Puzzle *puzzle) {
+	memset(puzzle, 0, sizeof(*puzzle));
+	copyString(puzzle->name, "Hard", sizeof(puzzle->name));
+	copyString(puzzle->difficulty, "Hard", sizeof(puzzle->difficulty));
+	int g[GRID_SIZE][GRID_SIZE] = {
+		{0,0,0, 0,0,5, 0,1,8},
+		{0,0,0, 0,0,0, 9,0,0},
+		{1,0,8, 0,9,0, 0,6,0},
+		{0,6,0, 1,0,0, 0,2,0},
+		{0,0,2, 0,0,0, 1,0,0},
+		{0,4,0, 0,0,3, 0,7,0},
+		{0,2,0, 0,1,0, 7,0,4},
+		{0,0,6, 0,0,0, 0,0,0},
+		{4,1,0, 9,0,0, 0,0,0}
+	};
+	boardFromGrid(&puzzle->grid, (const int (*)[GRID_SIZE])g);
+	puzzle->hints[0].triggerCellCount = 35;
+    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
+        "\n\nHINT: X-Wing! In Row 2, '4' is limited to Col 4 and Col 8."
+        "\nIn Row 8, it's the same two columns. This forms an X-Wing!"
+        "\nEliminate all other '4' candidates from those two columns.\n\n");
+	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
+	puzzle->numHints = 1;
+}
+
+static void loadExpertSwordfish(Puzzle *puzzle) {
+	memset(puzzle, 0, sizeof(*puzzle));
+	copyString(puzzle->name, "Expert", sizeof(puzzle->name));
+	copyString(puzzle->difficulty, "Expert", sizeof(puzzle->difficulty));
+	int g[GRID_SIZE][GRID_SIZE] = {
+		{0,0,0, 3,0,8, 0,0,2},
+		{0,0,0, 0,4,0, 7,0,0},
+		{0,0,1, 9,7,0, 0,8,0},
+		{9,0,5, 0,0,3, 0,0,6},
+		{0,3,7, 0,0,0, 5,2,0},
+		{8,0,0, 5,0,0, 9,0,3},
+		{0,7,0, 0,9,6, 1,0,0},
+		{0,0,6, 0,3,0, 0,0,0},
+		{4,0,0, 8,0,7, 0,0,0}
+	};
+	boardFromGrid(&puzzle->grid, (const int (*)[GRID_SIZE])g);
+	puzzle->hints[0].triggerCellCount = 45;
+    snprintf(puzzle->hints[0].message, sizeof(puzzle->hints[0].message),
+			"\n\nHINT: Swordfish!\n"
+            "In rows 3, 7, and 8, the candidate '9'\n"
+            "appears only in columns 1, 5, and 8.\n"
+            "This forms a Swordfish; remove other '9's from those columns.\n\n");
+	puzzle->hints[0].hintRow = -1; puzzle->hints[0].hintCol = -1; puzzle->hints[0].hintValue = 0;
+	puzzle->numHints = 1;
+}
+
+static void printUsage(const char *program) {
+	fprintf(stderr, "Usage: %s [--solve-batch <file|->] [--strategy backtrack|mrv|dlx|stepped] [--threads N]\n", program);
+	fprintf(stderr, "       %s [--count-batch <file|->] [--limit N] [--threads N]\n", program);
+	fprintf(stderr, "       %s [--grade-batch <file|->] [--threads N]\n", program);
+	fprintf(stderr, "       %s [--dedupe-batch <file|->] [--dedupe-memory MB] [--threads N]\n", program);
+	fprintf(stderr, "       --solve-batch also takes [--cache-entries N] (0 turns the solution cache off) [--cache-canonical]\n");
+	fprintf(stderr, "       %s [--generate N] [--difficulty Easy|Medium|Hard|Expert] [--seed N]\n", program);
+	fprintf(stderr, "       %s [--index <file>]\n", program);
+	fprintf(stderr, "       %s [--import-scores <highscores.txt>]\n", program);
+	fprintf(stderr, "       %s [--serve <port|socket path>]\n", program);
+	fprintf(stderr, "       %s pack <puzzles.txt|-> <puzzles.pack>\n", program);
+	fprintf(stderr, "Run without arguments for the interactive game.\n");
+}
+
+static int runIndexCommand(const char *path) {
+	PuzzleLibrary library;
+	double start = monotonicSeconds();
+	if (!openPuzzleLibrary(&library, path)) {
+		fprintf(stderr, "Could not index %s\n", path);
+		return 1;
+	}
+	fprintf(stderr, "%s index for %s: %llu puzzles in %.2fs\n", library.rebuilt ? "Built" : "Loaded",
+		path, library.entryCount, monotonicSeconds() - start);
+	for (int level = 0; level < LIBRARY_GROUPS; level++) {
+		fprintf(stderr, "  %-8s %llu\n", level < DIFFICULTY_LEVELS ? difficultyNames[level] : "Other",
+			libraryCount(&library, level));
+	}
+	closePuzzleLibrary(&library);
+	return 0;
+}
+
+static int runImportScoresCommand(const char *path) {
+	Leaderboard scores;
+	if (!openLeaderboard(&scores, HIGH_SCORES_PATH, NULL)) {
+		fprintf(stderr, "Could not open %s\n", HIGH_SCORES_PATH);
+		return 1;
+	}
+	unsigned long long imported;
+	bool ok = importHighScoreText(&scores, path, &imported);
+	closeLeaderboard(&scores);
+	fprintf(stderr, "Imported %llu scores from %s into %s\n", imported, path, HIGH_SCORES_PATH);
+	return ok ? 0 : 1;
+}
+
+static int runServeCommand(const char *address) {
+	PuzzleLibrary library;
+	bool libraryReady = openPuzzleLibrary(&library, PUZZLE_LIBRARY_PATH);
+	Leaderboard scores;
+	bool scoresReady = openLeaderboard(&scores, HIGH_SCORES_PATH, LEGACY_HIGH_SCORES_PATH);
+	if (!scoresReady) fprintf(stderr, "High scores are unavailable.\n");
+	bool cacheReady = initSolutionCache(SOLUTION_CACHE_DEFAULT_ENTRIES, false);
+	if (cacheReady) loadSolutionCache(SOLUTION_CACHE_PATH);
+	int rc = runServer(address, libraryReady ? &library : NULL, scoresReady ? &scores : NULL);
+	if (cacheReady) {
+		SolutionCacheStats cached = solutionCacheStats();
+		fprintf(stderr, "Solution cache: %llu hits, %llu misses\n", cached.hits, cached.misses);
+		saveSolutionCache(SOLUTION_CACHE_PATH);
+		freeSolutionCache();
+	}
+	if (libraryReady) closePuzzleLibrary(&library);
+	if (scoresReady) closeLeaderboard(&scores);
+	return rc;
+}
+
+// Run on the solving thread while the prompt waits for a line. A cancelled job ends
+// while the loop waits for it instead, so there is nothing to announce.
+static void announceSolveFinished(void *arg) {
+	GameSession *session = (GameSession*)arg;
+	if (pollSolveJob(&session->solveJob, NULL, NULL) == SOLVE_CANCELLED) return;
+	printf("\nThe %s has finished; press Enter for the result.\n> ", session->checking ? "puzzle check" : "solve");
+	fflush(stdout);
+}
+
+static void announceCheckFinished(void *arg) {
+	if (pollSolveJob((SolveJob*)arg, NULL, NULL) == SOLVE_CANCELLED) return;
+	printf("\nThe puzzle check has finished; press Enter to go on.\n> ");
+	fflush(stdout);
+}
+
+// Counts the custom puzzle's solutions, up to two, on a worker thread and within
+// SESSION_CHECK_NODES, so a grid that takes the search a long time can be cancelled.
+// Fills in the solution and count, and returns false when the puzzle will not be played.
+static bool checkCustomPuzzle(Puzzle *puzzle) {
+	SolveJob job;
+	SolveBudget budget = { 0, SESSION_CHECK_NODES };
+	job.checkUnique = true;
+	SolveOutcome outcome;
+	if (startSolveJob(&job, &puzzle->grid, budget, announceCheckFinished, &job)) {
+		unsigned long long nodes;
+		double seconds;
+		while (pollSolveJob(&job, &nodes, &seconds) == SOLVE_RUNNING) {
+			int row, col, value;
+			SessionCommand command = (SessionCommand)promptWhileChecking(&row, &col, &value);
+			if (command == COMMAND_CANCEL || command == COMMAND_QUIT) {
+				cancelSolveJob(&job);
+				break;
+			}
+			if (pollSolveJob(&job, &nodes, &seconds) == SOLVE_RUNNING) {
+				printf("Still checking: %llu nodes in %.1fs.\n", nodes, seconds);
+			}
+		}
+		outcome = finishSolveJob(&job);
+	} else {
+		outcome = runSolveJob(&job, &puzzle->grid, budget);
+	}
+	if (outcome == SOLVE_NO_SOLUTION) {
+		printMessage("This puzzle has no solution. Please check the digits and try again.");
+		return false;
+	}
+	if (outcome == SOLVE_CANCELLED) {
+		printMessage("Check cancelled.");
+		return false;
+	}
+	if (outcome == SOLVE_TIMED_OUT) {
+		printf("\nCould not verify this puzzle in %llu nodes; it may still be solvable.\n", job.nodes);
+		return false;
+	}
+	solveJobBoard(&job, &puzzle->solution);
+	puzzle->solutionCount = job.solutions == 1 ? SOLUTIONS_UNIQUE : SOLUTIONS_SEVERAL;
+	if (job.solutions > 1) {
+		printMessage("Note: this puzzle has more than one solution.");
+		return true;
+	}
+	cacheSolution(&puzzle->grid, getSolverStrategy(), &puzzle->solution);
+	GradeResult grade;
+	if (gradeLogically(&puzzle->grid, &grade)) applyGradeToPuzzle(puzzle, &grade);
+	return true;
+}
+
+static void showHighScores(Leaderboard *scores) {
+	printTopHighScores(scores, LEADERBOARD_ALL, 10);
+	for (int group = 0; group < LEADERBOARD_ALL; group++) {
+		if (scores->tables[group].count == 0) continue;
+		printf("\n");
+		printTopHighScores(scores, group, 3);
+	}
+}
+
+static int runCommandLine(int argc, char **argv) {
+	BatchOptions batch;
+	memset(&batch, 0, sizeof(batch));
+	batch.strategy = getSolverStrategy();
+	unsigned long long generateCount = 0;
+	int level = -1;
+	uint64_t seed = (uint64_t)time(NULL);
+	size_t cacheEntries = SOLUTION_CACHE_DEFAULT_ENTRIES;
+	bool cacheCanonical = false;
+	if (strcmp(argv[1], "pack") == 0) {
+		if (argc != 4) {
+			printUsage(argv[0]);
+			return 2;
+		}
+		return packPuzzleFile(argv[2], argv[3]);
+	}
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+			generateCount = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) {
+			level = findDifficultyLevel(argv[++i]);
+			if (level < 0) {
+				fprintf(stderr, "Unknown difficulty: %s\n", argv[i]);
+				return 2;
+			}
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--solve-batch") == 0 && i + 1 < argc) {
+			batch.inputPath = argv[++i];
+		} else if (strcmp(argv[i], "--count-batch") == 0 && i + 1 < argc) {
+			batch.inputPath = argv[++i];
+			if (batch.countLimit <= 0) batch.countLimit = 2;
+		} else if (strcmp(argv[i], "--grade-batch") == 0 && i + 1 < argc) {
+			batch.inputPath = argv[++i];
+			batch.grade = true;
+		} else if (strcmp(argv[i], "--dedupe-batch") == 0 && i + 1 < argc) {
+			batch.inputPath = argv[++i];
+			batch.dedupe = true;
+		} else if (strcmp(argv[i], "--dedupe-memory") == 0 && i + 1 < argc) {
+			batch.dedupeMemory = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+		} else if (strcmp(argv[i], "--cache-entries") == 0 && i + 1 < argc) {
+			cacheEntries = (size_t)strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--cache-canonical") == 0) {
+			cacheCanonical = true;
+		} else if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+			return runIndexCommand(argv[++i]);
+		} else if (strcmp(argv[i], "--import-scores") == 0 && i + 1 < argc) {
+			return runImportScoresCommand(argv[++i]);
+		} else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+			return runServeCommand(argv[++i]);
+		} else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+			batch.countLimit = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			batch.threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--strategy") == 0 && i + 1 < argc) {
+			if (!parseSolverStrategy(argv[++i], &batch.strategy)) {
+				fprintf(stderr, "Unknown strategy: %s\n", argv[i]);
+				return 2;
+			}
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+	if (generateCount > 0) {
+		PuzzleGenerator gen;
+		seedGenerator(&gen, seed);
+		fprintf(stderr, "Generating %llu puzzles with seed %llu\n", generateCount, (unsigned long long)seed);
+		static char outputBuffer[1 << 16];
+		setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+		int rc = writeGeneratedPuzzles(&gen, generateCount, level, stdout);
+		fflush(stdout);
+		return rc;
+	}
+	if (!batch.inputPath) {
+		printUsage(argv[0]);
+		return 2;
+	}
+	if (cacheEntries > 0 && !batch.dedupe && !batch.grade && batch.countLimit <= 0) {
+		initSolutionCache(cacheEntries, cacheCanonical);
+	}
+	int rc = runSolveBatch(&batch);
+	freeSolutionCache();
+	return rc;
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1) return runCommandLine(argc, argv);
+	PuzzleLibrary library;
+	bool libraryReady = openPuzzleLibrary(&library, PUZZLE_LIBRARY_PATH);
+	Leaderboard scores;
+	bool scoresReady = openLeaderboard(&scores, HIGH_SCORES_PATH, LEGACY_HIGH_SCORES_PATH);
+	if (initSolutionCache(SOLUTION_CACHE_DEFAULT_ENTRIES, false)) loadSolutionCache(SOLUTION_CACHE_PATH);
+	PuzzleGenerator picker;
+	seedGenerator(&picker, (uint64_t)time(NULL));
+	GameSession session;
+	SessionReply reply;
+	MENU_START:
+	Puzzle puzzle;
+	GameState state; 
+	memset(&state, 0, sizeof(state));
+	while (1) {
+		int menu = showStartMenu();
+		if (menu == 0) {
+			printMessage("Goodbye!");
+			if (libraryReady) closePuzzleLibrary(&library);
+			if (scoresReady) closeLeaderboard(&scores);
+			saveSolutionCache(SOLUTION_CACHE_PATH);
+			freeSolutionCache();
+			return 0;
+		} else if (menu == 1) {
+			while (1) {
+				int d = showDifficultyMenu();
+				if (d == 0) break;
+				if (libraryReady && d >= 1 && d <= DIFFICULTY_LEVELS && pickLibraryPuzzle(&library, d - 1, nextRandom(&picker), &puzzle)) {
+					goto INIT_STATE;
+				}
+				if (d == 1) { 
+					loadEasyGuaranteedNakedSingle(&puzzle);
+					goto INIT_STATE;
+				} else if (d == 2) { 
+					loadMediumHiddenPair(&puzzle);
+					goto INIT_STATE;
+				} else if (d == 3) { 
+					loadHardXWing(&puzzle);
+					goto INIT_STATE;
+				} else if (d == 4) { 
+					loadExpertSwordfish(&puzzle);
+					goto INIT_STATE;
+				} else if (d == 5) {
+					PuzzleGenerator gen;
+					seedGenerator(&gen, (uint64_t)time(NULL));
+					if (generatePuzzle(&gen, (int)(nextRandom(&gen) % DIFFICULTY_LEVELS), &puzzle)) {
+						copyString(puzzle.name, "Generated", sizeof(puzzle.name));
+						goto INIT_STATE;
+					}
+					printMessage("Could not generate a puzzle. Please try again.");
+				} else {
+					printMessage("This difficulty will be added next.");
+				}
+			}
+		} else if (menu == 2) {
+			memset(&puzzle, 0, sizeof(puzzle));
+		copyString(puzzle.name, "Custom", sizeof(puzzle.name));
+		copyString(puzzle.difficulty, "Custom", sizeof(puzzle.difficulty));
+			if (!promptCustomPuzzle(&puzzle.grid)) {
+				printMessage("Cancelled.");
+				continue;
+			}
+			if (!checkCustomPuzzle(&puzzle)) continue;
+			break;
+		} else if (menu == 3) {
+			char names[64][260];
+			int n = listSaveFiles(names, 64);
+			if (n <= 0) { printMessage("No saves found in saves/."); continue; }
+			printf("Saved games:\n");
+			for (int i = 0; i < n; i++) printf("%d) %s\n", i + 1, names[i]);
+			printf("Select number to load, or 'dN' to delete (e.g., d2): ");
+			char line[32]; if (!fgets(line, sizeof(line), stdin)) continue; int idx = atoi(line) - 1;
+			if (line[0] == 'd' || line[0] == 'D') {
+				int del = atoi(line + 1) - 1;
+				if (del >= 0 && del < n) {
+					if (deleteSaveFile(names[del])) printMessage("Save deleted."); else printMessage("Delete failed.");
+				} else printMessage("Invalid selection.");
+				continue;
+			}
+			if (idx < 0 || idx >= n) { printMessage("Invalid selection."); continue; }
+            char path[320]; snprintf(path, sizeof(path), "saves/%s", names[idx]);
+			GameState loaded;
+			if (loadAutosave(&loaded, path)) {
+				memset(&puzzle, 0, sizeof(puzzle));
+				copyString(puzzle.name, loaded.activePuzzleName, sizeof(puzzle.name));
+				copyString(puzzle.difficulty, loaded.activeDifficulty, sizeof(puzzle.difficulty));
+				puzzle.grid = loaded.currentGrid;
+				freeMoveHistory(&state.history);
+				memcpy(&state, &loaded, sizeof(GameState));
+				break;
+			} else { printMessage("Failed to load save file."); }
+		} else if (menu == 4) {
+			if (scoresReady) showHighScores(&scores);
+			else printMessage("High scores are unavailable.");
+		}
+	}
+
+INIT_STATE:
+	startGameSession(&session, &puzzle, state.activePuzzleName[0] ? &state : NULL, scoresReady ? &scores : NULL, true, NULL);
+	session.solveInBackground = true;
+	session.onSolveFinished = announceSolveFinished;
+	session.onSolveFinishedArg = &session;
+	printf("\nSudokuMate - Interactive\n\n");
+	if (!session.autosaveActive) printMessage("Autosave is unavailable for this game.");
+	checkSessionPuzzle(&session, &reply);
+	if (reply.length > 0) printMessage(reply.text);
+
+	while (!session.over) {
+		int row = 0, col = 0, value = 0;
+		SessionCommand command;
+		if (session.solving && !session.checking) {
+			command = (SessionCommand)promptWhileSolving(&row, &col, &value);
+		} else {
+			printBoard(&session.state.currentGrid);
+			unsigned int elapsed = elapsedPlaySeconds(&session.state);
+			printf("Time %02u:%02u | Puzzle: %s | Difficulty: %s\n",
+				(elapsed / 60) % 60, elapsed % 60, session.state.activePuzzleName, session.state.activeDifficulty);
+			command = (SessionCommand)promptMove(&row, &col, &value);
+		}
+		runSessionCommand(&session, command, row, col, value, &reply);
+		if (reply.length > 0) printMessage(reply.text);
+	}
+	endGameSession(&session);
+	memset(&state, 0, sizeof(state));
+	memset(&puzzle, 0, sizeof(puzzle));
+	printMessage("Returning to main menu...");
+	goto MENU_START;
+}
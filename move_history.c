@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <string.h>
+#include "move_history.h"
+
+static inline HistoryNode *nodeAt(const MoveHistory *history, uint32_t index) {
+	return &history->chunks[index / HISTORY_CHUNK_NODES][index % HISTORY_CHUNK_NODES];
+}
+
+static void toMove(const HistoryNode *node, Move *out) {
+	if (!out) return;
+	out->row = node->row;
+	out->col = node->col;
+	out->previousValue = node->previousValue;
+	out->newValue = node->newValue;
+}
+
+void freeMoveHistory(MoveHistory *history) {
+	for (uint32_t i = 0; i < history->chunkCount; i++) free(history->chunks[i]);
+	free(history->chunks);
+	memset(history, 0, sizeof(*history));
+}
+
+static uint32_t allocateNode(MoveHistory *history) {
+	if (history->nodeCount == HISTORY_NONE) return HISTORY_NONE;
+	if (history->nodeCount == history->chunkCount * HISTORY_CHUNK_NODES) {
+		if (history->chunkCount == history->chunkCapacity) {
+			uint32_t capacity = history->chunkCapacity ? history->chunkCapacity * 2 : 8;
+			HistoryNode **chunks = (HistoryNode**)realloc(history->chunks, capacity * sizeof(*chunks));
+			if (!chunks) return HISTORY_NONE;
+			history->chunks = chunks;
+			history->chunkCapacity = capacity;
+		}
+		HistoryNode *chunk = (HistoryNode*)malloc(HISTORY_CHUNK_NODES * sizeof(HistoryNode));
+		if (!chunk) return HISTORY_NONE;
+		history->chunks[history->chunkCount++] = chunk;
+	}
+	uint32_t index = history->nodeCount++;
+	HistoryNode *node = nodeAt(history, index);
+	memset(node, 0, sizeof(*node));
+	node->parent = HISTORY_NONE;
+	node->firstChild = HISTORY_NONE;
+	node->nextSibling = HISTORY_NONE;
+	node->redoChild = HISTORY_NONE;
+	return index;
+}
+
+// Appends a child of parent and makes it parent's redo branch.
+static uint32_t appendChild(MoveHistory *history, uint32_t parent, const Move *move) {
+	if (history->nodeCount == 0 && allocateNode(history) == HISTORY_NONE) return HISTORY_NONE;
+	uint32_t index = allocateNode(history);
+	if (index == HISTORY_NONE) return HISTORY_NONE;
+	HistoryNode *node = nodeAt(history, index);
+	HistoryNode *up = nodeAt(history, parent);
+	node->row = (uint8_t)move->row;
+	node->col = (uint8_t)move->col;
+	node->previousValue = (uint8_t)move->previousValue;
+	node->newValue = (uint8_t)move->newValue;
+	node->parent = parent;
+	node->nextSibling = up->firstChild;
+	up->firstChild = index;
+	up->redoChild = index;
+	return index;
+}
+
+bool historyPush(MoveHistory *history, const Move *move) {
+	uint32_t index = appendChild(history, history->current, move);
+	if (index == HISTORY_NONE) return false;
+	history->current = index;
+	history->depth++;
+	return true;
+}
+
+bool historyPeekUndo(const MoveHistory *history, Move *out) {
+	if (history->depth == 0) return false;
+	toMove(nodeAt(history, history->current), out);
+	return true;
+}
+
+bool historyPeekRedo(const MoveHistory *history, Move *out) {
+	if (history->nodeCount == 0) return false;
+	uint32_t next = nodeAt(history, history->current)->redoChild;
+	if (next == HISTORY_NONE) return false;
+	toMove(nodeAt(history, next), out);
+	return true;
+}
+
+bool historyUndo(MoveHistory *history, Move *out) {
+	if (!historyPeekUndo(history, out)) return false;
+	history->current = nodeAt(history, history->current)->parent;
+	history->depth--;
+	return true;
+}
+
+bool historyRedo(MoveHistory *history, Move *out) {
+	if (!historyPeekRedo(history, out)) return false;
+	history->current = nodeAt(history, history->current)->redoChild;
+	history->depth++;
+	return true;
+}
+
+int historyRedoBranches(const MoveHistory *history) {
+	if (history->nodeCount == 0) return 0;
+	int count = 0;
+	for (uint32_t child = nodeAt(history, history->current)->firstChild; child != HISTORY_NONE; child = nodeAt(history, child)->nextSibling) {
+		count++;
+	}
+	return count;
+}
+
+bool historyNextBranch(MoveHistory *history, Move *out) {
+	if (historyRedoBranches(history) < 2) return false;
+	HistoryNode *here = nodeAt(history, history->current);
+	uint32_t next = nodeAt(history, here->redoChild)->nextSibling;
+	here->redoChild = next != HISTORY_NONE ? next : here->firstChild;
+	toMove(nodeAt(history, here->redoChild), out);
+	return true;
+}
+
+static size_t varintSize(uint32_t v) {
+	size_t n = 1;
+	while (v >= 0x80) {
+		v >>= 7;
+		n++;
+	}
+	return n;
+}
+
+static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+	while (v >= 0x80) {
+		*p++ = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+static bool getVarint(const uint8_t **p, const uint8_t *end, uint32_t *out) {
+	uint32_t v = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (*p >= end) return false;
+		uint8_t b = *(*p)++;
+		v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80)) {
+			*out = v;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Moves after the starting node, i.e. nodeCount - 1 once anything was played.
+static uint32_t playedNodes(const MoveHistory *history) {
+	return history->nodeCount ? history->nodeCount - 1 : 0;
+}
+
+static uint32_t parentLink(const MoveHistory *history, uint32_t index) {
+	const HistoryNode *node = nodeAt(history, index);
+	bool redo = nodeAt(history, node->parent)->redoChild == index;
+	return ((index - node->parent) << 1) | (redo ? 1u : 0u);
+}
+
+size_t historySerializedSize(const MoveHistory *history) {
+	size_t size = varintSize(playedNodes(history)) + varintSize(history->current);
+	for (uint32_t i = 1; i < history->nodeCount; i++) size += 2 + varintSize(parentLink(history, i));
+	return size;
+}
+
+uint8_t *serializeHistory(const MoveHistory *history, uint8_t *out) {
+	out = putVarint(out, playedNodes(history));
+	out = putVarint(out, history->current);
+	for (uint32_t i = 1; i < history->nodeCount; i++) {
+		const HistoryNode *node = nodeAt(history, i);
+		*out++ = (uint8_t)((node->row << 4) | node->col);
+		*out++ = (uint8_t)((node->previousValue << 4) | node->newValue);
+		out = putVarint(out, parentLink(history, i));
+	}
+	return out;
+}
+
+bool deserializeHistory(MoveHistory *history, const uint8_t **data, const uint8_t *end) {
+	memset(history, 0, sizeof(*history));
+	uint32_t count, current;
+	if (!getVarint(data, end, &count) || !getVarint(data, end, &current)) return false;
+	if (count >= HISTORY_NONE - 1 || current > count || (size_t)(end - *data) < 3 * (size_t)count) {
+		return false;
+	}
+	for (uint32_t i = 1; i <= count; i++) {
+		if (end - *data < 2) goto fail;
+		Move move;
+		move.row = (*data)[0] >> 4;
+		move.col = (*data)[0] & 0x0F;
+		move.previousValue = (*data)[1] >> 4;
+		move.newValue = (*data)[1] & 0x0F;
+		*data += 2;
+		uint32_t link;
+		if (!getVarint(data, end, &link)) goto fail;
+		uint32_t delta = link >> 1;
+		if (delta == 0 || delta > i) goto fail;
+		if (move.row > 8 || move.col > 8 || move.previousValue > 9 || move.newValue > 9) goto fail;
+		uint32_t parent = i - delta;
+		uint32_t redoBefore = parent < history->nodeCount ? nodeAt(history, parent)->redoChild : HISTORY_NONE;
+		if (appendChild(history, parent, &move) != i) goto fail;
+		// appendChild made the newest child the redo branch; keep the saved choice instead.
+		if (!(link & 1u)) nodeAt(history, parent)->redoChild = redoBefore;
+	}
+	history->current = current;
+	for (uint32_t node = current; node != 0; node = nodeAt(history, node)->parent) history->depth++;
+	return true;
+fail:
+	freeMoveHistory(history);
+	return false;
+}
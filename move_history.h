@@ -0,0 +1,68 @@
+#ifndef MOVE_HISTORY_H
+#define MOVE_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Move {
+	int row;
+	int col;
+	int previousValue;
+	int newValue;
+} Move;
+
+#define HISTORY_CHUNK_NODES 256
+#define HISTORY_NONE UINT32_MAX
+
+// One played move. Node 0 is the starting position; every other node's parent is the
+// node that was current when it was played.
+typedef struct HistoryNode {
+	uint8_t row;
+	uint8_t col;
+	uint8_t previousValue;
+	uint8_t newValue;
+	uint32_t parent;
+	uint32_t firstChild;  // most recently played child first
+	uint32_t nextSibling;
+	uint32_t redoChild;   // the branch redo follows, HISTORY_NONE for none
+} HistoryNode;
+
+// Undo tree stored in fixed-size chunks that are never moved or freed while the game
+// runs, so push, undo and redo are O(1) and only every HISTORY_CHUNK_NODES-th push
+// allocates. Playing a move after undoing does not discard the undone moves: they stay
+// as a sibling branch that historyNextBranch can switch redo back to.
+// A zeroed MoveHistory is a valid empty history.
+typedef struct MoveHistory {
+	HistoryNode **chunks;
+	uint32_t chunkCount;
+	uint32_t chunkCapacity;
+	uint32_t nodeCount;   // including the starting node once anything was played
+	uint32_t current;     // node of the position on the board
+	uint32_t depth;       // moves between the start and current (undo steps available)
+} MoveHistory;
+
+void freeMoveHistory(MoveHistory *history);
+
+// Returns false only when a new chunk cannot be allocated.
+bool historyPush(MoveHistory *history, const Move *move);
+// Steps back/forward one move; out receives the move that was undone or redone.
+bool historyUndo(MoveHistory *history, Move *out);
+bool historyRedo(MoveHistory *history, Move *out);
+bool historyPeekUndo(const MoveHistory *history, Move *out);
+bool historyPeekRedo(const MoveHistory *history, Move *out);
+
+// Number of moves redo could follow from the current position (more than one at a
+// branch point), and switching redo to the next of them; out receives the new redo move.
+int historyRedoBranches(const MoveHistory *history);
+bool historyNextBranch(MoveHistory *history, Move *out);
+
+// Compact form used by saves: varint node count, varint current node, then per node in
+// play order two bytes (row << 4 | col, previous << 4 | new) and a varint holding
+// (index - parent) << 1 | (node is its parent's redo branch).
+size_t historySerializedSize(const MoveHistory *history);
+uint8_t *serializeHistory(const MoveHistory *history, uint8_t *out);
+// Rebuilds a history from serialized bytes, advancing *data. Returns false on malformed input.
+bool deserializeHistory(MoveHistory *history, const uint8_t **data, const uint8_t *end);
+
+#endif
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "puzzle_library.h"
+#include "file_io.h"
+
+// Index file, little-endian: magic | version | groups | source size | source mtime |
+// entry count | slot count | group starts, then the entry offsets and name hashes (8 bytes
+// each) and the name slots (4 bytes each). An index written in the host's byte order by
+// older builds reads back with a version other than INDEX_VERSION on big-endian hosts, and
+// is rebuilt.
+#define INDEX_VERSION 1u
+#define INDEX_HEADER_BYTES (48 + 8 * (LIBRARY_GROUPS + 1))
+#define NO_SLOT 0u
+
+static const uint8_t indexMagic[8] = { 'S', 'M', 'I', 'D', 'X', 0, 0, 0 };
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+	put32(p, (uint32_t)v);
+	put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get64(const uint8_t *p) {
+	return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+// FNV-1a; names are short so this is cheaper than anything fancier.
+static uint64_t hashName(const char *name) {
+	uint64_t h = 0xCBF29CE484222325ull;
+	for (const unsigned char *p = (const unsigned char*)name; *p; p++) {
+		h ^= *p;
+		h *= 0x100000001B3ull;
+	}
+	return h;
+}
+
+static int groupOf(const char *difficulty) {
+	int level = findDifficultyLevel(difficulty);
+	return level >= 0 ? level : DIFFICULTY_LEVELS;
+}
+
+static bool seekTo(FILE *f, unsigned long long offset) {
+#ifdef _WIN32
+	return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+	return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool sourceStamp(const char *path, uint64_t *size, int64_t *mtime) {
+	struct stat st;
+	if (stat(path, &st) != 0) return false;
+	*size = (uint64_t)st.st_size;
+	*mtime = (int64_t)st.st_mtime;
+	return true;
+}
+
+static void freeIndex(PuzzleLibrary *library) {
+	free(library->offsets);
+	free(library->nameHashes);
+	free(library->nameSlots);
+	library->offsets = NULL;
+	library->nameHashes = NULL;
+	library->nameSlots = NULL;
+}
+
+static bool allocateIndex(PuzzleLibrary *library, unsigned long long entries, unsigned long long slots) {
+	library->offsets = (unsigned long long*)malloc((entries ? entries : 1) * sizeof(*library->offsets));
+	library->nameHashes = (uint64_t*)malloc((entries ? entries : 1) * sizeof(*library->nameHashes));
+	library->nameSlots = (uint32_t*)calloc(slots, sizeof(*library->nameSlots));
+	if (!library->offsets || !library->nameHashes || !library->nameSlots) {
+		freeIndex(library);
+		return false;
+	}
+	return true;
+}
+
+static void buildNameSlots(PuzzleLibrary *library) {
+	unsigned long long mask = library->slotCount - 1;
+	for (unsigned long long i = 0; i < library->entryCount; i++) {
+		unsigned long long slot = library->nameHashes[i] & mask;
+		while (library->nameSlots[slot] != NO_SLOT) slot = (slot + 1) & mask;
+		library->nameSlots[slot] = (uint32_t)(i + 1);
+	}
+}
+
+// Table size: a power of two at least twice the entry count, so probes stay short.
+static unsigned long long slotsFor(unsigned long long entries) {
+	unsigned long long slots = 16;
+	while (slots < entries * 2) slots <<= 1;
+	return slots;
+}
+
+// One pass over the source: collects (offset, group, name hash) per valid line, then
+// places entries group by group with a counting sort that keeps file order.
+static bool buildIndex(PuzzleLibrary *library, const char *path) {
+	LineReader reader;
+	if (!openLineReader(&reader, path)) return false;
+	unsigned long long capacity = 1024, count = 0;
+	unsigned long long *offsets = (unsigned long long*)malloc(capacity * sizeof(*offsets));
+	uint64_t *hashes = (uint64_t*)malloc(capacity * sizeof(*hashes));
+	uint8_t *groups = (uint8_t*)malloc(capacity);
+	bool ok = offsets && hashes && groups;
+	char *line;
+	size_t len;
+	Puzzle puzzle;
+	while (ok && (line = readNextLine(&reader, &len)) != NULL) {
+		unsigned long long offset = reader.lineOffset;
+		if (!parsePuzzleLine(line, &puzzle)) continue;
+		if (count == capacity) {
+			capacity *= 2;
+			unsigned long long *o = (unsigned long long*)realloc(offsets, capacity * sizeof(*offsets));
+			if (o) offsets = o;
+			uint64_t *h = (uint64_t*)realloc(hashes, capacity * sizeof(*hashes));
+			if (h) hashes = h;
+			uint8_t *g = (uint8_t*)realloc(groups, capacity);
+			if (g) groups = g;
+			ok = o && h && g;
+			if (!ok) break;
+		}
+		offsets[count] = offset;
+		hashes[count] = hashName(line); // parsePuzzleLine terminated the name in place
+		groups[count] = (uint8_t)groupOf(puzzle.difficulty);
+		count++;
+	}
+	closeLineReader(&reader);
+	if (ok && count >= UINT32_MAX) ok = false;
+
+	if (ok) {
+		library->entryCount = count;
+		library->slotCount = slotsFor(count);
+		ok = allocateIndex(library, count, library->slotCount);
+	}
+	if (ok) {
+		unsigned long long next[LIBRARY_GROUPS];
+		memset(library->groupStart, 0, sizeof(library->groupStart));
+		for (unsigned long long i = 0; i < count; i++) library->groupStart[groups[i] + 1]++;
+		for (int g = 0; g < LIBRARY_GROUPS; g++) {
+			library->groupStart[g + 1] += library->groupStart[g];
+			next[g] = library->groupStart[g];
+		}
+		for (unsigned long long i = 0; i < count; i++) {
+			unsigned long long at = next[groups[i]]++;
+			library->offsets[at] = offsets[i];
+			library->nameHashes[at] = hashes[i];
+		}
+		buildNameSlots(library);
+	}
+	free(offsets);
+	free(hashes);
+	free(groups);
+	return ok;
+}
+
+static bool writeIndex(const PuzzleLibrary *library, const char *indexPath, uint64_t size, int64_t mtime) {
+	size_t n = (size_t)library->entryCount, slots = (size_t)library->slotCount;
+	size_t bytes = INDEX_HEADER_BYTES + n * 16 + slots * 4;
+	uint8_t *data = (uint8_t*)malloc(bytes);
+	if (!data) return false;
+	memcpy(data, indexMagic, sizeof(indexMagic));
+	put32(data + 8, INDEX_VERSION);
+	put32(data + 12, LIBRARY_GROUPS);
+	put64(data + 16, size);
+	put64(data + 24, (uint64_t)mtime);
+	put64(data + 32, library->entryCount);
+	put64(data + 40, library->slotCount);
+	for (int g = 0; g <= LIBRARY_GROUPS; g++) put64(data + 48 + 8 * g, library->groupStart[g]);
+	uint8_t *p = data + INDEX_HEADER_BYTES;
+	for (size_t i = 0; i < n; i++, p += 8) put64(p, library->offsets[i]);
+	for (size_t i = 0; i < n; i++, p += 8) put64(p, library->nameHashes[i]);
+	for (size_t i = 0; i < slots; i++, p += 4) put32(p, library->nameSlots[i]);
+	bool ok = writeFileAtomically(indexPath, data, bytes);
+	free(data);
+	return ok;
+}
+
+// Loads a saved index if it was built from a source with this size and mtime.
+static bool readIndex(PuzzleLibrary *library, const char *indexPath, uint64_t size, int64_t mtime) {
+	size_t bytes;
+	uint8_t *data = readWholeFile(indexPath, &bytes);
+	if (!data) return false;
+	bool ok = bytes >= INDEX_HEADER_BYTES && memcmp(data, indexMagic, sizeof(indexMagic)) == 0
+		&& get32(data + 8) == INDEX_VERSION
+		&& get32(data + 12) == LIBRARY_GROUPS
+		&& get64(data + 16) == size
+		&& get64(data + 24) == (uint64_t)mtime;
+	uint64_t entries = ok ? get64(data + 32) : 0, slots = ok ? get64(data + 40) : 0;
+	ok = ok && entries < UINT32_MAX && slots == slotsFor(entries)
+		&& get64(data + 48 + 8 * LIBRARY_GROUPS) == entries
+		&& bytes == INDEX_HEADER_BYTES + entries * 16 + slots * 4;
+	if (ok) {
+		library->entryCount = entries;
+		library->slotCount = slots;
+		for (int g = 0; g <= LIBRARY_GROUPS; g++) library->groupStart[g] = get64(data + 48 + 8 * g);
+		ok = allocateIndex(library, entries, slots);
+	}
+	if (ok) {
+		const uint8_t *p = data + INDEX_HEADER_BYTES;
+		for (uint64_t i = 0; i < entries; i++, p += 8) library->offsets[i] = get64(p);
+		for (uint64_t i = 0; i < entries; i++, p += 8) library->nameHashes[i] = get64(p);
+		for (uint64_t i = 0; i < slots; i++, p += 4) library->nameSlots[i] = get32(p);
+	}
+	free(data);
+	return ok;
+}
+
+bool openPuzzleLibrary(PuzzleLibrary *library, const char *path) {
+	memset(library, 0, sizeof(*library));
+	uint64_t size;
+	int64_t mtime;
+	if (!sourceStamp(path, &size, &mtime)) return false;
+	char indexPath[512];
+	snprintf(indexPath, sizeof(indexPath), "%s.idx", path);
+	if (!readIndex(library, indexPath, size, mtime)) {
+		if (!buildIndex(library, path)) return false;
+		library->rebuilt = true;
+		writeIndex(library, indexPath, size, mtime); // a read-only directory just means rebuilding next time
+	}
+	library->file = fopen(path, "rb");
+	if (!library->file) {
+		freeIndex(library);
+		return false;
+	}
+	return true;
+}
+
+void closePuzzleLibrary(PuzzleLibrary *library) {
+	if (library->file) fclose(library->file);
+	library->file = NULL;
+	freeIndex(library);
+}
+
+unsigned long long libraryCount(const PuzzleLibrary *library, int level) {
+	if (level < 0 || level >= LIBRARY_GROUPS) return 0;
+	return library->groupStart[level + 1] - library->groupStart[level];
+}
+
+static bool loadEntry(PuzzleLibrary *library, unsigned long long entry, Puzzle *out) {
+	char line[256];
+	if (!seekTo(library->file, library->offsets[entry])) return false;
+	if (!fgets(line, sizeof(line), library->file)) return false;
+	return parsePuzzleLine(line, out);
+}
+
+bool loadLibraryPuzzle(PuzzleLibrary *library, int level, unsigned long long index, Puzzle *out) {
+	if (index >= libraryCount(library, level)) return false;
+	return loadEntry(library, library->groupStart[level] + index, out);
+}
+
+bool nextLibraryPuzzle(PuzzleLibrary *library, int level, Puzzle *out) {
+	unsigned long long count = libraryCount(library, level);
+	if (count == 0) return false;
+	unsigned long long index = library->cursor[level];
+	library->cursor[level] = (index + 1) % count;
+	return loadLibraryPuzzle(library, level, index, out);
+}
+
+bool randomLibraryPuzzle(PuzzleLibrary *library, int level, uint64_t random, Puzzle *out) {
+	unsigned long long count = libraryCount(library, level);
+	if (count == 0) return false;
+	return loadLibraryPuzzle(library, level, random % count, out);
+}
+
+bool findLibraryPuzzle(PuzzleLibrary *library, const char *name, Puzzle *out) {
+	if (library->entryCount == 0) return false;
+	uint64_t hash = hashName(name);
+	unsigned long long mask = library->slotCount - 1;
+	for (unsigned long long slot = hash & mask; library->nameSlots[slot] != NO_SLOT; slot = (slot + 1) & mask) {
+		unsigned long long entry = library->nameSlots[slot] - 1;
+		if (library->nameHashes[entry] != hash) continue;
+		if (loadEntry(library, entry, out) && strcmp(out->name, name) == 0) return true;
+	}
+	return false;
+}
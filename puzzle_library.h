@@ -0,0 +1,42 @@
+#ifndef PUZZLE_LIBRARY_H
+#define PUZZLE_LIBRARY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "structs.h"
+#include "generator.h"
+
+// One group per entry of difficultyNames, plus one for any other difficulty label.
+#define LIBRARY_GROUPS (DIFFICULTY_LEVELS + 1)
+
+// A "name|difficulty|digits" puzzle file opened through its offset index. The index is
+// kept next to the source as <path>.idx and rebuilt only when the source's size or
+// modification time no longer match the ones recorded in it.
+typedef struct PuzzleLibrary {
+	FILE *file;
+	unsigned long long entryCount;
+	unsigned long long groupStart[LIBRARY_GROUPS + 1]; // entries of group g are [groupStart[g], groupStart[g + 1])
+	unsigned long long *offsets;                        // line offsets, grouped by difficulty, in file order
+	uint64_t *nameHashes;                               // parallel to offsets
+	uint32_t *nameSlots;                                // open-addressed table of entry index + 1
+	unsigned long long slotCount;
+	unsigned long long cursor[LIBRARY_GROUPS];          // next entry for sequential selection
+	bool rebuilt;                                       // the index was (re)built by this open
+} PuzzleLibrary;
+
+bool openPuzzleLibrary(PuzzleLibrary *library, const char *path);
+void closePuzzleLibrary(PuzzleLibrary *library);
+
+unsigned long long libraryCount(const PuzzleLibrary *library, int level);
+
+// Loads entry index (0-based) of a difficulty group.
+bool loadLibraryPuzzle(PuzzleLibrary *library, int level, unsigned long long index, Puzzle *out);
+// Walks a difficulty group in file order, wrapping around at the end.
+bool nextLibraryPuzzle(PuzzleLibrary *library, int level, Puzzle *out);
+// Picks the entry random % count of a difficulty group.
+bool randomLibraryPuzzle(PuzzleLibrary *library, int level, uint64_t random, Puzzle *out);
+// Looks a puzzle up by its exact name.
+bool findLibraryPuzzle(PuzzleLibrary *library, const char *name, Puzzle *out);
+
+#endif
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "puzzle_pack.h"
+#include "board.h"
+#include "file_io.h"
+
+static const char packMagic[8] = { 'S', 'M', 'P', 'A', 'C', 'K', 0, 0 };
+
+bool isPuzzlePackFile(const char *path) {
+	if (strcmp(path, "-") == 0) return false;
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	char magic[sizeof(packMagic)];
+	bool isPack = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, packMagic, sizeof(magic)) == 0;
+	fclose(f);
+	return isPack;
+}
+
+static bool mapFile(PuzzlePack *pack, const char *path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	pack->fileHandle = file;
+	pack->mappingHandle = mapping;
+	pack->base = (const unsigned char*)view;
+	pack->size = (size_t)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps the file referenced
+	if (view == MAP_FAILED) return false;
+	pack->base = (const unsigned char*)view;
+	pack->size = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+static void unmapFile(PuzzlePack *pack) {
+	if (!pack->base) return;
+#ifdef _WIN32
+	UnmapViewOfFile((LPCVOID)pack->base);
+	CloseHandle((HANDLE)pack->mappingHandle);
+	CloseHandle((HANDLE)pack->fileHandle);
+#else
+	munmap((void*)pack->base, pack->size);
+#endif
+	pack->base = NULL;
+}
+
+// Everything a reader dereferences is checked once here, so lookups need no bounds checks.
+static bool validatePack(const PuzzlePack *pack) {
+	const PackHeader *h = pack->header;
+	if (pack->size < sizeof(PackHeader)) return false;
+	if (memcmp(h->magic, packMagic, sizeof(packMagic)) != 0) return false;
+	if (h->version != PUZZLE_PACK_VERSION || h->recordSize != sizeof(PackRecord)) return false;
+	if (h->difficultyCount > PACK_MAX_DIFFICULTIES) return false;
+	if (h->recordsOffset % 8 != 0 || h->recordsOffset > pack->size) return false;
+	if (h->recordCount > (pack->size - h->recordsOffset) / sizeof(PackRecord)) return false;
+	if (h->namesOffset < h->recordsOffset + h->recordCount * sizeof(PackRecord)) return false;
+	if (h->namesOffset > pack->size || h->namesSize > pack->size - h->namesOffset) return false;
+	if (h->namesSize == 0 || pack->names[h->namesSize - 1] != '\0') return false;
+	for (uint32_t i = 0; i < h->difficultyCount; i++) {
+		if (h->difficultyNames[i] >= h->namesSize) return false;
+	}
+	for (uint64_t i = 0; i < h->recordCount; i++) {
+		const PackRecord *r = &pack->records[i];
+		if (r->nameOffset >= h->namesSize) return false;
+		if (r->difficulty != PACK_NO_DIFFICULTY && r->difficulty >= h->difficultyCount) return false;
+	}
+	return true;
+}
+
+bool openPuzzlePack(PuzzlePack *pack, const char *path) {
+	memset(pack, 0, sizeof(*pack));
+	if (!mapFile(pack, path)) return false;
+	pack->header = (const PackHeader*)pack->base;
+	if (pack->size >= sizeof(PackHeader)) {
+		pack->records = (const PackRecord*)(pack->base + pack->header->recordsOffset);
+		pack->names = (const char*)(pack->base + pack->header->namesOffset);
+	}
+	if (pack->size < sizeof(PackHeader) || pack->header->namesOffset > pack->size || !validatePack(pack)) {
+		closePuzzlePack(pack);
+		return false;
+	}
+	return true;
+}
+
+void closePuzzlePack(PuzzlePack *pack) {
+	unmapFile(pack);
+	memset(pack, 0, sizeof(*pack));
+}
+
+const char *packRecordName(const PuzzlePack *pack, const PackRecord *record) {
+	return pack->names + record->nameOffset;
+}
+
+const char *packRecordDifficulty(const PuzzlePack *pack, const PackRecord *record) {
+	if (record->difficulty == PACK_NO_DIFFICULTY) return "";
+	return pack->names + pack->header->difficultyNames[record->difficulty];
+}
+
+static void copyField(char *dst, const char *src, size_t dstSize) {
+	size_t n = strlen(src);
+	if (n >= dstSize) n = dstSize - 1;
+	memcpy(dst, src, n);
+	dst[n] = '\0';
+}
+
+void readPackPuzzle(const PuzzlePack *pack, unsigned long long index, Puzzle *out) {
+	const PackRecord *record = &pack->records[index];
+	memset(out, 0, sizeof(*out));
+	copyField(out->name, packRecordName(pack, record), sizeof(out->name));
+	copyField(out->difficulty, packRecordDifficulty(pack, record), sizeof(out->difficulty));
+	unpackBoard(&record->grid, &out->grid);
+}
+
+bool loadPackPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty) {
+	PuzzlePack pack;
+	if (!openPuzzlePack(&pack, path)) return false;
+	bool found = false;
+	for (uint32_t d = 0; d < pack.header->difficultyCount && !found; d++) {
+		if (strcmp(pack.names + pack.header->difficultyNames[d], difficulty) != 0) continue;
+		for (uint64_t i = 0; i < pack.header->recordCount; i++) {
+			if (pack.records[i].difficulty != d) continue;
+			readPackPuzzle(&pack, i, out);
+			found = true;
+			break;
+		}
+	}
+	closePuzzlePack(&pack);
+	return found;
+}
+
+// Interns strings into the growing name area; slots hold offset + 1 (0 means empty).
+typedef struct NameTable {
+	char *bytes;
+	size_t size;
+	size_t capacity;
+	uint32_t *slots;
+	size_t slotCount;
+	size_t used;
+} NameTable;
+
+static uint64_t hashString(const char *s) {
+	uint64_t h = 0xCBF29CE484222325ull;
+	for (const unsigned char *p = (const unsigned char*)s; *p; p++) {
+		h ^= *p;
+		h *= 0x100000001B3ull;
+	}
+	return h;
+}
+
+static bool growSlots(NameTable *t) {
+	size_t count = t->slotCount ? t->slotCount * 2 : 1024;
+	uint32_t *slots = (uint32_t*)calloc(count, sizeof(*slots));
+	if (!slots) return false;
+	for (size_t i = 0; i < t->slotCount; i++) {
+		if (!t->slots[i]) continue;
+		size_t slot = hashString(t->bytes + t->slots[i] - 1) & (count - 1);
+		while (slots[slot]) slot = (slot + 1) & (count - 1);
+		slots[slot] = t->slots[i];
+	}
+	free(t->slots);
+	t->slots = slots;
+	t->slotCount = count;
+	return true;
+}
+
+// Returns the offset of s in the name area, adding it on first use; -1 when out of memory
+// or past the 4 GB the record offsets can address.
+static long long internName(NameTable *t, const char *s) {
+	if (t->used * 2 >= t->slotCount && !growSlots(t)) return -1;
+	size_t mask = t->slotCount - 1;
+	size_t slot = hashString(s) & mask;
+	for (; t->slots[slot]; slot = (slot + 1) & mask) {
+		if (strcmp(t->bytes + t->slots[slot] - 1, s) == 0) return (long long)t->slots[slot] - 1;
+	}
+	size_t len = strlen(s) + 1;
+	if (t->size + len >= UINT32_MAX) return -1;
+	if (t->size + len > t->capacity) {
+		size_t capacity = t->capacity ? t->capacity : 1 << 16;
+		while (capacity < t->size + len) capacity *= 2;
+		char *bytes = (char*)realloc(t->bytes, capacity);
+		if (!bytes) return -1;
+		t->bytes = bytes;
+		t->capacity = capacity;
+	}
+	size_t offset = t->size;
+	memcpy(t->bytes + offset, s, len);
+	t->size += len;
+	t->slots[slot] = (uint32_t)(offset + 1);
+	t->used++;
+	return (long long)offset;
+}
+
+// Records are streamed to disk as the text is read; the name area and the header
+// are written once the input is exhausted.
+int packPuzzleFile(const char *inputPath, const char *outputPath) {
+	LineReader reader;
+	if (!openLineReader(&reader, inputPath)) {
+		fprintf(stderr, "Cannot open %s\n", inputPath);
+		return 1;
+	}
+	FILE *out = fopen(outputPath, "wb");
+	if (!out) {
+		fprintf(stderr, "Cannot create %s\n", outputPath);
+		closeLineReader(&reader);
+		return 1;
+	}
+	PackHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, packMagic, sizeof(header.magic));
+	header.version = PUZZLE_PACK_VERSION;
+	header.recordSize = sizeof(PackRecord);
+	header.recordsOffset = (sizeof(PackHeader) + 7) & ~(uint64_t)7;
+	static const char zeros[8];
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+		&& fwrite(zeros, 1, (size_t)(header.recordsOffset - sizeof(header)), out) == header.recordsOffset - sizeof(header);
+
+	NameTable names;
+	memset(&names, 0, sizeof(names));
+	unsigned long long skipped = 0;
+	char *line;
+	size_t len;
+	Puzzle puzzle;
+	while (ok && (line = readNextLine(&reader, &len)) != NULL) {
+		if (len == 0 || line[0] == '#') continue;
+		if (!parsePuzzleLine(line, &puzzle)) {
+			skipped++;
+			continue;
+		}
+		PackRecord record;
+		memset(&record, 0, sizeof(record));
+		long long nameOffset = internName(&names, puzzle.name);
+		long long difficultyOffset = internName(&names, puzzle.difficulty);
+		if (nameOffset < 0 || difficultyOffset < 0) {
+			fprintf(stderr, "Out of memory for puzzle names\n");
+			ok = false;
+			break;
+		}
+		record.nameOffset = (uint32_t)nameOffset;
+		record.difficulty = PACK_NO_DIFFICULTY;
+		for (uint32_t d = 0; d < header.difficultyCount; d++) {
+			if (header.difficultyNames[d] == (uint32_t)difficultyOffset) record.difficulty = (uint8_t)d;
+		}
+		if (record.difficulty == PACK_NO_DIFFICULTY) {
+			if (header.difficultyCount == PACK_MAX_DIFFICULTIES) {
+				fprintf(stderr, "Too many difficulty labels: \"%s\" would be the %dth, a pack holds %d\n",
+					puzzle.difficulty, PACK_MAX_DIFFICULTIES + 1, PACK_MAX_DIFFICULTIES);
+				ok = false;
+				break;
+			}
+			header.difficultyNames[header.difficultyCount] = (uint32_t)difficultyOffset;
+			record.difficulty = (uint8_t)header.difficultyCount++;
+		}
+		packBoard(&puzzle.grid, &record.grid);
+		ok = fwrite(&record, sizeof(record), 1, out) == 1;
+		header.recordCount++;
+	}
+	closeLineReader(&reader);
+
+	if (ok && names.size == 0) ok = internName(&names, "") >= 0; // keep the name area non-empty
+	if (ok) {
+		header.namesOffset = header.recordsOffset + header.recordCount * sizeof(PackRecord);
+		header.namesSize = names.size;
+		ok = fwrite(names.bytes, 1, names.size, out) == names.size
+			&& fseek(out, 0, SEEK_SET) == 0
+			&& fwrite(&header, sizeof(header), 1, out) == 1;
+	}
+	if (fclose(out) != 0) ok = false;
+	free(names.bytes);
+	free(names.slots);
+	if (!ok) {
+		remove(outputPath);
+		fprintf(stderr, "Failed to write %s\n", outputPath);
+		return 1;
+	}
+	fprintf(stderr, "Packed %llu puzzles (%u difficulties, %llu name bytes) into %s",
+		(unsigned long long)header.recordCount, header.difficultyCount, (unsigned long long)header.namesSize, outputPath);
+	if (skipped) fprintf(stderr, "; skipped %llu malformed lines", skipped);
+	fprintf(stderr, "\n");
+	return 0;
+}
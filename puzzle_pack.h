@@ -0,0 +1,76 @@
+#ifndef PUZZLE_PACK_H
+#define PUZZLE_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "structs.h"
+
+// Binary puzzle pack, version 1:
+//   PackHeader | PackRecord[recordCount] | name area
+// The name area holds NUL-terminated strings; each distinct name and difficulty label
+// is stored once and referenced by its offset. Header and records are the structs below
+// in host byte order, so a pack is read straight from its mapping without decoding. A
+// pack written on a host of the other byte order fails the version check and is
+// rejected; rebuild it from the text file there. At most PACK_MAX_DIFFICULTIES distinct
+// difficulty labels fit, and packing a file with more fails.
+#define PUZZLE_PACK_VERSION 1u
+#define PACK_MAX_DIFFICULTIES 16
+#define PACK_NO_DIFFICULTY 0xFFu
+
+typedef struct PackHeader {
+	char magic[8];             // "SMPACK\0\0"
+	uint32_t version;
+	uint32_t recordSize;       // sizeof(PackRecord)
+	uint64_t recordCount;
+	uint64_t recordsOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+	uint32_t difficultyCount;
+	uint32_t difficultyNames[PACK_MAX_DIFFICULTIES]; // name-area offsets of the difficulty labels
+} PackHeader;
+
+typedef struct PackRecord {
+	uint32_t nameOffset;       // into the name area
+	uint8_t difficulty;        // index into difficultyNames, or PACK_NO_DIFFICULTY
+	PackedBoard grid;
+	uint8_t reserved[2];
+} PackRecord;
+
+_Static_assert(sizeof(PackHeader) == 120, "PackHeader is an on-disk layout");
+_Static_assert(sizeof(PackRecord) == 48, "PackRecord is an on-disk layout");
+
+// A pack mapped read-only into memory; records and names point straight into the mapping.
+typedef struct PuzzlePack {
+	const unsigned char *base;
+	size_t size;
+	const PackHeader *header;
+	const PackRecord *records;
+	const char *names;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mappingHandle;
+#endif
+} PuzzlePack;
+
+// True when the file starts with the pack magic; text files and stdin ("-") are not packs.
+bool isPuzzlePackFile(const char *path);
+
+bool openPuzzlePack(PuzzlePack *pack, const char *path);
+void closePuzzlePack(PuzzlePack *pack);
+
+static inline unsigned long long packCount(const PuzzlePack *pack) {
+	return pack->header->recordCount;
+}
+
+const char *packRecordName(const PuzzlePack *pack, const PackRecord *record);
+const char *packRecordDifficulty(const PuzzlePack *pack, const PackRecord *record);
+void readPackPuzzle(const PuzzlePack *pack, unsigned long long index, Puzzle *out);
+
+// Pack counterpart of loadPuzzleByDifficulty.
+bool loadPackPuzzleByDifficulty(Puzzle *out, const char *path, const char *difficulty);
+
+// Converts a name|difficulty|digits text file into a pack. Returns a process exit code.
+int packPuzzleFile(const char *inputPath, const char *outputPath);
+
+#endif
@@ -0,0 +1,255 @@
+#include <string.h>
+#include "save_format.h"
+#include "board.h"
+
+#define LEGACY_MOVES 128
+#define V1_HEADER_BYTES 12
+#define FIXED_FIELDS_BYTES (PACKED_BOARD_BYTES + SAVE_FIXED_MASK_BYTES + 14)
+
+static const uint8_t saveMagic[4] = { 'S', 'M', 'S', 'V' };
+
+// Raw GameState layout written by the first releases, before Board replaced int grids.
+typedef struct LegacyIntGameState {
+	int currentGrid[GRID_SIZE][GRID_SIZE];
+	bool isFixed[GRID_SIZE][GRID_SIZE];
+	char activeDifficulty[32];
+	char activePuzzleName[64];
+	Move moves[LEGACY_MOVES];
+	size_t moveCount;
+	size_t redoCount;
+	time_t timerStart;
+	unsigned int elapsedSeconds;
+	size_t nextHintIndex;
+} LegacyIntGameState;
+
+// Raw GameState layout written after the switch to Board, before this format existed.
+typedef struct LegacyBoardGameState {
+	Board currentGrid;
+	bool isFixed[GRID_SIZE][GRID_SIZE];
+	char activeDifficulty[32];
+	char activePuzzleName[64];
+	Move moves[LEGACY_MOVES];
+	size_t moveCount;
+	size_t redoCount;
+	time_t timerStart;
+	unsigned int elapsedSeconds;
+	size_t nextHintIndex;
+} LegacyBoardGameState;
+
+uint32_t crc32Bytes(const uint8_t *data, size_t size) {
+	// Nibble-at-a-time CRC-32 (IEEE); saves are a few hundred bytes at most.
+	static const uint32_t table[16] = {
+		0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+		0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+	};
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+	}
+	return ~crc;
+}
+
+static uint8_t *put16(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+	p = put16(p, v & 0xFFFFu);
+	return put16(p, v >> 16);
+}
+
+static uint8_t *putString(uint8_t *p, const char *s, size_t fieldSize) {
+	size_t len = strnlen(s, fieldSize - 1);
+	*p++ = (uint8_t)len;
+	memcpy(p, s, len);
+	return p + len;
+}
+
+static uint32_t get16(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+	return get16(p) | (get16(p + 2) << 16);
+}
+
+size_t encodedGameStateSize(const GameState *state) {
+	return SAVE_HEADER_BYTES
+		+ 1 + strnlen(state->activePuzzleName, sizeof(state->activePuzzleName) - 1)
+		+ 1 + strnlen(state->activeDifficulty, sizeof(state->activeDifficulty) - 1)
+		+ FIXED_FIELDS_BYTES + historySerializedSize(&state->history);
+}
+
+size_t encodeGameState(const GameState *state, uint8_t *out) {
+	uint8_t *p = out + SAVE_HEADER_BYTES;
+	p = putString(p, state->activePuzzleName, sizeof(state->activePuzzleName));
+	p = putString(p, state->activeDifficulty, sizeof(state->activeDifficulty));
+	PackedBoard packed;
+	packBoard(&state->currentGrid, &packed);
+	memcpy(p, packed.bytes, sizeof(packed.bytes));
+	p += sizeof(packed.bytes);
+	memset(p, 0, SAVE_FIXED_MASK_BYTES);
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (state->isFixed[cell / GRID_SIZE][cell % GRID_SIZE]) p[cell / 8] |= (uint8_t)(1u << (cell % 8));
+	}
+	p += SAVE_FIXED_MASK_BYTES;
+	p = put32(p, state->elapsedSeconds);
+	uint64_t timerStart = (uint64_t)(int64_t)state->timerStart;
+	p = put32(p, (uint32_t)timerStart);
+	p = put32(p, (uint32_t)(timerStart >> 32));
+	p = put16(p, (uint32_t)state->nextHintIndex);
+	p = serializeHistory(&state->history, p);
+
+	size_t payload = (size_t)(p - out) - SAVE_HEADER_BYTES;
+	memcpy(out, saveMagic, sizeof(saveMagic));
+	put16(out + 4, SAVE_FORMAT_VERSION);
+	put16(out + 6, 0);
+	put32(out + 8, (uint32_t)payload);
+	put32(out + 12, crc32Bytes(out + SAVE_HEADER_BYTES, payload));
+	return SAVE_HEADER_BYTES + payload;
+}
+
+static bool getString(const uint8_t **p, const uint8_t *end, char *out, size_t outSize) {
+	if (*p >= end) return false;
+	size_t len = **p;
+	(*p)++;
+	if (len >= outSize || (size_t)(end - *p) < len) return false;
+	memcpy(out, *p, len);
+	out[len] = '\0';
+	*p += len;
+	return true;
+}
+
+static bool validMove(const Move *m) {
+	return m->row >= 0 && m->row < GRID_SIZE && m->col >= 0 && m->col < GRID_SIZE
+		&& m->previousValue >= 0 && m->previousValue <= 9 && m->newValue >= 0 && m->newValue <= 9;
+}
+
+// Builds a history from a flat move log: moveCount applied moves followed by redoCount
+// undone ones, as saved by version 1 and the raw layouts.
+static bool historyFromMoveLog(MoveHistory *history, const Move *moves, size_t moveCount, size_t redoCount) {
+	memset(history, 0, sizeof(*history));
+	for (size_t i = 0; i < moveCount + redoCount; i++) {
+		if (!validMove(&moves[i]) || !historyPush(history, &moves[i])) {
+			freeMoveHistory(history);
+			return false;
+		}
+	}
+	for (size_t i = 0; i < redoCount; i++) historyUndo(history, NULL);
+	return true;
+}
+
+static bool decodeVersioned(const uint8_t *data, size_t size, GameState *state) {
+	if (size < V1_HEADER_BYTES) return false;
+	uint32_t version = get16(data + 4);
+	size_t header, payload;
+	uint32_t crc;
+	if (version == 1) {
+		header = V1_HEADER_BYTES;
+		payload = get16(data + 6);
+		crc = get32(data + 8);
+	} else if (version == SAVE_FORMAT_VERSION && size >= SAVE_HEADER_BYTES) {
+		header = SAVE_HEADER_BYTES;
+		payload = get32(data + 8);
+		crc = get32(data + 12);
+	} else {
+		return false;
+	}
+	if (size != header + payload || crc32Bytes(data + header, payload) != crc) return false;
+	const uint8_t *p = data + header, *end = data + size;
+	memset(state, 0, sizeof(*state));
+	if (!getString(&p, end, state->activePuzzleName, sizeof(state->activePuzzleName))) return false;
+	if (!getString(&p, end, state->activeDifficulty, sizeof(state->activeDifficulty))) return false;
+	if ((size_t)(end - p) < FIXED_FIELDS_BYTES) return false;
+	PackedBoard packed;
+	memcpy(packed.bytes, p, sizeof(packed.bytes));
+	p += sizeof(packed.bytes);
+	unpackBoard(&packed, &state->currentGrid);
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (state->currentGrid.cells[cell] > 9) return false;
+		state->isFixed[cell / GRID_SIZE][cell % GRID_SIZE] = (p[cell / 8] >> (cell % 8)) & 1u;
+	}
+	p += SAVE_FIXED_MASK_BYTES;
+	state->elapsedSeconds = get32(p);
+	uint64_t timerStart = (uint64_t)get32(p + 4) | ((uint64_t)get32(p + 8) << 32);
+	state->timerStart = (time_t)(int64_t)timerStart;
+	state->nextHintIndex = get16(p + 12);
+	p += 14;
+	if (version == SAVE_FORMAT_VERSION) {
+		if (!deserializeHistory(&state->history, &p, end)) return false;
+		if (p != end) {
+			freeMoveHistory(&state->history);
+			return false;
+		}
+		return true;
+	}
+	if (end - p < 2) return false;
+	size_t moveCount = p[0], redoCount = p[1];
+	p += 2;
+	if (moveCount + redoCount > LEGACY_MOVES || (size_t)(end - p) != 2 * (moveCount + redoCount)) return false;
+	Move moves[LEGACY_MOVES];
+	for (size_t i = 0; i < moveCount + redoCount; i++, p += 2) {
+		moves[i].row = p[0] >> 4;
+		moves[i].col = p[0] & 0x0F;
+		moves[i].previousValue = p[1] >> 4;
+		moves[i].newValue = p[1] & 0x0F;
+	}
+	return historyFromMoveLog(&state->history, moves, moveCount, redoCount);
+}
+
+// Shared conversion for the raw layouts: strings terminated, counts in range, grid sane.
+static bool finishLegacy(GameState *state, const char *difficulty, const char *name, const Move *moves,
+	size_t moveCount, size_t redoCount, time_t timerStart, unsigned int elapsedSeconds, size_t nextHintIndex) {
+	memcpy(state->activeDifficulty, difficulty, sizeof(state->activeDifficulty));
+	memcpy(state->activePuzzleName, name, sizeof(state->activePuzzleName));
+	state->activeDifficulty[sizeof(state->activeDifficulty) - 1] = '\0';
+	state->activePuzzleName[sizeof(state->activePuzzleName) - 1] = '\0';
+	state->timerStart = timerStart;
+	state->elapsedSeconds = elapsedSeconds;
+	state->nextHintIndex = nextHintIndex;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (state->currentGrid.cells[cell] > 9) return false;
+	}
+	if (moveCount > LEGACY_MOVES || redoCount > LEGACY_MOVES - moveCount) return false;
+	return historyFromMoveLog(&state->history, moves, moveCount, redoCount);
+}
+
+#define FINISH_LEGACY(state, legacy) finishLegacy((state), (legacy)->activeDifficulty, (legacy)->activePuzzleName, \
+	(legacy)->moves, (legacy)->moveCount, (legacy)->redoCount, (legacy)->timerStart, (legacy)->elapsedSeconds, \
+	(legacy)->nextHintIndex)
+
+static bool decodeAnyLayout(const uint8_t *data, size_t size, GameState *state) {
+	if (size >= sizeof(saveMagic) && memcmp(data, saveMagic, sizeof(saveMagic)) == 0) {
+		return decodeVersioned(data, size, state);
+	}
+	memset(state, 0, sizeof(*state));
+	if (size == sizeof(LegacyIntGameState)) {
+		LegacyIntGameState legacy;
+		memcpy(&legacy, data, sizeof(legacy));
+		for (int cell = 0; cell < CELL_COUNT; cell++) {
+			int v = legacy.currentGrid[cell / GRID_SIZE][cell % GRID_SIZE];
+			if (v < 0 || v > 9) return false;
+			state->currentGrid.cells[cell] = (uint8_t)v;
+		}
+		memcpy(state->isFixed, legacy.isFixed, sizeof(state->isFixed));
+		return FINISH_LEGACY(state, &legacy);
+	}
+	if (size == sizeof(LegacyBoardGameState)) {
+		LegacyBoardGameState legacy;
+		memcpy(&legacy, data, sizeof(legacy));
+		state->currentGrid = legacy.currentGrid;
+		memcpy(state->isFixed, legacy.isFixed, sizeof(state->isFixed));
+		return FINISH_LEGACY(state, &legacy);
+	}
+	return false;
+}
+
+bool decodeGameState(const uint8_t *data, size_t size, GameState *state) {
+	if (!decodeAnyLayout(data, size, state)) return false;
+	tallyBoard(&state->tally, &state->currentGrid);
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef SAVE_FORMAT_H
+#define SAVE_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "structs.h"
+
+// Save format version 2. Every field is written explicitly in little-endian order, so a
+// save does not depend on struct layout, endianness or the size of time_t:
+//   "SMSV" | u16 version | u16 reserved | u32 payload length | u32 CRC-32 of the payload | payload
+// Payload:
+//   u8 name length, name | u8 difficulty length, difficulty
+//   41-byte packed grid | 11-byte fixed-cell bitmap (bit k = cell k)
+//   u32 elapsed seconds | i64 timer start | u16 hint index
+//   move history (serializeHistory in move_history.h)
+// Version 1 had a 12-byte header with a u16 payload length and, instead of the history,
+// u8 move count | u8 redo count | 2 bytes per move; it is still read.
+#define SAVE_FORMAT_VERSION 2u
+#define SAVE_HEADER_BYTES 16
+#define SAVE_FIXED_MASK_BYTES ((CELL_COUNT + 7) / 8)
+
+size_t encodedGameStateSize(const GameState *state);
+// Encodes a state into out, which must hold encodedGameStateSize(state) bytes.
+// Returns the encoded size.
+size_t encodeGameState(const GameState *state, uint8_t *out);
+
+// Decodes a versioned save, or a raw GameState dump from older builds (either the
+// int-grid layout or the Board layout that followed it). Returns false when the data
+// is corrupt, truncated, or not a save at all. On success state->history owns memory
+// (freeMoveHistory).
+bool decodeGameState(const uint8_t *data, size_t size, GameState *state);
+
+uint32_t crc32Bytes(const uint8_t *data, size_t size);
+
+#endif
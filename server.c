@@ -0,0 +1,629 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // accept4
+#endif
+#include <stdio.h>
+#include "server.h"
+
+#ifndef __linux__
+
+int runServer(const char *address, PuzzleLibrary *library, Leaderboard *scores) {
+	(void)address;
+	(void)library;
+	(void)scores;
+	fprintf(stderr, "Server mode needs Linux (epoll).\n");
+	return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "board.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "game_session.h"
+#include "generator.h"
+#include "solve_job.h"
+#include "sys_thread.h"
+
+#define SERVER_LINE_MAX 256
+#define SERVER_READ_CHUNK 4096
+// A client that stops reading is not read from either once this much output is queued,
+// and is dropped when its output has made no progress for SERVER_WRITE_TIMEOUT seconds.
+#define SERVER_OUTPUT_LIMIT (64 * 1024)
+#define SERVER_WRITE_TIMEOUT 30.0
+// How often, at most, connections are checked for that timeout.
+#define SERVER_SWEEP_MS 1000
+#define SERVER_EVENTS 256
+
+// A 'new' whose puzzle is still being solved and checked for uniqueness.
+typedef struct PendingGame {
+	Puzzle puzzle;
+	SolveJob check;        // checkUnique, in slices
+} PendingGame;
+
+typedef struct Connection {
+	int fd;
+	unsigned long long id;
+	char input[SERVER_LINE_MAX];
+	size_t inputLength;
+	bool skipping;         // discarding the rest of an over-long line
+	char *deferred;        // input that arrived behind a line still being worked on
+	size_t deferredStart;
+	size_t deferredLength;
+	char *output;
+	size_t outputLength;
+	size_t outputSent;
+	size_t outputCapacity;
+	double outputProgress; // when output was last queued into an empty buffer or sent
+	uint32_t events;       // currently registered with epoll
+	bool closing;          // close once the output is flushed
+	bool hasGame;
+	unsigned games;
+	GameSession session;
+	PendingGame *pending;
+	bool working;          // a puzzle check or a solve is in progress; on the work list
+	struct Connection *prev;
+	struct Connection *next;
+	struct Connection *workPrev;
+	struct Connection *workNext;
+} Connection;
+
+typedef struct Server {
+	int epoll;
+	int listener;
+	bool acceptPaused;     // out of descriptors; resumed when a connection closes
+	PuzzleLibrary *library;
+	Leaderboard *scores;
+	PuzzleGenerator generator;
+	Connection *connections;
+	Connection *work;      // connections with a search to advance, one slice per loop pass
+	unsigned long long nextId;
+	unsigned long long startTime;
+	unsigned long long open;
+	unsigned long long peak;
+} Server;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signal) {
+	(void)signal;
+	stopRequested = 1;
+}
+
+static void copyString(char *dst, const char *src, size_t dstSize) {
+	if (!dst || !src || dstSize == 0) return;
+	size_t i = 0;
+	while (i + 1 < dstSize && src[i] != '\0') {
+		dst[i] = src[i];
+		i++;
+	}
+	dst[i] = '\0';
+}
+
+static bool watch(Server *server, int op, int fd, uint32_t events, void *ptr) {
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = ptr;
+	return epoll_ctl(server->epoll, op, fd, &event) == 0;
+}
+
+static void setConnectionEvents(Server *server, Connection *conn) {
+	// EPOLLRDHUP stays level-triggered after the peer shuts down its side, so it is only
+	// asked for while there is input to read; otherwise a half-closed peer that never reads
+	// its replies would wake the loop forever. EPOLLHUP and EPOLLERR are always reported.
+	uint32_t events = 0;
+	bool pending = conn->outputSent < conn->outputLength;
+	if (pending) events |= EPOLLOUT;
+	if (!conn->closing && !conn->working && conn->deferredLength == 0 &&
+		conn->outputLength - conn->outputSent < SERVER_OUTPUT_LIMIT) events |= EPOLLIN | EPOLLRDHUP;
+	if (events != conn->events && watch(server, EPOLL_CTL_MOD, conn->fd, events, conn)) conn->events = events;
+}
+
+static void addWork(Server *server, Connection *conn) {
+	conn->working = true;
+	conn->workPrev = NULL;
+	conn->workNext = server->work;
+	if (conn->workNext) conn->workNext->workPrev = conn;
+	server->work = conn;
+}
+
+static void removeWork(Server *server, Connection *conn) {
+	if (conn->workPrev) conn->workPrev->workNext = conn->workNext;
+	else server->work = conn->workNext;
+	if (conn->workNext) conn->workNext->workPrev = conn->workPrev;
+	conn->working = false;
+}
+
+static void closeConnection(Server *server, Connection *conn) {
+	epoll_ctl(server->epoll, EPOLL_CTL_DEL, conn->fd, NULL);
+	close(conn->fd);
+	if (conn->working) removeWork(server, conn);
+	if (conn->hasGame) endGameSession(&conn->session);
+	if (conn->pending) endSolveJob(&conn->pending->check);
+	free(conn->pending);
+	free(conn->deferred);
+	free(conn->output);
+	if (conn->prev) conn->prev->next = conn->next;
+	else server->connections = conn->next;
+	if (conn->next) conn->next->prev = conn->prev;
+	free(conn);
+	server->open--;
+	if (server->acceptPaused && watch(server, EPOLL_CTL_MOD, server->listener, EPOLLIN, NULL)) server->acceptPaused = false;
+}
+
+static bool queueOutput(Connection *conn, const char *data, size_t size) {
+	if (conn->outputSent == conn->outputLength) {
+		conn->outputSent = conn->outputLength = 0;
+		conn->outputProgress = monotonicSeconds();
+	}
+	if (conn->outputLength + size > conn->outputCapacity) {
+		if (conn->outputSent > 0) {
+			memmove(conn->output, conn->output + conn->outputSent, conn->outputLength - conn->outputSent);
+			conn->outputLength -= conn->outputSent;
+			conn->outputSent = 0;
+		}
+		size_t capacity = conn->outputCapacity ? conn->outputCapacity : 512;
+		while (capacity < conn->outputLength + size) capacity *= 2;
+		if (capacity != conn->outputCapacity) {
+			char *grown = (char*)realloc(conn->output, capacity);
+			if (!grown) return false;
+			conn->output = grown;
+			conn->outputCapacity = capacity;
+		}
+	}
+	memcpy(conn->output + conn->outputLength, data, size);
+	conn->outputLength += size;
+	return true;
+}
+
+// Queues "ok text" or "err text" as a single line: line breaks and runs of spaces in the
+// game's messages collapse into one space.
+static void reply(Connection *conn, bool ok, const char *text) {
+	char line[SESSION_REPLY_MAX + 8];
+	size_t n = (size_t)snprintf(line, sizeof(line), "%s", ok ? "ok" : "err");
+	bool space = true;
+	for (const char *p = text; *p && n + 2 < sizeof(line); p++) {
+		if (*p == '\n' || *p == '\r' || *p == ' ' || *p == '\t') {
+			space = true;
+			continue;
+		}
+		if (space) line[n++] = ' ';
+		space = false;
+		line[n++] = *p;
+	}
+	line[n++] = '\n';
+	if (!queueOutput(conn, line, n)) conn->closing = true;
+}
+
+static bool flushOutput(Connection *conn) {
+	while (conn->outputSent < conn->outputLength) {
+		ssize_t sent = send(conn->fd, conn->output + conn->outputSent, conn->outputLength - conn->outputSent, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		conn->outputSent += (size_t)sent;
+		conn->outputProgress = monotonicSeconds();
+	}
+	return true;
+}
+
+static bool choosePuzzle(Server *server, const char *argument, Puzzle *puzzle, const char **error) {
+	while (*argument == ' ') argument++;
+	if (strlen(argument) >= CELL_COUNT && argument[0] >= '0' && argument[0] <= '9') {
+		memset(puzzle, 0, sizeof(*puzzle));
+		copyString(puzzle->name, "Custom", sizeof(puzzle->name));
+		copyString(puzzle->difficulty, "Custom", sizeof(puzzle->difficulty));
+		if (!parseGrid81(argument, &puzzle->grid)) {
+			*error = "A puzzle is 81 digits, 0 for empty.";
+			return false;
+		}
+		return true;
+	}
+	int level = (int)(nextRandom(&server->generator) % DIFFICULTY_LEVELS);
+	if (*argument) {
+		level = findDifficultyLevel(argument);
+		if (level < 0) {
+			*error = "Unknown difficulty; use Easy, Medium, Hard or Expert.";
+			return false;
+		}
+	}
+	if (server->library && pickLibraryPuzzle(server->library, level, nextRandom(&server->generator), puzzle)) return true;
+	if (generatePuzzle(&server->generator, level, puzzle)) return true;
+	*error = "Could not generate a puzzle. Please try again.";
+	return false;
+}
+
+// Replaces the connection's game with one of puzzle, whose solution is known.
+static void beginGame(Server *server, Connection *conn, const Puzzle *puzzle) {
+	if (conn->hasGame) endGameSession(&conn->session);
+	// saves/<puzzle>-<server start>-<connection>-<game>.sav, so concurrent games of the
+	// same puzzle never share a file.
+	GameState named;
+	memset(&named, 0, sizeof(named));
+	copyString(named.activePuzzleName, puzzle->name, sizeof(named.activePuzzleName));
+	char savePath[320];
+	gameSavePath(&named, savePath, sizeof(savePath));
+	size_t stem = strlen(savePath) - strlen(".sav");
+	snprintf(savePath + stem, sizeof(savePath) - stem, "-%llx-%llu-%u.sav", server->startTime, conn->id, conn->games++);
+	startGameSession(&conn->session, puzzle, NULL, server->scores, false, savePath);
+	conn->session.solveBudget.seconds = SERVER_SOLVE_SECONDS;
+	conn->session.solveStepped = true;
+	conn->hasGame = true;
+	char text[192], grid[CELL_COUNT + 1];
+	formatGrid81(&conn->session.state.currentGrid, grid);
+	snprintf(text, sizeof(text), "%s %s %s", puzzle->name, puzzle->difficulty, grid);
+	reply(conn, true, text);
+}
+
+// Picks the puzzle for 'new'. Generated puzzles come with their solution and start at
+// once; the others are solved and checked for uniqueness on the work list first, and the
+// current game goes on until the new one is ready.
+static void startGame(Server *server, Connection *conn, const char *argument) {
+	PendingGame *pending = (PendingGame*)malloc(sizeof(PendingGame));
+	if (!pending) {
+		reply(conn, false, "Out of memory.");
+		return;
+	}
+	const char *error = NULL;
+	if (!choosePuzzle(server, argument, &pending->puzzle, &error)) {
+		reply(conn, false, error);
+		free(pending);
+		return;
+	}
+	if (pending->puzzle.solutionCount != SOLUTIONS_UNKNOWN && isBoardComplete(&pending->puzzle.solution)) {
+		beginGame(server, conn, &pending->puzzle);
+		free(pending);
+		return;
+	}
+	SolveBudget budget = { SERVER_SOLVE_SECONDS, 0 };
+	pending->check.checkUnique = true;
+	beginSolveJob(&pending->check, &pending->puzzle.grid, budget);
+	conn->pending = pending;
+	addWork(server, conn);
+}
+
+// Advances the pending puzzle check by one slice; returns true once it has replied.
+static bool checkPendingGame(Server *server, Connection *conn) {
+	PendingGame *pending = conn->pending;
+	SolveJob *check = &pending->check;
+	SolveOutcome outcome = advanceSolveJob(check);
+	if (outcome == SOLVE_RUNNING) return false;
+	endSolveJob(check);
+	conn->pending = NULL;
+	if (outcome == SOLVE_NO_SOLUTION) {
+		reply(conn, false, "This puzzle has no solution.");
+	} else if (check->solutions == 0) {
+		reply(conn, false, "Timed out checking this puzzle; it may still be solvable.");
+	} else {
+		// A check that ran out of time after the first solution leaves the count open.
+		solveJobBoard(check, &pending->puzzle.solution);
+		if (outcome == SOLVE_FOUND) pending->puzzle.solutionCount = check->solutions == 1 ? SOLUTIONS_UNIQUE : SOLUTIONS_SEVERAL;
+		beginGame(server, conn, &pending->puzzle);
+	}
+	free(pending);
+	return true;
+}
+
+static void answerSession(Connection *conn, const SessionReply *result) {
+	reply(conn, result->ok, result->text);
+	if (conn->session.over) {
+		endGameSession(&conn->session);
+		conn->hasGame = false;
+	}
+}
+
+static void handleLine(Server *server, Connection *conn, char *line) {
+	size_t len = strlen(line);
+	while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) line[--len] = '\0';
+	if (len == 0) return;
+	if (strcmp(line, "bye") == 0) {
+		reply(conn, true, "Goodbye!");
+		conn->closing = true;
+		return;
+	}
+	if (strncmp(line, "new", 3) == 0 && (line[3] == '\0' || line[3] == ' ')) {
+		startGame(server, conn, line + 3);
+		return;
+	}
+	if (!conn->hasGame) {
+		reply(conn, false, "No game in progress; send 'new [difficulty]' first.");
+		return;
+	}
+	if (strcmp(line, "board") == 0) {
+		char grid[CELL_COUNT + 1];
+		formatGrid81(&conn->session.state.currentGrid, grid);
+		reply(conn, true, grid);
+		return;
+	}
+	SessionReply result;
+	handleSessionLine(&conn->session, line, &result);
+	if (conn->session.solving) {
+		addWork(server, conn); // answered once stepSessionSolve is done
+		return;
+	}
+	answerSession(conn, &result);
+}
+
+// Answers every complete line in data until one starts work that has to finish first.
+// Returns how many bytes were used.
+static size_t consumeInput(Server *server, Connection *conn, const char *data, size_t size) {
+	size_t i = 0;
+	while (i < size && !conn->closing && !conn->working) {
+		char ch = data[i++];
+		if (ch == '\n') {
+			if (!conn->skipping) {
+				conn->input[conn->inputLength] = '\0';
+				handleLine(server, conn, conn->input);
+			}
+			conn->inputLength = 0;
+			conn->skipping = false;
+		} else if (!conn->skipping) {
+			if (conn->inputLength + 1 >= sizeof(conn->input)) {
+				reply(conn, false, "Line too long.");
+				conn->skipping = true;
+				conn->inputLength = 0;
+			} else {
+				conn->input[conn->inputLength++] = ch;
+			}
+		}
+	}
+	return i;
+}
+
+// Goes on with the input that waited behind finished work.
+static void resumeInput(Server *server, Connection *conn) {
+	if (conn->deferredLength > 0 && !conn->closing) {
+		size_t used = consumeInput(server, conn, conn->deferred + conn->deferredStart, conn->deferredLength);
+		conn->deferredStart += used;
+		conn->deferredLength -= used;
+	}
+	if (conn->deferredLength == 0 || conn->closing) {
+		free(conn->deferred);
+		conn->deferred = NULL;
+		conn->deferredStart = conn->deferredLength = 0;
+	}
+}
+
+// Reads what is available and answers every complete line. Returns false once the
+// connection should be dropped without flushing.
+static bool readInput(Server *server, Connection *conn) {
+	char chunk[SERVER_READ_CHUNK];
+	ssize_t got = recv(conn->fd, chunk, sizeof(chunk), 0);
+	if (got < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	if (got == 0) {
+		// The peer finished sending: answer a final unterminated line, then close.
+		if (conn->inputLength > 0 && !conn->skipping) {
+			conn->input[conn->inputLength] = '\0';
+			handleLine(server, conn, conn->input);
+		}
+		conn->inputLength = 0;
+		conn->closing = true;
+		return true;
+	}
+	size_t used = consumeInput(server, conn, chunk, (size_t)got);
+	if (used == (size_t)got || conn->closing) return true;
+	// No more is read until the work is done and this has been answered.
+	conn->deferred = (char*)malloc((size_t)got - used);
+	if (!conn->deferred) return false;
+	memcpy(conn->deferred, chunk + used, (size_t)got - used);
+	conn->deferredLength = (size_t)got - used;
+	return true;
+}
+
+static void acceptConnections(Server *server) {
+	for (;;) {
+		int fd = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+				// Stop polling the listener until a descriptor frees up, instead of spinning on it.
+				if (watch(server, EPOLL_CTL_MOD, server->listener, 0, NULL)) server->acceptPaused = true;
+			}
+			return;
+		}
+		Connection *conn = (Connection*)calloc(1, sizeof(Connection));
+		if (!conn) {
+			close(fd);
+			continue;
+		}
+		conn->fd = fd;
+		conn->id = server->nextId++;
+		conn->events = EPOLLIN | EPOLLRDHUP;
+		if (!watch(server, EPOLL_CTL_ADD, fd, conn->events, conn)) {
+			close(fd);
+			free(conn);
+			continue;
+		}
+		conn->next = server->connections;
+		if (conn->next) conn->next->prev = conn;
+		server->connections = conn;
+		if (++server->open > server->peak) server->peak = server->open;
+		reply(conn, true, "SudokuMate server. Send 'new [difficulty]' to start a game.");
+		flushOutput(conn);
+		setConnectionEvents(server, conn);
+	}
+}
+
+// Sends what it can, then closes the connection or updates what it waits for.
+static void settleConnection(Server *server, Connection *conn, bool alive) {
+	if (alive) alive = flushOutput(conn);
+	if (!alive || (conn->closing && conn->outputSent == conn->outputLength)) {
+		closeConnection(server, conn);
+		return;
+	}
+	setConnectionEvents(server, conn);
+}
+
+static void serviceConnection(Server *server, Connection *conn, uint32_t events) {
+	if (events & (EPOLLERR | EPOLLHUP)) {
+		closeConnection(server, conn);
+		return;
+	}
+	bool alive = true;
+	if ((events & (EPOLLIN | EPOLLRDHUP)) && !conn->closing && !conn->working && conn->deferredLength == 0) {
+		alive = readInput(server, conn);
+	}
+	settleConnection(server, conn, alive);
+}
+
+// Gives every connection on the work list one slice of search, so a hard puzzle delays
+// the other connections by a slice per loop pass rather than by its whole search.
+static void advanceWork(Server *server) {
+	Connection *conn = server->work;
+	while (conn) {
+		Connection *next = conn->workNext;
+		bool done;
+		if (conn->pending) {
+			done = checkPendingGame(server, conn);
+		} else {
+			SessionReply result;
+			done = stepSessionSolve(&conn->session, &result);
+			if (done) answerSession(conn, &result);
+		}
+		if (done) {
+			removeWork(server, conn);
+			resumeInput(server, conn);
+			settleConnection(server, conn, true);
+		}
+		conn = next;
+	}
+}
+
+// Drops the connections whose peers have stopped draining their output.
+static void dropStalledConnections(Server *server, double now) {
+	Connection *conn = server->connections;
+	while (conn) {
+		Connection *next = conn->next;
+		if (conn->outputSent < conn->outputLength && now - conn->outputProgress >= SERVER_WRITE_TIMEOUT) {
+			closeConnection(server, conn);
+		}
+		conn = next;
+	}
+}
+
+static int openListener(const char *address, bool *isUnix) {
+	bool numeric = *address != '\0';
+	for (const char *p = address; *p; p++) {
+		if (*p < '0' || *p > '9') numeric = false;
+	}
+	*isUnix = !numeric;
+	int fd;
+	if (numeric) {
+		long port = strtol(address, NULL, 10);
+		if (port <= 0 || port > 65535) return -1;
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) return -1;
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+			close(fd);
+			return -1;
+		}
+	} else {
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(address) >= sizeof(addr.sun_path)) return -1;
+		copyString(addr.sun_path, address, sizeof(addr.sun_path));
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0) return -1;
+		unlink(address); // a socket left behind by an earlier run
+		if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+			close(fd);
+			return -1;
+		}
+	}
+	if (listen(fd, SOMAXCONN) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// Every player costs one descriptor, so take all the hard limit allows.
+static void raiseDescriptorLimit(void) {
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= limit.rlim_max) return;
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+int runServer(const char *address, PuzzleLibrary *library, Leaderboard *scores) {
+	Server server;
+	memset(&server, 0, sizeof(server));
+	server.library = library;
+	server.scores = scores;
+	server.startTime = (unsigned long long)time(NULL);
+	seedGenerator(&server.generator, server.startTime);
+	raiseDescriptorLimit();
+
+	bool isUnix;
+	server.listener = openListener(address, &isUnix);
+	if (server.listener < 0) {
+		fprintf(stderr, "Could not listen on %s: %s\n", address, strerror(errno));
+		return 1;
+	}
+	server.epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (server.epoll < 0 || !watch(&server, EPOLL_CTL_ADD, server.listener, EPOLLIN, NULL)) {
+		fprintf(stderr, "Could not start the event loop: %s\n", strerror(errno));
+		close(server.listener);
+		if (server.epoll >= 0) close(server.epoll);
+		return 1;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = requestStop; // no SA_RESTART, so epoll_wait returns on a signal
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	fprintf(stderr, "Serving on %s%s\n", isUnix ? "" : "127.0.0.1:", address);
+
+	struct epoll_event events[SERVER_EVENTS];
+	double lastSweep = monotonicSeconds();
+	while (!stopRequested) {
+		int n = epoll_wait(server.epoll, events, SERVER_EVENTS, server.work ? 0 : SERVER_SWEEP_MS);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			fprintf(stderr, "epoll_wait failed: %s\n", strerror(errno));
+			break;
+		}
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr == NULL) acceptConnections(&server);
+			else serviceConnection(&server, (Connection*)events[i].data.ptr, events[i].events);
+		}
+		advanceWork(&server);
+		double now = monotonicSeconds();
+		if (now - lastSweep >= SERVER_SWEEP_MS / 1000.0) {
+			dropStalledConnections(&server, now);
+			lastSweep = now;
+		}
+	}
+
+	fprintf(stderr, "Stopping with %llu open connections (peak %llu)\n", server.open, server.peak);
+	while (server.connections) closeConnection(&server, server.connections);
+	close(server.listener);
+	if (isUnix) unlink(address);
+	close(server.epoll);
+	return 0;
+}
+
+#endif
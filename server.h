@@ -0,0 +1,33 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "leaderboard.h"
+#include "puzzle_library.h"
+
+// Headless game server: every connection plays its own GameSession (game_session.h), and
+// one thread multiplexes all of them with epoll, so there is no thread per player.
+//
+// The protocol is line based. Every command line gets exactly one reply line, "ok" or
+// "err" followed by the message the interactive game would print:
+//   new [Easy|Medium|Hard|Expert|<81 digits>]   start a game (random difficulty by default)
+//   board                                       "ok <81 digits>" of the current grid
+//   row col value | check r c | undo | redo | branch | mistakes | solve | save | quit
+//   bye                                         close the connection
+// Completing the puzzle or 'quit' ends the game; 'new' starts another. 'save' writes
+// saves/<puzzle>-<id>.sav, which the interactive game can load.
+//
+// Searches never run to the end in one go on the serving thread: the solve behind 'solve'
+// and the uniqueness check of a new puzzle advance SOLVE_JOB_SLICE_NODES at a time, one
+// slice per connection per pass of the event loop, and the connection's later commands
+// wait for the answer. Each gives up after SERVER_SOLVE_SECONDS. Generating a puzzle, when
+// the library has none of the level, still runs in one go and takes up to tens of
+// milliseconds.
+#define SERVER_SOLVE_SECONDS 1.0
+
+// Serves on 127.0.0.1:<port> when address is all digits, else on a Unix domain socket at
+// that path. 'new' draws from library when it has puzzles of the level and generates one
+// otherwise; finished games go to scores. Either may be NULL. Runs until SIGINT or
+// SIGTERM; returns a process exit code.
+int runServer(const char *address, PuzzleLibrary *library, Leaderboard *scores);
+
+#endif
@@ -0,0 +1,310 @@
+#include <stdlib.h>
+#include <string.h>
+#include "solution_cache.h"
+#include "board.h"
+#include "canonical.h"
+#include "file_io.h"
+#include "game_logic.h"
+#include "save_format.h"
+#include "sys_thread.h"
+
+// Cache file, little-endian: magic | version | flags | count | crc32 of the records, then
+// count records of key.lo | key.hi | packed solution, least recently used first so that
+// loading them in order restores the recency order.
+#define CACHE_FILE_VERSION 1u
+#define CACHE_HEADER_BYTES 20
+#define CACHE_RECORD_BYTES (16 + PACKED_BOARD_BYTES)
+#define CACHE_FLAG_CANONICAL 1u
+
+static const uint8_t cacheMagic[4] = { 'S', 'M', 'S', 'C' };
+
+typedef struct CacheEntry {
+	BoardKey key;
+	PackedBoard solution;
+	int32_t newer;     // LRU list neighbours, -1 at the ends
+	int32_t older;
+	int32_t chain;     // next entry in the same bucket, -1 at the end
+} CacheEntry;
+
+typedef struct SolutionCache {
+	bool ready;
+	bool canonicalKeys;
+	SysMutex lock;
+	CacheEntry *entries;
+	int32_t *buckets;
+	size_t bucketMask;
+	size_t capacity;
+	size_t count;
+	int32_t newest;
+	int32_t oldest;
+	SolutionCacheStats stats;
+} SolutionCache;
+
+static SolutionCache cache;
+
+static void put32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+	put32(p, (uint32_t)v);
+	put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get64(const uint8_t *p) {
+	return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+bool initSolutionCache(size_t capacity, bool canonicalKeys) {
+	freeSolutionCache();
+	if (capacity == 0 || capacity > INT32_MAX / 2) return false;
+	size_t buckets = 1;
+	while (buckets < capacity * 2) buckets *= 2;
+	cache.entries = (CacheEntry*)malloc(capacity * sizeof(CacheEntry));
+	cache.buckets = (int32_t*)malloc(buckets * sizeof(int32_t));
+	if (!cache.entries || !cache.buckets) {
+		free(cache.entries);
+		free(cache.buckets);
+		memset(&cache, 0, sizeof(cache));
+		return false;
+	}
+	for (size_t i = 0; i < buckets; i++) cache.buckets[i] = -1;
+	cache.bucketMask = buckets - 1;
+	cache.capacity = capacity;
+	cache.count = 0;
+	cache.newest = cache.oldest = -1;
+	cache.canonicalKeys = canonicalKeys;
+	memset(&cache.stats, 0, sizeof(cache.stats));
+	initMutex(&cache.lock);
+	cache.ready = true;
+	return true;
+}
+
+void freeSolutionCache(void) {
+	if (!cache.ready) return;
+	destroyMutex(&cache.lock);
+	free(cache.entries);
+	free(cache.buckets);
+	memset(&cache, 0, sizeof(cache));
+}
+
+static int32_t *bucketFor(BoardKey key) {
+	return &cache.buckets[key.lo & cache.bucketMask];
+}
+
+static int32_t findEntry(BoardKey key) {
+	for (int32_t i = *bucketFor(key); i >= 0; i = cache.entries[i].chain) {
+		if (cache.entries[i].key.lo == key.lo && cache.entries[i].key.hi == key.hi) return i;
+	}
+	return -1;
+}
+
+static void unlinkRecency(int32_t i) {
+	CacheEntry *e = &cache.entries[i];
+	if (e->newer >= 0) cache.entries[e->newer].older = e->older;
+	else cache.newest = e->older;
+	if (e->older >= 0) cache.entries[e->older].newer = e->newer;
+	else cache.oldest = e->newer;
+}
+
+static void makeNewest(int32_t i) {
+	CacheEntry *e = &cache.entries[i];
+	e->newer = -1;
+	e->older = cache.newest;
+	if (cache.newest >= 0) cache.entries[cache.newest].newer = i;
+	cache.newest = i;
+	if (cache.oldest < 0) cache.oldest = i;
+}
+
+static void unlinkBucket(int32_t i) {
+	int32_t *link = bucketFor(cache.entries[i].key);
+	while (*link != i) link = &cache.entries[*link].chain;
+	*link = cache.entries[i].chain;
+}
+
+// Called with the lock held.
+static void storeEntry(BoardKey key, const Board *solution) {
+	int32_t i = findEntry(key);
+	if (i >= 0) {
+		unlinkRecency(i);
+	} else {
+		if (cache.count < cache.capacity) {
+			i = (int32_t)cache.count++;
+		} else {
+			i = cache.oldest;
+			unlinkRecency(i);
+			unlinkBucket(i);
+			cache.stats.evictions++;
+		}
+		cache.entries[i].key = key;
+		cache.entries[i].chain = *bucketFor(key);
+		*bucketFor(key) = i;
+	}
+	packBoard(solution, &cache.entries[i].solution);
+	makeNewest(i);
+}
+
+static bool lookupEntry(BoardKey key, Board *solution) {
+	int32_t i = findEntry(key);
+	if (i < 0) return false;
+	unpackBoard(&cache.entries[i].solution, solution);
+	unlinkRecency(i);
+	makeNewest(i);
+	return true;
+}
+
+// A cached answer is only trusted when it is a finished grid that breaks no rule and keeps
+// every given; a damaged cache file or a key collision then costs a search, not a wrong
+// answer.
+static bool solves(const Board *solution, const Board *puzzle) {
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (solution->cells[cell] < 1 || solution->cells[cell] > 9) return false;
+		if (puzzle->cells[cell] && puzzle->cells[cell] != solution->cells[cell]) return false;
+	}
+	return isBoardValid(solution);
+}
+
+static BoardKey strategyKey(BoardKey key, SolverStrategy strategy) {
+	key.hi ^= ((uint64_t)strategy + 1) * 0x9E3779B97F4A7C15ull;
+	return key;
+}
+
+// In canonical mode the cache holds canonical solutions, mapped back through the
+// transform that canonicalized this particular puzzle.
+static BoardKey puzzleKey(const Board *puzzle, SolverStrategy strategy, GridTransform *transform) {
+	Board keyed = *puzzle;
+	if (cache.canonicalKeys) canonicalizeBoard(puzzle, &keyed, transform);
+	return strategyKey(hashBoardKey(&keyed), strategy);
+}
+
+static bool lookupPuzzle(const Board *puzzle, BoardKey key, const GridTransform *transform, Board *solution) {
+	Board found;
+	lockMutex(&cache.lock);
+	bool hit = lookupEntry(key, &found);
+	if (hit && cache.canonicalKeys) {
+		Board mapped;
+		undoGridTransform(transform, &found, &mapped);
+		found = mapped;
+	}
+	hit = hit && solves(&found, puzzle);
+	if (hit) cache.stats.hits++;
+	else cache.stats.misses++;
+	unlockMutex(&cache.lock);
+	if (hit) *solution = found;
+	return hit;
+}
+
+static void storePuzzle(BoardKey key, const GridTransform *transform, const Board *solution) {
+	Board stored = *solution;
+	if (cache.canonicalKeys) applyGridTransform(transform, solution, &stored);
+	lockMutex(&cache.lock);
+	storeEntry(key, &stored);
+	unlockMutex(&cache.lock);
+}
+
+bool solveSudokuCached(Board *board, SolverStrategy strategy, SolverStats *stats) {
+	if (!cache.ready) {
+		if (stats) return solveSudokuStats(board, strategy, stats);
+		return solveSudokuWith(board, strategy, NULL);
+	}
+	GridTransform transform;
+	BoardKey key = puzzleKey(board, strategy, &transform);
+	if (lookupPuzzle(board, key, &transform, board)) {
+		if (stats) {
+			memset(stats, 0, sizeof(*stats));
+			stats->solves = 1;
+		}
+		return true;
+	}
+	bool solved = stats ? solveSudokuStats(board, strategy, stats) : solveSudokuWith(board, strategy, NULL);
+	if (solved) storePuzzle(key, &transform, board);
+	return solved;
+}
+
+bool lookupCachedSolution(const Board *puzzle, SolverStrategy strategy, Board *solution) {
+	if (!cache.ready) return false;
+	GridTransform transform;
+	BoardKey key = puzzleKey(puzzle, strategy, &transform);
+	return lookupPuzzle(puzzle, key, &transform, solution);
+}
+
+void cacheSolution(const Board *puzzle, SolverStrategy strategy, const Board *solution) {
+	if (!cache.ready) return;
+	GridTransform transform;
+	BoardKey key = puzzleKey(puzzle, strategy, &transform);
+	storePuzzle(key, &transform, solution);
+}
+
+SolutionCacheStats solutionCacheStats(void) {
+	SolutionCacheStats stats;
+	memset(&stats, 0, sizeof(stats));
+	if (!cache.ready) return stats;
+	lockMutex(&cache.lock);
+	stats = cache.stats;
+	stats.entries = cache.count;
+	stats.capacity = cache.capacity;
+	unlockMutex(&cache.lock);
+	return stats;
+}
+
+bool loadSolutionCache(const char *path) {
+	if (!cache.ready) return false;
+	size_t size;
+	uint8_t *data = readWholeFile(path, &size);
+	if (!data) return false;
+	bool ok = size >= CACHE_HEADER_BYTES && memcmp(data, cacheMagic, sizeof(cacheMagic)) == 0
+		&& get32(data + 4) == CACHE_FILE_VERSION
+		&& get32(data + 8) == (cache.canonicalKeys ? CACHE_FLAG_CANONICAL : 0u);
+	size_t count = ok ? get32(data + 12) : 0;
+	ok = ok && size == CACHE_HEADER_BYTES + count * CACHE_RECORD_BYTES
+		&& crc32Bytes(data + CACHE_HEADER_BYTES, size - CACHE_HEADER_BYTES) == get32(data + 16);
+	if (ok) {
+		lockMutex(&cache.lock);
+		for (size_t i = 0; i < count; i++) {
+			const uint8_t *record = data + CACHE_HEADER_BYTES + i * CACHE_RECORD_BYTES;
+			BoardKey key = { get64(record), get64(record + 8) };
+			PackedBoard packed;
+			memcpy(packed.bytes, record + 16, sizeof(packed.bytes));
+			Board solution;
+			unpackBoard(&packed, &solution);
+			storeEntry(key, &solution);
+		}
+		unlockMutex(&cache.lock);
+	}
+	free(data);
+	return ok;
+}
+
+bool saveSolutionCache(const char *path) {
+	if (!cache.ready) return false;
+	lockMutex(&cache.lock);
+	size_t size = CACHE_HEADER_BYTES + cache.count * CACHE_RECORD_BYTES;
+	uint8_t *data = (uint8_t*)malloc(size);
+	if (!data) {
+		unlockMutex(&cache.lock);
+		return false;
+	}
+	uint8_t *record = data + CACHE_HEADER_BYTES;
+	for (int32_t i = cache.oldest; i >= 0; i = cache.entries[i].newer) {
+		put64(record, cache.entries[i].key.lo);
+		put64(record + 8, cache.entries[i].key.hi);
+		memcpy(record + 16, cache.entries[i].solution.bytes, PACKED_BOARD_BYTES);
+		record += CACHE_RECORD_BYTES;
+	}
+	memcpy(data, cacheMagic, sizeof(cacheMagic));
+	put32(data + 4, CACHE_FILE_VERSION);
+	put32(data + 8, cache.canonicalKeys ? CACHE_FLAG_CANONICAL : 0u);
+	put32(data + 12, (uint32_t)cache.count);
+	unlockMutex(&cache.lock);
+	put32(data + 16, crc32Bytes(data + CACHE_HEADER_BYTES, size - CACHE_HEADER_BYTES));
+	bool ok = writeFileAtomically(path, data, size);
+	free(data);
+	return ok;
+}
@@ -0,0 +1,45 @@
+#ifndef SOLUTION_CACHE_H
+#define SOLUTION_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "structs.h"
+#include "solver.h"
+
+// Process-wide LRU cache of solutions, keyed by a 128-bit hash of the puzzle and the
+// strategy that solved it (so a cached answer is the one that strategy would give, even
+// for puzzles with several solutions). Safe to use from several threads. Until
+// initSolutionCache is called every lookup misses and nothing is stored.
+#define SOLUTION_CACHE_DEFAULT_ENTRIES 4096
+#define SOLUTION_CACHE_PATH "solutions.cache"
+
+typedef struct SolutionCacheStats {
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long evictions;
+	size_t entries;
+	size_t capacity;
+} SolutionCacheStats;
+
+// With canonicalKeys, puzzles are keyed by their canonical form (canonical.h), so every
+// relabeled, transposed or shuffled copy of a puzzle shares one entry. Canonicalizing
+// costs about as much as solving a typical puzzle, so it only pays off for hard ones.
+bool initSolutionCache(size_t capacity, bool canonicalKeys);
+void freeSolutionCache(void);
+
+// solveSudokuStats that answers from the cache when it can and remembers what it solves.
+// stats is optional; a cache hit reports no search.
+bool solveSudokuCached(Board *board, SolverStrategy strategy, SolverStats *stats);
+// The two halves of it, for callers that search on their own: the lookup (which counts as
+// a hit or a miss) and remembering what the search found.
+bool lookupCachedSolution(const Board *puzzle, SolverStrategy strategy, Board *solution);
+void cacheSolution(const Board *puzzle, SolverStrategy strategy, const Board *solution);
+
+SolutionCacheStats solutionCacheStats(void);
+
+// Persistence across runs. Loading adds to whatever is cached already; a missing or
+// damaged file loads nothing.
+bool loadSolutionCache(const char *path);
+bool saveSolutionCache(const char *path);
+
+#endif
@@ -0,0 +1,117 @@
+#include <string.h>
+#include "solve_job.h"
+
+static void prepareJob(SolveJob *job, const Board *board, SolveBudget budget) {
+	memset(&job->stats, 0, sizeof(job->stats));
+	STATS_CLOCK(setupStart);
+	startStepSolver(&job->solver, board);
+	STATS_ELAPSED(&job->stats, setupSeconds, setupStart);
+	job->solver.stats = &job->stats;
+	job->budget = budget;
+	job->startedAt = monotonicSeconds();
+	job->cancelRequested = false;
+	job->outcome = SOLVE_RUNNING;
+	job->nodes = 0;
+	job->seconds = 0;
+	job->solutions = 0;
+	initMutex(&job->lock);
+}
+
+// Searches one slice, then checks whether the solver finished, the budget ran out or a
+// cancel arrived.
+static SolveOutcome searchSlice(SolveJob *job) {
+	SolveOutcome outcome = SOLVE_RUNNING;
+	unsigned long long slice = SOLVE_JOB_SLICE_NODES;
+	if (job->budget.nodes > 0 && job->budget.nodes - job->solver.nodes < slice) {
+		slice = job->budget.nodes - job->solver.nodes;
+	}
+	StepStatus status = job->solver.status;
+	// Stepping a solved search again looks for the next solution.
+	if (status == STEP_RUNNING || (status == STEP_SOLVED && job->checkUnique && job->solutions == 1)) {
+		status = stepSolver(&job->solver, slice);
+		if (status == STEP_SOLVED && job->solutions++ == 0) stepSolverBoard(&job->solver, &job->solution);
+	}
+	bool done = status == STEP_EXHAUSTED || (status == STEP_SOLVED && (!job->checkUnique || job->solutions == 2));
+	double seconds = monotonicSeconds() - job->startedAt;
+	lockMutex(&job->lock);
+	if (done) outcome = job->solutions > 0 ? SOLVE_FOUND : SOLVE_NO_SOLUTION;
+	else if (job->cancelRequested) outcome = SOLVE_CANCELLED;
+	else if ((job->budget.seconds > 0 && seconds >= job->budget.seconds) ||
+		(job->budget.nodes > 0 && job->solver.nodes >= job->budget.nodes)) outcome = SOLVE_TIMED_OUT;
+	job->nodes = job->solver.nodes;
+	job->seconds = seconds;
+	job->outcome = outcome;
+	unlockMutex(&job->lock);
+	if (outcome == SOLVE_RUNNING) return outcome;
+	job->stats.nodes = job->solver.nodes;
+	job->stats.solves = 1;
+#if SOLVER_STATS_ENABLED
+	job->stats.searchSeconds = seconds;
+#endif
+	return outcome;
+}
+
+static SolveOutcome searchJob(SolveJob *job) {
+	SolveOutcome outcome = SOLVE_RUNNING;
+	while (outcome == SOLVE_RUNNING) outcome = searchSlice(job);
+	return outcome;
+}
+
+SolveOutcome runSolveJob(SolveJob *job, const Board *board, SolveBudget budget) {
+	prepareJob(job, board, budget);
+	SolveOutcome outcome = searchJob(job);
+	destroyMutex(&job->lock);
+	return outcome;
+}
+
+void beginSolveJob(SolveJob *job, const Board *board, SolveBudget budget) {
+	prepareJob(job, board, budget);
+}
+
+SolveOutcome advanceSolveJob(SolveJob *job) {
+	return job->outcome == SOLVE_RUNNING ? searchSlice(job) : job->outcome;
+}
+
+void endSolveJob(SolveJob *job) {
+	destroyMutex(&job->lock);
+}
+
+static void solveJobMain(void *arg) {
+	SolveJob *job = (SolveJob*)arg;
+	searchJob(job);
+	if (job->notify) job->notify(job->notifyArg);
+}
+
+bool startSolveJob(SolveJob *job, const Board *board, SolveBudget budget, SolveJobNotify notify, void *arg) {
+	prepareJob(job, board, budget);
+	job->notify = notify;
+	job->notifyArg = arg;
+	if (startThread(&job->thread, solveJobMain, job)) return true;
+	destroyMutex(&job->lock);
+	return false;
+}
+
+SolveOutcome pollSolveJob(SolveJob *job, unsigned long long *nodes, double *seconds) {
+	lockMutex(&job->lock);
+	SolveOutcome outcome = job->outcome;
+	if (nodes) *nodes = job->nodes;
+	if (seconds) *seconds = job->seconds;
+	unlockMutex(&job->lock);
+	return outcome;
+}
+
+void cancelSolveJob(SolveJob *job) {
+	lockMutex(&job->lock);
+	job->cancelRequested = true;
+	unlockMutex(&job->lock);
+}
+
+SolveOutcome finishSolveJob(SolveJob *job) {
+	joinThread(job->thread);
+	destroyMutex(&job->lock);
+	return job->outcome;
+}
+
+void solveJobBoard(const SolveJob *job, Board *out) {
+	*out = job->solution;
+}
@@ -0,0 +1,85 @@
+#ifndef SOLVE_JOB_H
+#define SOLVE_JOB_H
+
+#include <stdbool.h>
+#include "structs.h"
+#include "solver_stats.h"
+#include "step_solver.h"
+#include "sys_thread.h"
+
+// Digit trials between checks of the cancel flag and the budget: well under a
+// millisecond of search, so a cancel or a deadline takes effect almost at once.
+#define SOLVE_JOB_SLICE_NODES 4096
+
+typedef enum SolveOutcome {
+	SOLVE_RUNNING,
+	SOLVE_FOUND,
+	SOLVE_NO_SOLUTION,
+	SOLVE_TIMED_OUT,   // the budget ran out first; the board may still be solvable
+	SOLVE_CANCELLED
+} SolveOutcome;
+
+// Limits for one solve; a zero field means no limit.
+typedef struct SolveBudget {
+	double seconds;
+	unsigned long long nodes;
+} SolveBudget;
+
+// Called on the solving thread once the outcome is known.
+typedef void (*SolveJobNotify)(void *arg);
+
+// One solve on the stepped solver (step_solver.h), either run to the end on the calling
+// thread or on a worker thread that can be polled and cancelled.
+//
+// With checkUnique set before the job starts, it is countSolutions(board, 2) instead: the
+// search goes on after the first solution to learn whether it is the only one, and ends
+// with SOLVE_FOUND and solutions at 1 or 2. A check that times out or is cancelled after
+// the first solution still has it in solutions and solution; only its uniqueness is open.
+typedef struct SolveJob {
+	bool checkUnique;
+	StepSolver solver;
+	SolverStats stats;
+	SolveBudget budget;
+	double startedAt;
+	SysThread thread;
+	SysMutex lock;           // guards the fields below
+	bool cancelRequested;
+	SolveOutcome outcome;
+	unsigned long long nodes;
+	double seconds;
+	SolveJobNotify notify;
+	void *notifyArg;
+	int solutions;           // found so far; read once the job has ended
+	Board solution;          // the first one found
+} SolveJob;
+
+// Solves board on the calling thread within the budget. The solution, for SOLVE_FOUND,
+// is read with solveJobBoard.
+SolveOutcome runSolveJob(SolveJob *job, const Board *board, SolveBudget budget);
+
+// Or runs it in slices on the calling thread, for a caller that has other work to
+// interleave but no thread to spare: beginSolveJob sets the solve up, each advanceSolveJob
+// searches one slice and returns SOLVE_RUNNING until the solve has ended, and endSolveJob
+// releases it, whether or not it ended. The time budget counts wall-clock time from
+// beginSolveJob, including the time spent between slices.
+void beginSolveJob(SolveJob *job, const Board *board, SolveBudget budget);
+SolveOutcome advanceSolveJob(SolveJob *job);
+void endSolveJob(SolveJob *job);
+
+// Starts the same solve on a worker thread; notify (optional) is called when it ends.
+// Every started job must be finished with finishSolveJob. Returns false if no thread
+// could be started.
+bool startSolveJob(SolveJob *job, const Board *board, SolveBudget budget, SolveJobNotify notify, void *arg);
+
+// SOLVE_RUNNING until the worker is done; nodes and seconds (optional) report progress.
+SolveOutcome pollSolveJob(SolveJob *job, unsigned long long *nodes, double *seconds);
+
+// Asks the worker to stop at its next check.
+void cancelSolveJob(SolveJob *job);
+
+// Waits for the worker and returns the outcome.
+SolveOutcome finishSolveJob(SolveJob *job);
+
+void solveJobBoard(const SolveJob *job, Board *out);
+
+#endif
@@ -1,33 +1,305 @@
-#include <stdbool.h>
-#include "solver.h"
-#include "game_logic.h"
-
-static bool findEmptyCell(int grid[GRID_SIZE][GRID_SIZE], int *outRow, int *outCol) {
-	for (int r = 0; r < GRID_SIZE; r++) {
-		for (int c = 0; c < GRID_SIZE; c++) {
-			if (grid[r][c] == 0) {
-				*outRow = r;
-				*outCol = c;
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
-bool solveSudoku(int grid[GRID_SIZE][GRID_SIZE]) {
-	int row, col;
-	if (!findEmptyCell(grid, &row, &col)) {
-		return true; 
-	}
-	for (int value = 1; value <= 9; value++) {
-		if (isMoveValid((const int (*)[GRID_SIZE])grid, row, col, value)) {
-			grid[row][col] = value;
-			if (solveSudoku(grid)) return true;
-			grid[row][col] = 0;
-		}
-	}
-	return false; 
-}
-
-
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "solver.h"
+#include "bitmask.h"
+#include "board.h"
+#include "dlx.h"
+#include "step_solver.h"
+#include "sys_thread.h"
+
+typedef struct MaskSolver {
+	MaskBoard board;
+	uint8_t emptyCells[CELL_COUNT];
+	unsigned long long nodes;
+	MaskBoard solution;
+	int limit;
+	int found;
+	SolverStats *stats;   // NULL unless statistics were asked for
+	int depth;            // only tracked for statistics
+} MaskSolver;
+
+#if SOLVER_STATS_ENABLED
+#define ENTER_LEVEL(s) do { (s)->depth++; STATS_DEPTH((s)->stats, (s)->depth); } while (0)
+#define LEAVE_LEVEL(s) ((s)->depth--)
+#else
+#define ENTER_LEVEL(s) ((void)0)
+#define LEAVE_LEVEL(s) ((void)0)
+#endif
+
+static SolverStrategy defaultStrategy = SOLVER_MRV;
+
+// Each thread builds its exact-cover matrix once and reuses it for every DLX solve.
+static THREAD_LOCAL DlxSolver threadDlx;
+static THREAD_LOCAL bool threadDlxReady;
+
+static DlxSolver *getThreadDlx(void) {
+	if (!threadDlxReady) {
+		initDlxSolver(&threadDlx);
+		threadDlxReady = true;
+	}
+	return &threadDlx;
+}
+
+static bool searchBacktrack(MaskSolver *s, int k) {
+	if (s->board.emptyCount == 0) return true;
+	int cell = s->emptyCells[k];
+	unsigned int candidates = cellCandidates(&s->board, cell);
+	while (candidates) {
+		unsigned int bit = candidates & (0u - candidates);
+		candidates ^= bit;
+		s->nodes++;
+		placeDigit(&s->board, cell, bit);
+		STATS_DEPTH(s->stats, k + 1);
+		if (searchBacktrack(s, k + 1)) return true;
+		removeDigit(&s->board, cell, bit);
+		STATS_ADD(s->stats, backtracks, 1);
+	}
+	return false;
+}
+
+// Places naked and hidden singles until nothing changes. Returns false on a contradiction.
+static bool propagateSingles(MaskBoard *b, SolverStats *stats) {
+	bool changed = true;
+	while (changed && b->emptyCount > 0) {
+		changed = false;
+		for (int cell = 0; cell < CELL_COUNT; cell++) {
+			if (b->cells[cell]) continue;
+			unsigned int cand = cellCandidates(b, cell);
+			if (!cand) return false;
+			if (!(cand & (cand - 1))) {
+				placeDigit(b, cell, cand);
+				STATS_ADD(stats, propagations, 1);
+				changed = true;
+			}
+		}
+		for (int unit = 0; unit < UNIT_COUNT; unit++) {
+			unsigned int once = 0, more = 0, placed = 0;
+			for (int i = 0; i < GRID_SIZE; i++) {
+				int cell = unitCell(unit, i);
+				if (b->cells[cell]) {
+					placed |= DIGIT_BIT(b->cells[cell]);
+					continue;
+				}
+				unsigned int cand = cellCandidates(b, cell);
+				more |= once & cand;
+				once |= cand;
+			}
+			if ((once | placed) != ALL_DIGITS_MASK) return false;
+			unsigned int singles = once & ~more & ~placed;
+			while (singles) {
+				unsigned int bit = singles & (0u - singles);
+				singles ^= bit;
+				int target = -1;
+				for (int i = 0; i < GRID_SIZE; i++) {
+					int cell = unitCell(unit, i);
+					if (!b->cells[cell] && (cellCandidates(b, cell) & bit)) { target = cell; break; }
+				}
+				if (target < 0) return false; // the same cell was the only home of two digits
+				placeDigit(b, target, bit);
+				STATS_ADD(stats, propagations, 1);
+				changed = true;
+			}
+		}
+	}
+	return true;
+}
+
+// Stops (returns true) once s->limit solutions have been seen; the first one is kept in s->solution.
+static bool searchMrv(MaskSolver *s, MaskBoard *b) {
+	STATS_CLOCK(propagateStart);
+	bool consistent = propagateSingles(b, s->stats);
+	STATS_ELAPSED(s->stats, propagateSeconds, propagateStart);
+	if (!consistent) return false;
+	if (b->emptyCount == 0) {
+		if (s->found++ == 0) s->solution = *b;
+		return s->found >= s->limit;
+	}
+	int best = -1, bestCount = 10;
+	unsigned int bestCand = 0;
+	for (int cell = 0; cell < CELL_COUNT && bestCount > 2; cell++) {
+		if (b->cells[cell]) continue;
+		unsigned int cand = cellCandidates(b, cell);
+		int n = bitCount(cand);
+		if (n < bestCount) {
+			best = cell;
+			bestCount = n;
+			bestCand = cand;
+		}
+	}
+	while (bestCand) {
+		unsigned int bit = bestCand & (0u - bestCand);
+		bestCand ^= bit;
+		s->nodes++;
+		MaskBoard child = *b;
+		placeDigit(&child, best, bit);
+#if SOLVER_STATS_ENABLED
+		int foundBefore = s->found;
+#endif
+		ENTER_LEVEL(s);
+		bool done = searchMrv(s, &child);
+		LEAVE_LEVEL(s);
+		if (done) return true;
+#if SOLVER_STATS_ENABLED
+		if (s->found == foundBefore) STATS_ADD(s->stats, backtracks, 1);
+#endif
+	}
+	return false;
+}
+
+static void initMaskSolver(MaskSolver *s, int limit, SolverStats *stats) {
+	s->nodes = 0;
+	s->found = 0;
+	s->limit = limit;
+	s->stats = stats;
+	s->depth = 0;
+}
+
+static bool solveWith(Board *board, SolverStrategy strategy, unsigned long long *outNodes, SolverStats *stats) {
+	if (strategy == SOLVER_DLX) {
+		DlxSolver *dlx = getThreadDlx();
+		dlx->stats = stats;
+		bool solved = solveDlx(dlx, board, 1, board, outNodes) == 1;
+		dlx->stats = NULL;
+		return solved;
+	}
+	if (strategy == SOLVER_STEPPED) {
+		StepSolver step;
+		STATS_CLOCK(setupStart);
+		bool loaded = startStepSolver(&step, board);
+		STATS_ELAPSED(stats, setupSeconds, setupStart);
+		step.stats = stats;
+		bool solved = loaded && stepSolver(&step, 0) == STEP_SOLVED;
+		if (outNodes) *outNodes = step.nodes;
+		if (solved) stepSolverBoard(&step, board);
+		return solved;
+	}
+	MaskSolver s;
+	initMaskSolver(&s, 1, stats);
+	if (outNodes) *outNodes = 0;
+	STATS_CLOCK(setupStart);
+	bool loaded = loadMasks(&s.board, board);
+	STATS_ELAPSED(stats, setupSeconds, setupStart);
+	if (!loaded) return false;
+	if (strategy == SOLVER_BACKTRACK) {
+		int n = 0;
+		for (int cell = 0; cell < CELL_COUNT; cell++) {
+			if (!s.board.cells[cell]) s.emptyCells[n++] = (uint8_t)cell;
+		}
+		if (searchBacktrack(&s, 0)) {
+			s.solution = s.board;
+			s.found = 1;
+		}
+	} else {
+		searchMrv(&s, &s.board);
+	}
+	if (outNodes) *outNodes = s.nodes;
+	if (s.found == 0) return false;
+	memcpy(board->cells, s.solution.cells, sizeof(board->cells));
+	return true;
+}
+
+static int countWith(const Board *board, int limit, SolverStats *stats) {
+	MaskSolver s;
+	initMaskSolver(&s, limit > 0 ? limit : 1, stats);
+	STATS_CLOCK(setupStart);
+	bool loaded = loadMasks(&s.board, board);
+	STATS_ELAPSED(stats, setupSeconds, setupStart);
+	if (!loaded) return 0;
+	searchMrv(&s, &s.board);
+	if (stats) stats->nodes = s.nodes;
+	return s.found;
+}
+
+bool solveSudokuWith(Board *board, SolverStrategy strategy, unsigned long long *outNodes) {
+	return solveWith(board, strategy, outNodes, NULL);
+}
+
+int countSolutions(const Board *board, int limit) {
+	return countWith(board, limit, NULL);
+}
+
+// Whatever the phases did not account for was spent searching.
+static void finishStats(SolverStats *stats, double start) {
+	stats->solves = 1;
+#if SOLVER_STATS_ENABLED
+	stats->searchSeconds = monotonicSeconds() - start - stats->setupSeconds - stats->propagateSeconds;
+	if (stats->searchSeconds < 0.0) stats->searchSeconds = 0.0;
+#else
+	(void)start;
+#endif
+}
+
+bool solveSudokuStats(Board *board, SolverStrategy strategy, SolverStats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	double start = SOLVER_STATS_ENABLED ? monotonicSeconds() : 0.0;
+	bool solved = solveWith(board, strategy, &stats->nodes, stats);
+	finishStats(stats, start);
+	return solved;
+}
+
+int countSolutionsStats(const Board *board, int limit, SolverStats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	double start = SOLVER_STATS_ENABLED ? monotonicSeconds() : 0.0;
+	int found = countWith(board, limit, stats);
+	finishStats(stats, start);
+	return found;
+}
+
+void addSolverStats(SolverStats *total, const SolverStats *one) {
+	total->nodes += one->nodes;
+	total->backtracks += one->backtracks;
+	total->propagations += one->propagations;
+	total->solves += one->solves;
+	if (one->maxDepth > total->maxDepth) total->maxDepth = one->maxDepth;
+	total->setupSeconds += one->setupSeconds;
+	total->propagateSeconds += one->propagateSeconds;
+	total->searchSeconds += one->searchSeconds;
+}
+
+size_t formatSolverStats(const SolverStats *stats, char *out, size_t size) {
+	int n;
+	if (!SOLVER_STATS_ENABLED) {
+		n = snprintf(out, size, "%llu nodes", stats->nodes);
+	} else {
+		n = snprintf(out, size, "%llu nodes, %llu backtracks, %llu propagated singles, max depth %d; "
+			"setup %.3f ms, propagation %.3f ms, search %.3f ms",
+			stats->nodes, stats->backtracks, stats->propagations, stats->maxDepth,
+			stats->setupSeconds * 1e3, stats->propagateSeconds * 1e3, stats->searchSeconds * 1e3);
+	}
+	if (n < 0) return 0;
+	return (size_t)n < size ? (size_t)n : size - 1;
+}
+
+bool solveSudoku(Board *board) {
+	return solveSudokuWith(board, defaultStrategy, NULL);
+}
+
+void setSolverStrategy(SolverStrategy strategy) {
+	defaultStrategy = strategy;
+}
+
+SolverStrategy getSolverStrategy(void) {
+	return defaultStrategy;
+}
+
+const char *solverStrategyName(SolverStrategy strategy) {
+	switch (strategy) {
+		case SOLVER_BACKTRACK: return "backtrack";
+		case SOLVER_MRV: return "mrv";
+		case SOLVER_DLX: return "dlx";
+		case SOLVER_STEPPED: return "stepped";
+	}
+	return "unknown";
+}
+
+bool parseSolverStrategy(const char *name, SolverStrategy *out) {
+	if (!name || !out) return false;
+	if (strcmp(name, "backtrack") == 0) { *out = SOLVER_BACKTRACK; return true; }
+	if (strcmp(name, "mrv") == 0) { *out = SOLVER_MRV; return true; }
+	if (strcmp(name, "dlx") == 0) { *out = SOLVER_DLX; return true; }
+	if (strcmp(name, "stepped") == 0) { *out = SOLVER_STEPPED; return true; }
+	return false;
+}
+
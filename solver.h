@@ -1,11 +1,37 @@
-#ifndef SOLVER_H
-#define SOLVER_H
-
-#include <stdbool.h>
-#include "structs.h"
-
-bool solveSudoku(int grid[GRID_SIZE][GRID_SIZE]);
-
-#endif  
-
-
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include "structs.h"
+#include "solver_stats.h"
+
+typedef enum SolverStrategy {
+	SOLVER_BACKTRACK, // first empty cell in row-major order
+	SOLVER_MRV,       // fewest candidates first, after naked/hidden single propagation
+	SOLVER_DLX,       // Dancing Links exact cover over a preallocated per-thread matrix
+	SOLVER_STEPPED    // fewest candidates first on an explicit trail, without recursion (step_solver.h)
+} SolverStrategy;
+
+// Solves in place with the current default strategy.
+bool solveSudoku(Board *board);
+
+// Solves in place with an explicit strategy; outNodes (optional) receives the number of digit trials.
+bool solveSudokuWith(Board *board, SolverStrategy strategy, unsigned long long *outNodes);
+
+// Counts solutions, stopping as soon as limit is reached; countSolutions(board, 2) == 1
+// is the uniqueness check. Returns 0 for unsolvable or contradictory grids.
+int countSolutions(const Board *board, int limit);
+
+// As solveSudokuWith and countSolutions, also filling stats (see solver_stats.h).
+bool solveSudokuStats(Board *board, SolverStrategy strategy, SolverStats *stats);
+int countSolutionsStats(const Board *board, int limit, SolverStats *stats);
+
+void setSolverStrategy(SolverStrategy strategy);
+SolverStrategy getSolverStrategy(void);
+
+const char *solverStrategyName(SolverStrategy strategy);
+bool parseSolverStrategy(const char *name, SolverStrategy *out);
+
+#endif
+
+
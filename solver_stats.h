@@ -0,0 +1,44 @@
+#ifndef SOLVER_STATS_H
+#define SOLVER_STATS_H
+
+#include <stddef.h>
+
+// Search statistics for one solve, or summed over many. nodes is always counted; the
+// rest is recorded only in builds with -DSOLVER_STATS (make STATS=1). Without it the
+// hooks below expand to nothing and the solvers are exactly as fast as before.
+#ifdef SOLVER_STATS
+#define SOLVER_STATS_ENABLED 1
+#else
+#define SOLVER_STATS_ENABLED 0
+#endif
+
+typedef struct SolverStats {
+	unsigned long long nodes;         // digit trials (DLX: rows tried)
+	unsigned long long backtracks;    // trials whose subtree held no solution
+	unsigned long long propagations;  // naked and hidden singles placed by propagation
+	unsigned long long solves;        // solves summed into this
+	int maxDepth;                     // deepest search level, givens not counted
+	double setupSeconds;              // loading the givens
+	double propagateSeconds;          // single propagation
+	double searchSeconds;             // everything else
+} SolverStats;
+
+void addSolverStats(SolverStats *total, const SolverStats *one);
+// One-line summary ("412 nodes, 37 backtracks, ..."); returns its length.
+size_t formatSolverStats(const SolverStats *stats, char *out, size_t size);
+
+// Hooks for the solvers; stats may be NULL when nobody asked for statistics.
+#if SOLVER_STATS_ENABLED
+#include "sys_thread.h" // monotonicSeconds
+#define STATS_ADD(stats, field, n) do { if (stats) (stats)->field += (n); } while (0)
+#define STATS_DEPTH(stats, depth) do { if ((stats) && (depth) > (stats)->maxDepth) (stats)->maxDepth = (depth); } while (0)
+#define STATS_CLOCK(name) double name = monotonicSeconds()
+#define STATS_ELAPSED(stats, field, since) STATS_ADD(stats, field, monotonicSeconds() - (since))
+#else
+#define STATS_ADD(stats, field, n) ((void)(stats))
+#define STATS_DEPTH(stats, depth) ((void)(stats))
+#define STATS_CLOCK(name) ((void)0)
+#define STATS_ELAPSED(stats, field, since) ((void)(stats))
+#endif
+
+#endif
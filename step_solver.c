@@ -0,0 +1,111 @@
+#include <string.h>
+#include "step_solver.h"
+#include "board.h"
+
+bool startStepSolver(StepSolver *s, const Board *board) {
+	s->depth = 0;
+	s->nodes = 0;
+	s->stats = NULL;
+	s->status = loadMasks(&s->board, board) ? STEP_RUNNING : STEP_EXHAUSTED;
+	return s->status == STEP_RUNNING;
+}
+
+// A digit with a single place left in some unit, as the bit to force there; 0 when there
+// is none. *deadEnd is set when a unit has a digit with no place at all.
+static unsigned int hiddenSingle(const MaskBoard *b, int *outCell, bool *deadEnd) {
+	for (int unit = 0; unit < UNIT_COUNT; unit++) {
+		unsigned int once = 0, more = 0, placed = 0;
+		for (int i = 0; i < GRID_SIZE; i++) {
+			int cell = unitCell(unit, i);
+			if (b->cells[cell]) {
+				placed |= DIGIT_BIT(b->cells[cell]);
+				continue;
+			}
+			unsigned int cand = cellCandidates(b, cell);
+			more |= once & cand;
+			once |= cand;
+		}
+		if ((once | placed) != ALL_DIGITS_MASK) {
+			*deadEnd = true;
+			return 0;
+		}
+		unsigned int singles = once & ~more & ~placed;
+		if (!singles) continue;
+		unsigned int bit = singles & (0u - singles);
+		for (int i = 0; i < GRID_SIZE; i++) {
+			int cell = unitCell(unit, i);
+			if (!b->cells[cell] && (cellCandidates(b, cell) & bit)) {
+				*outCell = cell;
+				return bit;
+			}
+		}
+	}
+	return 0;
+}
+
+// The digits to try next and the cell they go in: a naked or hidden single when there is
+// one, else the empty cell with the fewest candidates. 0 when the board is a dead end.
+static unsigned int nextChoice(const MaskBoard *b, int *outCell) {
+	unsigned int bestCand = 0;
+	int bestCount = 10;
+	for (int cell = 0; cell < CELL_COUNT; cell++) {
+		if (b->cells[cell]) continue;
+		unsigned int cand = cellCandidates(b, cell);
+		int n = bitCount(cand);
+		if (n < bestCount) {
+			*outCell = cell;
+			bestCount = n;
+			bestCand = cand;
+			if (n <= 1) return bestCand;
+		}
+	}
+	bool deadEnd = false;
+	unsigned int single = hiddenSingle(b, outCell, &deadEnd);
+	if (deadEnd) return 0;
+	return single ? single : bestCand;
+}
+
+// Between calls every trail entry holds a placed digit, so a paused search resumes by
+// choosing the next cell and a solved one by moving past the digit that completed it.
+StepStatus stepSolver(StepSolver *s, unsigned long long maxNodes) {
+	if (s->status == STEP_EXHAUSTED) return s->status;
+	bool advance = s->status == STEP_SOLVED;
+	s->status = STEP_RUNNING;
+	unsigned long long tried = 0;
+	for (;;) {
+		if (!advance) {
+			if (s->board.emptyCount == 0) return s->status = STEP_SOLVED;
+			if (maxNodes && tried == maxNodes) return s->status;
+			int cell = 0;
+			unsigned int cand = nextChoice(&s->board, &cell);
+			if (cand) {
+				s->trail[s->depth++] = (StepTrailEntry){ (uint8_t)cell, 0, (uint16_t)cand };
+				STATS_DEPTH(s->stats, s->depth);
+			}
+		}
+		// Take back the deepest digit and try the next one there, unwinding exhausted levels.
+		StepTrailEntry *e;
+		for (;;) {
+			if (s->depth == 0) return s->status = STEP_EXHAUSTED;
+			e = &s->trail[s->depth - 1];
+			if (e->digit) {
+				removeDigit(&s->board, e->cell, DIGIT_BIT(e->digit));
+				e->digit = 0;
+				if (!advance) STATS_ADD(s->stats, backtracks, 1);
+			}
+			if (e->untried) break;
+			s->depth--;
+		}
+		unsigned int bit = e->untried & (0u - e->untried);
+		e->untried ^= bit;
+		placeDigit(&s->board, e->cell, bit);
+		e->digit = (uint8_t)(lowestBitIndex(bit) + 1);
+		s->nodes++;
+		tried++;
+		advance = false;
+	}
+}
+
+void stepSolverBoard(const StepSolver *s, Board *out) {
+	memcpy(out->cells, s->board.cells, sizeof(out->cells));
+}
@@ -0,0 +1,49 @@
+#ifndef STEP_SOLVER_H
+#define STEP_SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "structs.h"
+#include "bitmask.h"
+#include "solver_stats.h"
+
+typedef enum StepStatus {
+	STEP_RUNNING,   // paused with nodes left to try
+	STEP_SOLVED,    // board holds a solution; stepping again looks for the next one
+	STEP_EXHAUSTED  // no (further) solution
+} StepStatus;
+
+// One search level: the cell being filled, the digit placed there (0 between trials) and
+// the candidates not tried yet.
+typedef struct StepTrailEntry {
+	uint8_t cell;
+	uint8_t digit;
+	uint16_t untried;
+} StepTrailEntry;
+
+// Backtracking without recursion that fills singles first and otherwise branches on the
+// cell with the fewest candidates. The search path is kept in a
+// fixed trail rather than on the call stack, so a solve needs the same few hundred bytes
+// of stack at any depth and can stop after any number of nodes and carry on later. The
+// whole search state is this struct: copying it takes a snapshot, copying it back
+// restores one.
+typedef struct StepSolver {
+	MaskBoard board;
+	StepTrailEntry trail[CELL_COUNT];
+	int depth;                // trail entries in use
+	StepStatus status;
+	unsigned long long nodes; // digit trials so far
+	SolverStats *stats;       // set by the caller; NULL otherwise
+} StepSolver;
+
+// Loads the givens. Returns false, with status STEP_EXHAUSTED, when they conflict.
+bool startStepSolver(StepSolver *s, const Board *board);
+
+// Searches until a solution is found, the search space is exhausted, or maxNodes more
+// digits have been tried (0 means no limit); returns the new status.
+StepStatus stepSolver(StepSolver *s, unsigned long long maxNodes);
+
+// Copies the board out; complete once the status is STEP_SOLVED.
+void stepSolverBoard(const StepSolver *s, Board *out);
+
+#endif
@@ -1,52 +1,80 @@
-#ifndef STRUCTS_H
-#define STRUCTS_H
-
-#include <stdbool.h>
-#include <stddef.h>
-#include <time.h>
-
-#define GRID_SIZE 9
-
-typedef struct Hint {
-	int triggerCellCount; 
-	char message[256];
-	int hintRow; 
-	int hintCol; 
-	int hintValue; 
-} Hint;
-
-typedef struct Puzzle {
-	char name[64];
-	char difficulty[32];
-	int grid[GRID_SIZE][GRID_SIZE]; 
-	int solution[GRID_SIZE][GRID_SIZE]; 
-	Hint hints[16];
-	size_t numHints;
-} Puzzle;
-
-typedef struct Move {
-	int row;
-	int col;
-	int previousValue;
-	int newValue;
-} Move;
-
-typedef struct GameState {
-	int currentGrid[GRID_SIZE][GRID_SIZE];
-	bool isFixed[GRID_SIZE][GRID_SIZE]; 
-	char activeDifficulty[32];
-	char activePuzzleName[64];
-
-	Move moves[128];
-	size_t moveCount;
-	size_t redoCount; 
-
-	time_t timerStart;
-	unsigned int elapsedSeconds; 
-
-	size_t nextHintIndex;
-} GameState;
-
-#endif 
-
-
+#ifndef STRUCTS_H
+#define STRUCTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "move_history.h"
+
+#define GRID_SIZE 9
+#define CELL_COUNT (GRID_SIZE * GRID_SIZE)
+#define PACKED_BOARD_BYTES ((CELL_COUNT + 1) / 2)
+
+// One byte per cell in row-major order, 0 for empty. 81 bytes, so copying a board is one memcpy.
+// Candidate masks are deliberately not stored alongside: each user keeps the kind its
+// updates need, per-unit masks for the game (tallyCandidates in board.h) and the solvers
+// (MaskBoard in bitmask.h), and per-cell masks that only ever narrow for the grader.
+typedef struct Board {
+	uint8_t cells[CELL_COUNT];
+} Board;
+
+// Two cells per byte (low nibble first) for bulk storage: 41 bytes.
+typedef struct PackedBoard {
+	uint8_t bytes[PACKED_BOARD_BYTES];
+} PackedBoard;
+
+// Incremental summary of a board, kept up to date cell by cell (see tallyChange in board.h)
+// so move checks, candidates and completion never rescan the grid.
+typedef struct BoardTally {
+	uint16_t used[3 * GRID_SIZE];              // digits present per unit: rows, columns, boxes
+	uint8_t counts[3 * GRID_SIZE][GRID_SIZE];  // how often each digit appears per unit
+	int emptyCount;
+	int conflicts;                             // extra copies of a digit within a unit, summed
+} BoardTally;
+
+typedef struct Hint {
+	int triggerCellCount; 
+	char message[256];
+	int hintRow; 
+	int hintCol; 
+	int hintValue; 
+} Hint;
+
+// How many solutions a puzzle is known to have, so whoever counted them already can say
+// so instead of the game counting again.
+typedef enum SolutionCount {
+	SOLUTIONS_UNKNOWN = 0,
+	SOLUTIONS_NONE,
+	SOLUTIONS_UNIQUE,
+	SOLUTIONS_SEVERAL
+} SolutionCount;
+
+typedef struct Puzzle {
+	char name[64];
+	char difficulty[32];
+	Board grid; 
+	Board solution; 
+	Hint hints[16];
+	size_t numHints;
+	SolutionCount solutionCount;
+} Puzzle;
+
+typedef struct GameState {
+	Board currentGrid;
+	BoardTally tally;       // follows currentGrid through playMove, undoMove and redoMove
+	bool isFixed[GRID_SIZE][GRID_SIZE]; 
+	char activeDifficulty[32];
+	char activePuzzleName[64];
+
+	MoveHistory history;
+
+	time_t timerStart;
+	unsigned int elapsedSeconds; 
+
+	size_t nextHintIndex;
+} GameState;
+
+#endif 
+
+
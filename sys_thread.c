@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#include "sys_thread.h"
+
+typedef struct ThreadStart {
+	SysThreadFn fn;
+	void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI threadTrampoline(LPVOID param) {
+#else
+static void *threadTrampoline(void *param) {
+#endif
+	ThreadStart start = *(ThreadStart*)param;
+	free(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+bool startThread(SysThread *thread, SysThreadFn fn, void *arg) {
+	ThreadStart *start = (ThreadStart*)malloc(sizeof(*start));
+	if (!start) return false;
+	start->fn = fn;
+	start->arg = arg;
+#ifdef _WIN32
+	*thread = CreateThread(NULL, 0, threadTrampoline, start, 0, NULL);
+	if (*thread == NULL) { free(start); return false; }
+#else
+	if (pthread_create(thread, NULL, threadTrampoline, start) != 0) { free(start); return false; }
+#endif
+	return true;
+}
+
+void joinThread(SysThread thread) {
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+#ifdef _WIN32
+void initMutex(SysMutex *mutex) { InitializeCriticalSection(mutex); }
+void destroyMutex(SysMutex *mutex) { DeleteCriticalSection(mutex); }
+void lockMutex(SysMutex *mutex) { EnterCriticalSection(mutex); }
+void unlockMutex(SysMutex *mutex) { LeaveCriticalSection(mutex); }
+
+void initCond(SysCond *cond) { InitializeConditionVariable(cond); }
+void destroyCond(SysCond *cond) { (void)cond; }
+void waitCond(SysCond *cond, SysMutex *mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+void signalCond(SysCond *cond) { WakeConditionVariable(cond); }
+void broadcastCond(SysCond *cond) { WakeAllConditionVariable(cond); }
+#else
+void initMutex(SysMutex *mutex) { pthread_mutex_init(mutex, NULL); }
+void destroyMutex(SysMutex *mutex) { pthread_mutex_destroy(mutex); }
+void lockMutex(SysMutex *mutex) { pthread_mutex_lock(mutex); }
+void unlockMutex(SysMutex *mutex) { pthread_mutex_unlock(mutex); }
+
+void initCond(SysCond *cond) { pthread_cond_init(cond, NULL); }
+void destroyCond(SysCond *cond) { pthread_cond_destroy(cond); }
+void waitCond(SysCond *cond, SysMutex *mutex) { pthread_cond_wait(cond, mutex); }
+void signalCond(SysCond *cond) { pthread_cond_signal(cond); }
+void broadcastCond(SysCond *cond) { pthread_cond_broadcast(cond); }
+#endif
+
+int getCpuCount(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+double monotonicSeconds(void) {
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef SYS_THREAD_H
+#define SYS_THREAD_H
+
+#include <stdbool.h>
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE SysThread;
+typedef CRITICAL_SECTION SysMutex;
+typedef CONDITION_VARIABLE SysCond;
+#else
+#include <pthread.h>
+typedef pthread_t SysThread;
+typedef pthread_mutex_t SysMutex;
+typedef pthread_cond_t SysCond;
+#endif
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+typedef void (*SysThreadFn)(void *arg);
+
+bool startThread(SysThread *thread, SysThreadFn fn, void *arg);
+void joinThread(SysThread thread);
+
+void initMutex(SysMutex *mutex);
+void destroyMutex(SysMutex *mutex);
+void lockMutex(SysMutex *mutex);
+void unlockMutex(SysMutex *mutex);
+
+void initCond(SysCond *cond);
+void destroyCond(SysCond *cond);
+void waitCond(SysCond *cond, SysMutex *mutex);
+void signalCond(SysCond *cond);
+void broadcastCond(SysCond *cond);
+
+int getCpuCount(void);
+
+// Seconds from an arbitrary fixed point; only differences are meaningful.
+double monotonicSeconds(void);
+
+#endif
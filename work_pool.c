@@ -0,0 +1,155 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "work_pool.h"
+#include "sys_thread.h"
+
+// Items are pushed at the back and taken from the front by the owner and by thieves
+// alike: the oldest item is always the next one a caller is waiting on, so stealing
+// it first keeps in-order consumers moving.
+typedef struct WorkDeque {
+	SysMutex lock;
+	void **items;
+	int capacity;
+	int head;
+	int count;
+} WorkDeque;
+
+typedef struct Worker {
+	WorkPool *pool;
+	int index;
+	SysThread thread;
+} Worker;
+
+struct WorkPool {
+	int threadCount;
+	int dequeCount;
+	Worker *workers;
+	WorkDeque *deques;
+	WorkFn fn;
+	void *context;
+	int nextDeque;
+	atomic_int pending;
+	bool stopping;
+	SysMutex idleLock;
+	SysCond idleCond;
+};
+
+static bool pushBack(WorkDeque *d, void *item) {
+	lockMutex(&d->lock);
+	bool ok = d->count < d->capacity;
+	if (ok) {
+		d->items[(d->head + d->count) % d->capacity] = item;
+		d->count++;
+	}
+	unlockMutex(&d->lock);
+	return ok;
+}
+
+static void *takeFront(WorkDeque *d) {
+	void *item = NULL;
+	lockMutex(&d->lock);
+	if (d->count > 0) {
+		item = d->items[d->head];
+		d->head = (d->head + 1) % d->capacity;
+		d->count--;
+	}
+	unlockMutex(&d->lock);
+	return item;
+}
+
+static void *findWork(WorkPool *pool, int self) {
+	for (int k = 0; k < pool->threadCount; k++) {
+		void *item = takeFront(&pool->deques[(self + k) % pool->threadCount]);
+		if (item) {
+			atomic_fetch_sub(&pool->pending, 1);
+			return item;
+		}
+	}
+	return NULL;
+}
+
+static void workerMain(void *arg) {
+	Worker *worker = (Worker*)arg;
+	WorkPool *pool = worker->pool;
+	for (;;) {
+		void *item = findWork(pool, worker->index);
+		if (item) {
+			pool->fn(item, pool->context);
+			continue;
+		}
+		lockMutex(&pool->idleLock);
+		while (atomic_load(&pool->pending) == 0 && !pool->stopping) {
+			waitCond(&pool->idleCond, &pool->idleLock);
+		}
+		bool finished = atomic_load(&pool->pending) == 0 && pool->stopping;
+		unlockMutex(&pool->idleLock);
+		if (finished) return;
+	}
+}
+
+WorkPool *createWorkPool(int threadCount, int dequeCapacity, WorkFn fn, void *context) {
+	if (threadCount < 1 || dequeCapacity < 1) return NULL;
+	WorkPool *pool = (WorkPool*)calloc(1, sizeof(*pool));
+	if (!pool) return NULL;
+	pool->workers = (Worker*)calloc((size_t)threadCount, sizeof(Worker));
+	pool->deques = (WorkDeque*)calloc((size_t)threadCount, sizeof(WorkDeque));
+	if (!pool->workers || !pool->deques) {
+		free(pool->workers);
+		free(pool->deques);
+		free(pool);
+		return NULL;
+	}
+	pool->dequeCount = threadCount;
+	pool->fn = fn;
+	pool->context = context;
+	atomic_init(&pool->pending, 0);
+	initMutex(&pool->idleLock);
+	initCond(&pool->idleCond);
+	for (int i = 0; i < threadCount; i++) {
+		WorkDeque *d = &pool->deques[i];
+		initMutex(&d->lock);
+		d->capacity = dequeCapacity;
+		d->items = (void**)malloc(sizeof(void*) * (size_t)dequeCapacity);
+	}
+	for (int i = 0; i < threadCount; i++) {
+		Worker *w = &pool->workers[i];
+		w->pool = pool;
+		w->index = i;
+		if (!pool->deques[i].items || !startThread(&w->thread, workerMain, w)) break;
+		pool->threadCount++;
+	}
+	if (pool->threadCount == 0) {
+		destroyWorkPool(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+bool submitWork(WorkPool *pool, void *item) {
+	int target = pool->nextDeque;
+	pool->nextDeque = (pool->nextDeque + 1) % pool->threadCount;
+	if (!pushBack(&pool->deques[target], item)) return false;
+	atomic_fetch_add(&pool->pending, 1);
+	lockMutex(&pool->idleLock);
+	signalCond(&pool->idleCond);
+	unlockMutex(&pool->idleLock);
+	return true;
+}
+
+void destroyWorkPool(WorkPool *pool) {
+	if (!pool) return;
+	lockMutex(&pool->idleLock);
+	pool->stopping = true;
+	broadcastCond(&pool->idleCond);
+	unlockMutex(&pool->idleLock);
+	for (int i = 0; i < pool->threadCount; i++) joinThread(pool->workers[i].thread);
+	for (int i = 0; i < pool->dequeCount; i++) {
+		destroyMutex(&pool->deques[i].lock);
+		free(pool->deques[i].items);
+	}
+	free(pool->workers);
+	free(pool->deques);
+	destroyCond(&pool->idleCond);
+	destroyMutex(&pool->idleLock);
+	free(pool);
+}
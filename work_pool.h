@@ -0,0 +1,20 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <stdbool.h>
+
+typedef void (*WorkFn)(void *item, void *context);
+
+typedef struct WorkPool WorkPool;
+
+// Starts threadCount workers, each owning a deque of up to dequeCapacity items.
+// Idle workers steal from the other deques, so uneven items still balance.
+WorkPool *createWorkPool(int threadCount, int dequeCapacity, WorkFn fn, void *context);
+
+// Queues an item on the next worker's deque (round-robin). Returns false if that deque is full.
+bool submitWork(WorkPool *pool, void *item);
+
+// Lets the workers drain every queued item, then joins them and frees the pool.
+void destroyWorkPool(WorkPool *pool);
+
+#endif